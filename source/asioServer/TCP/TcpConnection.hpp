@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <json.hpp>
@@ -33,12 +34,17 @@ public:
 
 	void writeFile(const std::string&);
 
+	/// Writes queued on the socket that haven't completed yet. Lets streaming callers skip a slow peer instead of queueing without bound.
+	uint32_t pendingWrites() const;
+
 private: // Member Variables
 	boost::asio::ip::tcp::socket socket_;
 	boost::asio::strand<boost::asio::any_io_executor> strand_;
 	TcpServer* owner_;
 	uint32_t id_;
 	bool alive_{true};
+	std::atomic<uint32_t> pendingWrites_{0};
+	boost::asio::streambuf readBuffer_; // Kept between reads, a client may send several lines at once
 };
 
 //clang-format off
@@ -47,12 +53,10 @@ void TcpConnection::read(std::function<void(const Rx&)> handler) {
 	if (!alive_)
 		return;
 
-	auto buffer = std::make_shared<boost::asio::streambuf>();
-
-    boost::asio::async_read_until(socket_, *buffer, '\n',
+    boost::asio::async_read_until(socket_, readBuffer_, '\n',
     	boost::asio::bind_executor(
     		strand_,
-    		[this, buffer, handler = std::move(handler)](const boost::system::error_code& ec, size_t bytes) {
+    		[this, handler = std::move(handler)](const boost::system::error_code& ec, size_t bytes) {
          	if (!alive_)
          		return;
 
@@ -67,14 +71,13 @@ void TcpConnection::read(std::function<void(const Rx&)> handler) {
              	return;
     		}
          	try {
-         		std::istream is(buffer.get());
-				std::string data;
-				std::getline(is, data);
+         		// Only this line, whatever came after it stays in readBuffer_ for the next read
+         		const auto begin = boost::asio::buffers_begin(readBuffer_.data());
+				std::string data(begin, begin + static_cast<std::ptrdiff_t>(bytes) - 1);
+         		readBuffer_.consume(bytes);
 
          		if constexpr (std::is_same_v<Rx, std::string>)
 			 		handler(data);
-
-         		buffer->consume(bytes);
          	} catch (const std::exception& e) {
              	DEBUG_OUT("Read Error: " + std::string(e.what()));
          	}
@@ -96,14 +99,20 @@ void TcpConnection::write(const Tx& data) {
 	bytes->append(data);
 	bytes->push_back('\n');
 
+	++pendingWrites_;
 	boost::asio::async_write(socket_, boost::asio::buffer(*bytes),
 							 boost::asio::bind_executor(
 														strand_, [this, bytes](const boost::system::error_code& ec, std::size_t) {
+															--pendingWrites_;
 															if (ec)
 																close();
 														}));
 }
 
+inline uint32_t TcpConnection::pendingWrites() const {
+	return pendingWrites_.load(std::memory_order_relaxed);
+}
+
 inline void TcpConnection::writeFile(const std::string& path)
 {
 	if (!alive_)
@@ -134,6 +143,7 @@ inline void TcpConnection::writeFile(const std::string& path)
 	header->reserve(64 + filename.size());
 	*header = "type:file%%%" + filename + "%%%" + std::to_string(size) + "\n";
 
+	++pendingWrites_;
 	asio::async_write(
 		socket_,
 		asio::buffer(*header),
@@ -142,6 +152,7 @@ inline void TcpConnection::writeFile(const std::string& path)
 			[this, header, data](const boost::system::error_code& ec, std::size_t)
 			{
 				if (ec) {
+					--pendingWrites_;
 					close();
 					return;
 				}
@@ -154,6 +165,7 @@ inline void TcpConnection::writeFile(const std::string& path)
 						strand_,
 						[this, data](const boost::system::error_code& ec, std::size_t)
 						{
+							--pendingWrites_;
 							if (ec)
 								close();
 						}
@@ -73,6 +73,10 @@ void TcpServer::removeConnection(const uint32_t id) {
 	}
 }
 
+boost::asio::io_context& TcpServer::getContext() {
+	return io_context_;
+}
+
 void TcpServer::acceptConnection() {
 	if (!running_ || !acceptor_.is_open())
 		return;
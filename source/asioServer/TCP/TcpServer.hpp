@@ -23,6 +23,9 @@ public:
 	static void setThreadCount(uint8_t count);
 	void removeConnection(uint32_t id);
 
+	/// The io_context the server's connections run on. Used to post work and timers onto the same threads.
+	boost::asio::io_context& getContext();
+
 private: /// Member Functions
 	void acceptConnection();
 
@@ -0,0 +1,76 @@
+import socket
+import sys
+import time
+
+# Emulates a door client with a reed switch and plays the cases the server should flag.
+# Usage: python doorEventTester.py <ip> <door> <uid> <cli name> [held]
+# uid must be approved at door. With "held" the door is also left open past the held-open limit, which takes 31 seconds.
+# Prints getDoorAlerts afterwards, expect one tailgating and one forced alert (and one held_open).
+
+ip = sys.argv[1] if len(sys.argv) > 1 else input("Input ip: ").strip()
+door = sys.argv[2] if len(sys.argv) > 2 else "maindoor"
+uid = sys.argv[3] if len(sys.argv) > 3 else "6a13ba66"
+cli_name = sys.argv[4] if len(sys.argv) > 4 else input("Input cli name: ").strip()
+held = len(sys.argv) > 5 and sys.argv[5] == "held"
+
+s = socket.create_connection((ip, 9000))
+f = s.makefile("rb")
+
+
+def scan():
+    s.sendall(f"{door}:{uid}\n".encode())
+    return f.readline().decode().strip().replace("type:string%%%", "")
+
+
+def reed(state, seconds_after):
+    s.sendall(f"{door}:@{state}:{int(time.time() * 1000)}\n".encode())
+    time.sleep(seconds_after)
+
+
+print("approved, one opening:", scan())
+reed("open", 1)
+reed("closed", 1)
+
+print("approved, opened twice:", scan())
+reed("open", 0.5)
+reed("closed", 0.5)
+reed("open", 0.5)  # tailgating
+reed("closed", 0.5)
+
+print("opened without a scan")
+time.sleep(11)  # Let the last approval fall out of the window
+reed("open", 0.5)  # forced
+reed("closed", 0.5)
+
+if held:
+    print("approved, held open:", scan())
+    reed("open", 31)
+    reed("closed", 0.5)
+
+s.close()
+time.sleep(0.5)
+
+
+def cli_command(cmd):
+    c = socket.create_connection((ip, 9001))
+    c.settimeout(1)
+    cf = c.makefile("rb")
+    cf.readline()  # Input CLI Identification
+    c.sendall(f"{cli_name}\n".encode())
+    cf.readline()  # CLI is ready
+    c.sendall(f"{cmd}\n".encode())
+    out = b""
+    try:
+        while True:
+            chunk = c.recv(4096)
+            if not chunk:
+                break
+            out += chunk
+    except socket.timeout:
+        pass
+    c.sendall(b"exit\n")
+    c.close()
+    return out.decode().replace("type:string%%%", "")
+
+
+print(cli_command("getDoorAlerts"))
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ConfigSnapshot.hpp"
+#include "UserTable.hpp"
+
+/// Allow/deny rules between user groups and door zones, e.g. "allow contractors zone_b".\n
+/// publish() compiles the rule list into a dense group×zone matrix of two bit cells, so a decision is the group of the user
+/// and the zone of the door indexing one cell, no matter how many rules exist. Deny wins over allow, and a cell without
+/// any rule falls back to the level check.\n
+/// Not thread-safe, ReaderHandler guards it with rw_mtx like the tables it is compiled against.
+class AccessPolicy {
+public:
+	enum class Effect : uint8_t {
+		none,  // No rule, the levels decide
+		allow,
+		deny
+	};
+
+	struct Rule {
+		Effect effect;
+		std::string group; // "*" for every group, users without one included
+		std::string zone;  // "*" for every zone, doors without one included
+
+		bool operator==(const Rule&) const = default;
+	};
+
+	static const char* name(Effect effect);
+	static std::string format(const Rule& rule);
+
+	/// Replaces the rules with the "rules" array of config.json. Invalid entries are skipped.
+	void load(const std::string& json);
+	/// "rules" array for config.json, "[]" if there are none.
+	std::string json() const;
+
+	/// @returns false if the same rule exists.
+	bool add(const Rule& rule);
+	/// Removes allow and deny rules for exactly this group and zone.
+	/// @returns number of rules removed.
+	size_t remove(const std::string& group, const std::string& zone);
+	size_t size() const { return rules_.size(); }
+	/// One rule per line in the order they were added.
+	std::string describe() const;
+
+	/// Compiles the rules against the groups of users and the zones of doors, and points each door at its zone column.\n
+	/// Zone IDs are handed out in order of first use and kept while running, so other tables may index by them.\n
+	/// Call after loading and after any change to rules, user groups or door zones.
+	void publish(const UserTable& users, ConfigSnapshot::Doors& doors);
+
+	/// @returns 0 for unknown zones and zones no door was in at the last publish.
+	uint16_t findZone(std::string_view zone) const;
+	/// Empty for 0, the ID of doors without a zone.
+	const std::string& zoneName(const uint16_t zone) const { return zones_[zone]; }
+	/// Number of zone IDs including 0, IDs run from 0 to zoneCount() - 1.
+	size_t zoneCount() const { return zones_.size(); }
+
+	/// @param group UserTable::group() of the user.
+	/// @param zone ConfigSnapshot::Door::zoneId of the door.
+	Effect decide(const UserTable::Group group, const uint16_t zone) const {
+		if (group >= rows_ || zone >= columns_)
+			return Effect::none; // Group created after the last publish
+		const size_t cell = group * columns_ + zone;
+		return static_cast<Effect>(matrix_[cell / 32] >> (cell % 32 * 2) & 3);
+	}
+
+	/// Every rule that applies to the group and zone, in order, and the effect they compile to.
+	std::string explain(std::string_view group, std::string_view zone) const;
+
+private:
+	static bool matches(const std::string& pattern, std::string_view name) { return pattern == "*" || pattern == name; }
+
+	std::vector<Rule> rules_;
+	std::vector<std::string> zones_{""}; // Zone names by ID, never shrinks while running
+	std::unordered_map<std::string, uint16_t> zoneIds_;
+	std::vector<uint64_t> matrix_; // Two bits per cell holding an Effect, rows are groups, columns zones
+	size_t rows_    = 0;
+	size_t columns_ = 0;
+};
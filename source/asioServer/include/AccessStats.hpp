@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/// Per-door and per-user decision counters bucketed per hour.\n
+/// The decision path only touches counters owned by its own thread, so recording is a relaxed atomic add.
+/// Readers merge every thread's shard on demand, and a background thread checkpoints the merged view to disk.
+class AccessStats {
+public:
+	enum Outcome : uint8_t {
+		approved_,
+		denied_,
+		unknown_
+	};
+
+	struct Totals {
+		uint64_t approved{};
+		uint64_t denied{};
+		uint64_t unknown{};
+	};
+
+	struct Report {
+		std::map<std::string, Totals> doors;
+		std::map<std::string, Totals> users;
+	};
+
+	explicit AccessStats(std::string checkpointPath = "stats.json",
+						 std::chrono::seconds checkpointInterval = std::chrono::seconds(60));
+	~AccessStats();
+
+	void record(const std::string& door, const std::string& user, Outcome outcome) const;
+
+	/// Sums the last @p hours hourly buckets, or the lifetime totals if hours is 0.
+	Report merge(uint32_t hours = 0) const;
+	static std::string format(const Report& report);
+
+	void checkpoint() const;
+
+	static constexpr uint32_t bucketCount_ = 24 * 7; // One week of hourly buckets
+
+private: // Member Functions
+	struct Shard;
+	Shard& localShard() const;
+	void restore();
+	void worker();
+
+	static int64_t currentHour();
+
+private: // Member Variables
+	struct Bucket {
+		std::atomic<int64_t> hour{-1};
+		std::array<std::atomic<uint64_t>, 3> count{};
+	};
+
+	struct Counters {
+		std::array<Bucket, bucketCount_> buckets;
+		std::array<std::atomic<uint64_t>, 3> total{};
+
+		void add(int64_t hour, Outcome outcome);
+	};
+
+	/// Only the owning thread inserts, and it holds mtx while doing so. Readers hold mtx while merging.
+	struct Shard {
+		std::mutex mtx;
+		std::unordered_map<std::string, std::unique_ptr<Counters>> doors;
+		std::unordered_map<std::string, std::unique_ptr<Counters>> users;
+
+		Counters& find(std::unordered_map<std::string, std::unique_ptr<Counters>>& map, const std::string& key);
+	};
+
+	const std::string checkpointPath_;
+	const std::chrono::seconds checkpointInterval_;
+
+	mutable std::mutex shardsMtx_;
+	mutable std::vector<std::unique_ptr<Shard>> shards_;
+
+	std::mutex stopMtx_;
+	std::condition_variable stopCv_;
+	bool stopping_ = false;
+	std::thread worker_;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ConfigSnapshot.hpp"
+
+/// Streaming reader and writer for config.json.\n
+/// Loading goes through the nlohmann SAX interface, so users and doors are validated and inserted as they are parsed and no DOM of the file is ever built.
+/// Saving writes the tables straight from memory.
+class ConfigFile {
+public:
+	enum class Result {
+		loaded,  /// tables filled, invalid entries skipped
+		missing, /// no config.json or an empty one, tables untouched
+		invalid  /// not valid JSON, tables cleared
+	};
+
+	/// @param revoked receives the "revoked" array of card UIDs.
+	/// @param logs receives the "logs" object as JSON text, "{}" if there is none.
+	/// @param schedules receives the "schedules" object as JSON text, "{}" if there is none.
+	/// @param rules receives the "rules" array as JSON text, "[]" if there is none.
+	static Result load(const std::string& path, ConfigSnapshot::Doors& doors, UserTable& users, std::vector<std::string>& revoked,
+					   std::string& logs, std::string& schedules, std::string& rules);
+
+	/// Writes the tables in the same layout json::dump(4) uses, sorted by name so edits give small diffs.\n
+	/// Goes through a temporary file and rename for safer patch appliance.
+	/// @returns false if the file could not be written, the previous config.json is kept in that case.
+	static bool save(const std::string& path, const ConfigSnapshot::Doors& doors, const UserTable& users,
+					 const std::vector<std::string>& revoked, const std::string& logs, const std::string& schedules,
+					 const std::string& rules);
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+/// Append-only log of small config changes (card added, card revoked) that haven't been folded into config.json yet.\n
+/// Each change is one line, written and synced before the CLI gets its answer. The journal is replayed on top of
+/// config.json/config.bin at startup and cleared whenever config.json is rewritten, so replayed entries must be idempotent.
+class ConfigJournal {
+public:
+	explicit ConfigJournal(std::string path);
+
+	/// Appends one line and syncs it to disk.
+	/// @returns false if the line could not be written.
+	bool append(const std::string& line) const;
+
+	/// Calls apply for every complete line. A torn last line from a crash mid-append is ignored.
+	/// @returns number of lines replayed.
+	size_t replay(const std::function<void(const std::string&)>& apply) const;
+
+	/// Truncates the journal, call after its entries are in config.json.
+	void clear() const;
+
+private:
+	std::string path_;
+};
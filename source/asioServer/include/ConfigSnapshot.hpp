@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "UserTable.hpp"
+
+/// Binary copy of the access tables in config.json, so a restart doesn't have to parse JSON.\n
+/// Layout: Header | DoorRecord[doorCount] | UserRecord[userCount] | CardRecord[cardCount] | StringRecord[revokedCount] |
+/// StringRecord[groupCount] | string pool.\n
+/// Records are fixed size and point into the pool by offset/length, so the file is loaded with one mmap and one pass.\n
+/// config.json stays the editable format. The snapshot remembers the size and mtime of the config.json it was built from and is ignored once they differ.
+class ConfigSnapshot {
+public:
+	struct Door {
+		/// Anti-passback role of a door in a zone: entering it, leaving it, or neither.
+		enum class Direction : uint8_t { none, entry, exit };
+
+		int lvl{};
+		std::string schedule{};     // Empty for a door open at any time
+		std::string zone{};         // Empty for a door outside every zone
+		Direction direction{};
+		uint32_t slot = UINT32_MAX; // Compiled schedule, set by ScheduleTable::bind
+		uint16_t zoneId = 0;        // Compiled zone, set by AccessPolicy::publish
+	};
+	using Doors = std::unordered_map<std::string, Door>;
+
+	static constexpr uint32_t version_ = 6;
+
+	/// Fills the tables from the snapshot at path.\n
+	/// Leaves the tables untouched and returns false if the file is missing, corrupt, of another version or older than source.
+	/// @param logs receives the "logs" object of config.json as JSON text.
+	/// @param schedules receives the "schedules" object of config.json as JSON text.
+	/// @param rules receives the "rules" array of config.json as JSON text.
+	static bool load(const std::string& path, const std::string& source, Doors& doors, UserTable& users,
+					 std::vector<std::string>& revoked, std::string& logs, std::string& schedules, std::string& rules);
+
+	/// Writes the tables to path through a temporary file and rename, like config.json.
+	static bool save(const std::string& path, const std::string& source, const Doors& doors, const UserTable& users,
+					 const std::vector<std::string>& revoked, const std::string& logs, const std::string& schedules,
+					 const std::string& rules);
+
+private:
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t doorCount;
+		uint32_t userCount;
+		uint32_t cardCount;
+		uint32_t revokedCount;
+		uint32_t groupCount; // Group names by ID, including the empty name of UserTable::noGroup_
+		uint32_t reserved;
+		uint64_t poolBytes;
+		uint64_t sourceSize;
+		int64_t sourceMtime;
+		uint32_t logsOffset;
+		uint32_t logsLength;
+		uint32_t schedulesOffset;
+		uint32_t schedulesLength;
+		uint32_t rulesOffset;
+		uint32_t rulesLength;
+		uint64_t checksum; // FNV-1a over everything after the header
+	};
+
+	struct DoorRecord {
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		int32_t lvl;
+		uint32_t scheduleLength; // 0 for no schedule
+		uint32_t scheduleOffset;
+		uint32_t zoneOffset;
+		uint32_t zoneLength; // 0 for no zone
+		uint32_t direction;
+	};
+
+	struct UserRecord {
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		int32_t lvl;
+		uint32_t group;   // Index into the group name array
+		uint32_t expires; // Unix time, 0 for a permanent user
+		uint32_t reserved;
+	};
+
+	struct CardRecord {
+		uint32_t uidOffset;
+		uint32_t uidLength;
+		uint32_t owner; // Index into the UserRecord array
+		uint32_t reserved;
+	};
+
+	struct StringRecord {
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	static_assert(sizeof(Header) % 8 == 0 && sizeof(DoorRecord) % 8 == 0 && sizeof(UserRecord) % 8 == 0 &&
+				  sizeof(CardRecord) % 8 == 0 && sizeof(StringRecord) % 8 == 0);
+
+	static bool sourceStamp(const std::string& source, uint64_t& size, int64_t& mtime);
+	static uint64_t checksum(const char* data, size_t size);
+};
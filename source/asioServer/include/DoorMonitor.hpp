@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Correlates the reed-switch events of each door with the approvals before them.\n
+/// Every approval lets the door open once within window_. An opening that finds no approval is tailgating if the door
+/// was approved within the window and forced otherwise, and a door open for longer than heldOpen_ is held open.\n
+/// Times are server milliseconds from EventRing, except the open duration reported at close, which uses the door client's
+/// own timestamps when both ends have one, so network delays don't count towards it.\n
+/// Not thread-safe, ReaderHandler only feeds it from the CLI io_context.
+class DoorMonitor {
+public:
+	enum class Kind : uint8_t {
+		heldOpen,
+		tailgating, // Opened more often than it was approved
+		forced      // Opened without any recent approval
+	};
+
+	struct Alert {
+		int64_t timeMs;
+		std::string door;
+		Kind kind;
+		int64_t detailMs; // heldOpen: time open, tailgating: time since the approval, forced: 0
+	};
+
+	static constexpr int64_t window_   = 10'000; // Door clients lock again 10 seconds after an approval
+	static constexpr int64_t heldOpen_ = 30'000;
+
+	static const char* name(Kind kind);
+	static std::string format(const Alert& alert);
+
+	void approved(const std::string& door, int64_t timeMs);
+	/// @param sourceMs door client clock, 0 if unknown.
+	void opened(const std::string& door, int64_t timeMs, int64_t sourceMs);
+	void closed(const std::string& door, int64_t timeMs, int64_t sourceMs);
+	/// Approvals before timeMs were lost, e.g. lapped in EventRing. Openings without an approval within window_ of it raise nothing.
+	void lost(int64_t timeMs);
+	/// Raises heldOpen for doors still open past heldOpen_.
+	void sweep(int64_t nowMs);
+
+	bool anyOpen() const { return open_ > 0; }
+	/// Drops the state of a door that was removed or renamed.
+	void forget(const std::string& door);
+
+	/// Alerts raised since the last call, oldest first. They stay in the history for describe().
+	std::vector<Alert> takeRaised();
+	/// State and counts per door, then the most recent alerts.
+	std::string describe() const;
+
+private:
+	struct Door {
+		std::deque<int64_t> approvals; // Not yet used by an opening, oldest first
+		int64_t lastApproval   = 0;
+		bool open              = false;
+		bool heldReported      = false;
+		int64_t openedAt       = 0;
+		int64_t openedAtSource = 0;
+		uint64_t openings      = 0;
+		uint64_t alerts[3]{}; // By Kind
+	};
+
+	void raise(const std::string& door, Door& state, int64_t timeMs, Kind kind, int64_t detailMs);
+
+	static constexpr size_t historySize_ = 64;
+
+	std::unordered_map<std::string, Door> doors_;
+	std::deque<Alert> history_;
+	std::vector<Alert> raised_;
+	size_t open_    = 0;
+	int64_t lostAt_ = 0; // Last time approvals were lost, 0 if never
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Signed per-door access snapshots for the offline cache of the door clients, the format is in common/DoorSnapshot.h.\n
+/// Clients ask with "door:@sync:<version>" when they connect and every 30 seconds. They get a delta against their version
+/// if it is one of the last history_ versions sent for the door, and the full list otherwise.\n
+/// Disabled without a door.key, clients then get no answer and show an error offline as before. Thread-safe.
+class DoorSync {
+public:
+	explicit DoorSync(const std::string& keyPath);
+
+	bool enabled() const { return !key_.empty(); }
+
+	/// @param entries the door's snapshot, sorted.
+	/// @param have version the client holds, "0" for none.
+	/// @returns the signed "@sync:..." payload.
+	std::string reply(const std::string& door, std::vector<std::string> entries, const std::string& have);
+
+	/// Forgets the versions of a removed or renamed door.
+	void forget(const std::string& door);
+
+private:
+	static constexpr size_t history_ = 2;
+
+	struct Version {
+		std::string version;
+		std::vector<std::string> entries;
+	};
+
+	/// "-uid" for every entry only in from and "+entry" for every entry only in to, both sorted.
+	static std::string delta(const std::vector<std::string>& from, const std::vector<std::string>& to);
+
+	std::string key_;
+	std::mutex mtx_;
+	std::unordered_map<std::string, std::deque<Version>> recent_;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Fixed-size lock-free ring of the most recent decision and door events.\n
+/// Producers never wait: each push takes a ticket and overwrites the oldest slot.
+/// Readers keep their own cursor and detect overwritten slots through a per-slot sequence number.
+class EventRing {
+public:
+	struct Event {
+		int64_t timeMs{};   // system_clock, ms since epoch
+		int64_t sourceMs{}; // Door client clock for door events, 0 for decisions
+		char door[32]{};
+		char name[32]{};
+		char uid[24]{};
+		char access[20]{}; // Fits "offline_approved"
+	};
+
+	/// @param capacity rounded up to a power of two.
+	explicit EventRing(size_t capacity);
+
+	void push(const std::string& door, const std::string& name, const std::string& uid, const std::string& access, int64_t sourceMs = 0);
+
+	/// Ticket of the next event to be pushed. A new subscriber starts here.
+	uint64_t head() const;
+
+	/// Copies events from cursor onwards into out and advances cursor.\n
+	/// Events overwritten before they were read are skipped and counted in the return value.
+	/// @returns number of events dropped for this cursor.
+	uint64_t read(uint64_t& cursor, std::vector<Event>& out, size_t max) const;
+
+	static std::string format(const Event& event);
+
+private:
+	struct Slot {
+		std::atomic<uint64_t> seq{0}; // (ticket + 1) * 2 when complete, odd while being written
+		Event event;
+	};
+
+	const uint64_t mask_;
+	std::unique_ptr<Slot[]> slots_;
+	std::atomic<uint64_t> head_{0};
+};
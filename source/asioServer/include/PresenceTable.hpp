@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "AccessPolicy.hpp"
+#include "UserTable.hpp"
+
+/// Which zone every user is in, for anti-passback and occupancy.\n
+/// One 16 bit zone ID per user ID and one counter per zone, all atomics. Scans update them under the shared rw_mtx with one
+/// compare-exchange on the user and one add per counter, so scans at different doors never wait on each other.
+/// Counts are O(1) reads of the counters, only listing who is inside walks the users.\n
+/// resize() and forget() need the exclusive rw_mtx, like the user table the IDs come from.
+class PresenceTable {
+public:
+	static constexpr uint16_t outside_ = 0; // Zone ID of users outside every zone, also the ID of doors without a zone
+
+	/// Makes room for user IDs below users and zone IDs below zones. Never shrinks.
+	void resize(size_t users, size_t zones);
+
+	/// @returns the zone the user is in, outside_ if none.
+	uint16_t zoneOf(const UserTable::Id user) const {
+		return user < userCapacity_ ? users_[user].load(std::memory_order_relaxed) : outside_;
+	}
+	uint32_t count(const uint16_t zone) const {
+		return zone < zoneCapacity_ ? counters_[zone].value.load(std::memory_order_relaxed) : 0;
+	}
+
+	/// Records a pass through an entry door of zone, moving the user out of any other zone.
+	/// @returns false without changing anything if the user is already inside zone.
+	bool enter(UserTable::Id user, uint16_t zone);
+	/// Records a pass through an exit door of zone. Users not recorded in zone pass without a change.
+	void leave(UserTable::Id user, uint16_t zone);
+	/// Puts the user outside every zone, for removed users and missed exit scans.
+	/// @returns the zone the user was in.
+	uint16_t forget(UserTable::Id user);
+
+	/// @returns true once per batch of changes since the last call.
+	bool takeDirty() { return dirty_.exchange(false, std::memory_order_relaxed); }
+
+	/// One "user zone" line for every user inside a zone. Names keep the snapshot valid across restarts, where IDs may change.
+	std::string dump(const UserTable& users, const AccessPolicy& policy) const;
+	/// Writes a dump() through a temporary file and rename.
+	static bool save(const std::string& path, const std::string& dump);
+	/// Restores a saved dump. Users and zones that no longer exist are skipped.
+	/// @returns number of users restored.
+	size_t load(const std::string& path, const UserTable& users, const AccessPolicy& policy);
+
+private:
+	struct alignas(64) Counter {
+		std::atomic<uint32_t> value{0};
+	};
+
+	void markDirty() {
+		if (!dirty_.load(std::memory_order_relaxed))
+			dirty_.store(true, std::memory_order_relaxed);
+	}
+
+	std::unique_ptr<std::atomic<uint16_t>[]> users_; // Zone by user ID
+	std::unique_ptr<Counter[]> counters_;           // Users inside by zone ID, own cache line each
+	size_t userCapacity_ = 0;
+	size_t zoneCapacity_ = 0;
+	std::atomic<bool> dirty_{false};
+};
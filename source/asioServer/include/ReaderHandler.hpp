@@ -1,12 +1,26 @@
 ﻿#pragma once
 #include "TcpServer.hpp"
 
+#include <map>
 #include <unordered_map>
 #include <shared_mutex>
 
 #include "json.hpp"
 
 #include "csv.hpp"
+#include "AccessStats.hpp"
+#include "EventRing.hpp"
+#include "ConfigSnapshot.hpp"
+#include "ConfigFile.hpp"
+#include "ConfigJournal.hpp"
+#include "RevocationList.hpp"
+#include "UidFilter.hpp"
+#include "ScheduleTable.hpp"
+#include "AccessPolicy.hpp"
+#include "TimerWheel.hpp"
+#include "PresenceTable.hpp"
+#include "DoorMonitor.hpp"
+#include "DoorSync.hpp"
 
 class ReaderHandler {
 public:
@@ -18,27 +32,68 @@ public:
 private: // Member Functions
 	void stop();
 	/// Do not pass by const reference since pointer copy is trivial.<br>Additional benefit: Avoids any unintended interference with the TcpConnection objects.
-	void handleClient(CONNECTION_T connection) const;
+	void handleClient(CONNECTION_T connection);
 	void handleCli(CONNECTION_T connection);
+	void tail(CONNECTION_T connection);
+	void scheduleTailFlush();
+	void flushTail();
+	void scheduleVisitorTick();
+	void expireVisitors();
+	void schedulePresenceFlush();
+	void flushPresence();
+	void doorEvent(const std::string& door, const std::string& event);
+	std::string doorSnapshot(const std::string& door, const std::string& have) const;
+	void offlineDecision(const std::string& door, const std::string& audit);
+	void suppressedScans(const std::string& door, const std::string& counts);
+	void scheduleDoorFlush();
+	void flushDoorEvents();
 
 	static void myIp();
 
 	void onDeadConnection(CONNECTION_T dead);
 
-	void newUser(CONNECTION_T connection, const std::string&, uint8_t);
+	void newUser(CONNECTION_T connection, const std::string&, uint8_t, uint32_t hours = 0);
 	void newDoor(CONNECTION_T connection, const std::string&, uint8_t);
 	void rmUser(CONNECTION_T connection, const std::string&);
 	void rmDoor(CONNECTION_T connection, const std::string&);
 	void mvUser(CONNECTION_T connection, const std::string&, const std::string&, uint8_t);
 	void mvDoor(CONNECTION_T connection, const std::string&, const std::string&, uint8_t);
+	void addCard(CONNECTION_T connection, const std::string&);
+	void revokeCard(CONNECTION_T connection, const std::string&);
+	void rmSchedule(CONNECTION_T connection, const std::string&);
+	std::string addWindow(const std::string& name, const std::string& text);
+	std::string addHoliday(const std::string& name, const std::string& text);
+	std::string setSchedule(const std::string& door, const std::string& schedule);
+	std::string setGroup(const std::string& name, const std::string& group);
+	std::string setZone(const std::string& door, const std::string& zone);
+	std::string addRule(AccessPolicy::Effect effect, const std::string& group, const std::string& zone);
+	std::string rmRule(const std::string& group, const std::string& zone);
+	std::string setExpiry(const std::string& name, const std::string& hours);
+	std::string setDirection(const std::string& door, const std::string& direction);
+	std::string clearPresence(const std::string& name);
 
 	std::string getSystemLog(const std::string& date);
 	std::string getUserLog(const std::string& name);
 	std::string getDoorLog(const std::string& name);
-
-	static void assertConfig(nlohmann::json&);
-	bool addToConfig(const std::string&, const std::string&, uint8_t, const std::string& = "");
+	std::string getCards(const std::string& name) const;
+	std::string getSchedules() const;
+	std::string getRules() const;
+	std::string explain(const std::string& name, const std::string& door) const;
+	std::string getVisitors() const;
+	std::string getOccupancy(const std::string& zone) const;
+	std::string getOccupants(const std::string& zone) const;
+	std::string getDoorAlerts() const;
+	std::string getStats(const std::string& hours) const;
+	std::string getMetrics() const;
+
+	void importConfig(std::vector<std::string>& revoked, std::string& schedules, std::string& rules);
+	void applyJournal(const std::string& line);
+	bool saveConfig() const;
+	bool addToConfig(const std::string&, const std::string&, uint8_t, const std::string& = "", uint32_t expires = 0);
 	bool removeFromConfig(const std::string&, const std::string&);
+	bool editInConfig(const std::string& type, const std::string& oldName, const std::string& newName, uint8_t lvl);
+	bool addCardToConfig(const std::string& name, const std::string& uid);
+	bool revokeCardInConfig(const std::string& uid);
 
 	struct CmdArgs;
 	enum Command : int; // Standard enum type. Necessary for forward declaration
@@ -47,6 +102,7 @@ private: // Member Functions
 
 	template<typename... Args>
 	static void to_snake_case(Args&... args);
+	static void to_lower(std::string& uid);
 
 private: // Member Variables
 	enum Command : int {
@@ -58,7 +114,27 @@ private: // Member Variables
 		mvDoor_,
 		systemLog_,
 		userLog_,
-		doorLog_
+		doorLog_,
+		statistics_,
+		addCard_,
+		revokeCard_,
+		getCards_,
+		addWindow_,
+		addHoliday_,
+		setSchedule_,
+		rmSchedule_,
+		setGroup_,
+		setZone_,
+		allow_,
+		deny_,
+		rmRule_,
+		explain_,
+		newVisitor_,
+		setExpiry_,
+		setDirection_,
+		clearPresence_,
+		getOccupancy_,
+		getOccupants_
 	};
 
 	struct CmdArgs {
@@ -73,11 +149,46 @@ private: // Member Variables
 	TcpServer cliServer_;
 
 	CsvLogger log_;
+	AccessStats stats_;
+	EventRing events_{1024};
+
+	struct TailSubscriber {
+		CONNECTION_T connection;
+		uint64_t cursor;
+		uint64_t dropped;
+	};
+	std::vector<TailSubscriber> tailSubscribers_;
+	std::atomic<bool> tailing_{false};        // Lets the decision path skip the post when nobody is tailing
+	std::atomic<bool> flushScheduled_{false}; // Coalesces posts while a flush is already queued
+	boost::asio::steady_timer tailRetry_;     // Retries subscribers that were skipped because of unsent writes
+	boost::asio::steady_timer visitorTick_;   // Turns visitors_ once a second while badges are pending
+	std::atomic<bool> visitorTicking_{false}; // visitorTick_ is armed
+	boost::asio::steady_timer presenceFlush_; // Saves presence_ every few seconds while scans change it
+	std::atomic<bool> doorFlushScheduled_{false}; // Coalesces posts of flushDoorEvents
+	boost::asio::steady_timer doorSweep_;     // Checks open doors for held-open once a second while any is open
+	bool doorSweeping_ = false;               // doorSweep_ is armed, CLI io_context only
+	uint64_t doorCursor_ = 0;                 // Next event of events_ for doorMonitor_, CLI io_context only
+	DoorMonitor doorMonitor_;                 // Door events against approvals, CLI io_context only
+	mutable DoorSync doorSync_{"door.key"};   // Offline cache snapshots for the door clients
+	struct SuppressedScans {
+		uint64_t duplicates;
+		uint64_t limited;
+	};
+	std::map<std::string, SuppressedScans> suppressed_; // Scans the door clients dropped at the reader, as last reported
 	std::pair<std::string, CONNECTION_T> cliReader_;
-	std::unordered_map<std::string, int> doors_;
-	std::unordered_map<std::string, std::pair<std::string, int>> usersByName_;
-	std::unordered_map<std::string, std::pair<std::string, int>> usersByUid_;
+	ConfigSnapshot::Doors doors_;
+	UserTable users_;
+	ScheduleTable schedules_;                // Compiled against doors_ by bind()
+	AccessPolicy policy_;                    // Compiled against users_ and doors_ by publish()
+	TimerWheel visitors_;                    // Expiry of visitor badges by user ID
+	PresenceTable presence_;                 // Zone of every user for anti-passback, updated by scans under the shared rw_mtx
+	UidFilter uidFilter_;                    // Known card UIDs, rebuilt with users_
+	RevocationList revoked_;                 // Read without rw_mtx, writers hold it
+	ConfigJournal journal_{"config.journal"}; // Card changes not yet folded into config.json
+	std::string logsConfig_{"{}"}; // "logs" object of config.json as JSON text, written back unchanged
 
 	mutable std::mutex cli_mtx;
+	mutable std::mutex tail_mtx;
+	mutable std::mutex suppressed_mtx;
 	mutable std::shared_mutex rw_mtx; // Use shared_lock for json reads and unique_lock for json writes.
 };
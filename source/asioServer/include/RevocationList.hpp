@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Set of revoked card UIDs, checked on every scan.\n
+/// Readers load an immutable snapshot, a sorted array behind a Bloom filter, through one atomic shared_ptr and never take a lock.
+/// Writers are rare CLI operations: they copy the snapshot, modify it and publish the copy. Callers serialise writers.
+class RevocationList {
+public:
+	RevocationList();
+
+	/// Bloom filter first, so cards that were never revoked cost a hash and a few bit tests.
+	bool contains(std::string_view uid) const;
+
+	/// @returns false if the UID was already revoked.
+	bool revoke(std::string_view uid);
+	/// @returns false if the UID wasn't revoked.
+	bool restore(std::string_view uid);
+	/// Replaces the whole list, used when loading the config.
+	void assign(std::vector<std::string> uids);
+
+	/// Sorted copy of the revoked UIDs.
+	std::vector<std::string> list() const;
+	size_t size() const;
+
+private:
+	struct Snapshot {
+		std::vector<std::string> uids; // Sorted
+		std::vector<uint64_t> bloom;   // Power-of-two number of bits, at least 8 per UID
+
+		explicit Snapshot(std::vector<std::string> sorted);
+		bool mightContain(uint64_t hash) const;
+	};
+
+	static uint64_t hashOf(std::string_view uid);
+
+	std::atomic<std::shared_ptr<const Snapshot>> snapshot_;
+};
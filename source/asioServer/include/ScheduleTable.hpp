@@ -0,0 +1,95 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ConfigSnapshot.hpp"
+
+/// Named weekly schedules with holiday calendars. Every door naming the same schedule forms one door group.\n
+/// Schedules are compiled whenever they or the doors change: one bit per minute of the week and one bit per day for holidays.
+/// A decision is then the door lookup handleClient does anyway plus two bit tests, never a walk over windows or dates.\n
+/// Not thread-safe, ReaderHandler guards it with rw_mtx like doors_.
+class ScheduleTable {
+public:
+	static constexpr uint32_t always_ = UINT32_MAX;     // Door without a schedule, open at any time
+	static constexpr uint32_t never_  = UINT32_MAX - 1; // Door naming a schedule that doesn't exist, closed at any time
+
+	/// Open from "from" until "to" on every day in days. A window ending before it starts runs past midnight into the next day.
+	struct Window {
+		uint8_t days;  // Bit 0 is monday
+		uint16_t from; // Minute of the day
+		uint16_t to;   // Minute of the day, exclusive, up to 24:00
+
+		bool operator==(const Window&) const = default;
+	};
+
+	/// Closed all day. Year 0 repeats every year.
+	struct Holiday {
+		uint8_t day;
+		uint8_t month;
+		uint16_t year;
+
+		bool operator==(const Holiday&) const = default;
+	};
+
+	/// @param text "mon-fri 07:00-18:00", "sat 09:00-13:00" or "daily 22:00-06:00".
+	static bool parseWindow(const std::string& text, Window& window);
+	/// @param text "24/12" for every year or "24/12/2026", the date format of the logs.
+	static bool parseHoliday(const std::string& text, Holiday& holiday);
+	static std::string format(const Window& window);
+	static std::string format(const Holiday& holiday);
+
+	/// Replaces every schedule with the "schedules" object of config.json. Invalid entries are skipped.
+	void load(const std::string& json);
+	/// "schedules" object for config.json, "{}" if there are none.
+	std::string json() const;
+
+	bool contains(const std::string& name) const { return schedules_.contains(name); }
+	/// Adds a window, creating the schedule if needed.
+	/// @returns false if the schedule already has that window.
+	bool addWindow(const std::string& name, const Window& window);
+	/// @returns false if the schedule doesn't exist or already has that holiday.
+	bool addHoliday(const std::string& name, const Holiday& holiday);
+	bool remove(const std::string& name);
+	/// Every schedule with its windows, holidays and doors.
+	std::string describe(const ConfigSnapshot::Doors& doors) const;
+
+	/// Compiles every schedule and points each door at its compiled tables.\n
+	/// Call after loading and after any change to the schedules or to the schedule of a door.
+	void bind(ConfigSnapshot::Doors& doors);
+
+	/// @param slot the door's ConfigSnapshot::Door::slot.
+	/// @param minuteOfWeek local time, 0 is monday 00:00.
+	/// @param day local date as days since 01/01/1970.
+	bool allows(const uint32_t slot, const int minuteOfWeek, const int32_t day) const {
+		if (slot >= compiled_.size())
+			return slot == always_;
+		const Compiled& schedule = compiled_[slot];
+		const auto offset        = static_cast<uint32_t>(day - firstDay_);
+		if (!schedule.closedDays.empty() && offset < dayCount_ && (schedule.closedDays[offset / 64] >> (offset % 64) & 1))
+			return false;
+		return schedule.week[minuteOfWeek];
+	}
+
+private:
+	struct Schedule {
+		std::vector<Window> windows;
+		std::vector<Holiday> holidays;
+	};
+
+	struct Compiled {
+		std::bitset<7 * 24 * 60> week;
+		std::vector<uint64_t> closedDays; // One bit per day from firstDay_, empty without holidays
+	};
+
+	static constexpr int32_t firstDay_  = 10957; // 01/01/2000
+	static constexpr uint32_t dayCount_ = 36525; // Through 31/12/2099
+
+	static Compiled compile(const Schedule& schedule);
+
+	std::map<std::string, Schedule> schedules_;
+	std::vector<Compiled> compiled_; // Same order as schedules_
+};
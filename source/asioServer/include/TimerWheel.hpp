@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// Hierarchical timer wheel of one-second ticks, used to expire visitor badges.\n
+/// Four levels of 64 slots cover 64^4 seconds (about 194 days), later deadlines wait in an overflow list that is placed again once per turn of the top level.
+/// Scheduling and cancelling touch one slot, and each timer moves down at most three levels before it fires,
+/// so expiring a timer is O(1) and no tick ever looks at timers that aren't due. Blocks of seconds without timers in the levels below are skipped whole,
+/// so catching up after a long pause costs little more than the cascades it passes.\n
+/// Not thread-safe, ReaderHandler guards it with rw_mtx like the users it points at.
+class TimerWheel {
+public:
+	/// @param now current time in seconds, the wheel never fires anything before it.
+	explicit TimerWheel(const int64_t now = 0) : current_(now) {}
+
+	/// Starts the wheel at now. Only call while it is empty, e.g. before scheduling the timers of a freshly loaded config.
+	void reset(int64_t now);
+	/// Replaces any timer of id. Deadlines that already passed fire on the next advance().
+	void schedule(uint32_t id, int64_t when);
+	/// @returns false if id had no timer.
+	bool cancel(uint32_t id);
+	/// @returns the deadline of id, 0 if it has no timer.
+	int64_t deadline(uint32_t id) const;
+	size_t size() const { return timers_.size(); }
+
+	/// Turns the wheel to now and calls expired(id) for every timer due by then, second by second.\n
+	/// The timer is removed before expired is called, so expired may schedule it again.
+	template<typename Fn>
+	void advance(int64_t now, Fn&& expired);
+
+	/// Every id with its deadline, in no particular order.
+	std::vector<std::pair<uint32_t, int64_t>> list() const;
+
+private:
+	struct Timer {
+		uint32_t id;
+		int64_t when;
+	};
+	using Slot = std::list<Timer>;
+
+	struct Handle {
+		uint16_t slot;
+		Slot::iterator timer;
+	};
+
+	static constexpr int bits_     = 6;
+	static constexpr int slots_    = 1 << bits_;
+	static constexpr int levels_   = 4;
+	static constexpr int overflow_ = slots_ * levels_; // Index of the overflow list in wheel_
+
+	/// Puts a timer in the lowest level whose current block holds its deadline.
+	void place(Slot& from, Slot::iterator timer);
+	/// Moves the timers of the current slot of level down, level == levels_ places the overflow list again.
+	void cascade(int level);
+
+	std::array<Slot, slots_ * levels_ + 1> wheel_;
+	std::array<size_t, levels_ + 1> levelSizes_{}; // Timers per level, the last one is the overflow list
+	std::unordered_map<uint32_t, Handle> timers_;
+	int64_t current_; // Last second that was processed
+};
+
+template<typename Fn>
+void TimerWheel::advance(const int64_t now, Fn&& expired) {
+	while (current_ < now) {
+		if (timers_.empty()) {
+			current_ = now; // Nothing to fire, skip the idle seconds
+			return;
+		}
+		// With the lowest levels empty nothing can fire before the next level above turns, jump to the second before it
+		int empty = 0;
+		while (empty < levels_ && levelSizes_[empty] == 0)
+			++empty;
+		if (empty > 0)
+			current_ = std::min(now, (((current_ >> bits_ * empty) + 1) << bits_ * empty) - 1);
+		if (current_ == now)
+			return;
+		++current_;
+
+		// Level n turns whenever the lowest n * bits_ bits of the time wrap to 0. Higher levels go first so their timers reach level 0 this tick.
+		int level = 0;
+		while (level < levels_ && (current_ & ((int64_t{1} << bits_ * (level + 1)) - 1)) == 0)
+			++level;
+		for (; level > 0; --level)
+			cascade(level);
+
+		Slot due;
+		due.splice(due.end(), wheel_[current_ & (slots_ - 1)]);
+		levelSizes_[0] -= due.size();
+		// Forget the whole batch first, expired may cancel or schedule any id
+		for (const Timer& timer : due)
+			timers_.erase(timer.id);
+		for (const Timer& timer : due)
+			expired(timer.id);
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class UserTable;
+
+/// Blocked Bloom filter over every known card UID, consulted by handleClient before the user table.\n
+/// A UID maps to one cache-line block and sets one bit in each of its eight words, so a lookup is one hash and one cache line,
+/// where a miss in the user table costs an index slot, a record and a string compare. Definite misses are denied right away.\n
+/// Not thread-safe for writers, ReaderHandler guards it with rw_mtx like the user table. The counters are relaxed atomics.
+class UidFilter {
+public:
+	struct Metrics {
+		uint64_t passed{};         // Possibly known, went on to the user table
+		uint64_t rejected{};       // Definitely unknown
+		uint64_t falsePositives{}; // Passed but not in the user table
+		size_t keys{};
+		size_t bytes{};
+	};
+
+	/// Rebuilds the filter from every card in the table, sized with headroom for cards added later.
+	void build(const UserTable& users);
+	/// Adds one UID without a rebuild.
+	/// @returns false once the filter holds more UIDs than it was sized for, the caller should rebuild.
+	bool insert(std::string_view uid);
+
+	/// @returns false if the UID is definitely not a known card.
+	bool mightContain(std::string_view uid) const;
+	/// Called when a UID passed the filter but the user table didn't know it.
+	void recordFalsePositive() const { falsePositives_.fetch_add(1, std::memory_order_relaxed); }
+
+	Metrics metrics() const;
+	static std::string format(const Metrics& metrics);
+
+private:
+	struct alignas(64) Block {
+		uint64_t words[8];
+	};
+
+	static constexpr size_t bitsPerKey_ = 12; // About 0.5% false positives at capacity
+
+	void set(uint64_t hash);
+	bool test(uint64_t hash) const;
+	size_t blockOf(uint64_t hash) const;
+
+	std::vector<Block> blocks_;
+	size_t keys_     = 0;
+	size_t capacity_ = 0;
+
+	mutable std::atomic<uint64_t> passed_{0};
+	mutable std::atomic<uint64_t> rejected_{0};
+	mutable std::atomic<uint64_t> falsePositives_{0};
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// Users and their cards stored once in two contiguous record arrays, with names and UIDs in one shared string pool.\n
+/// The name and UID indexes are open-addressing tables of 32-bit record IDs that compare against the pool,
+/// so a user costs one 20 byte record, a card 16 bytes, plus their strings and one index slot each.
+/// A rename or level change touches one record and at most one index slot.
+/// Group names are interned once and users hold a 16 bit group ID, so the group of a user is in the same record as its level.\n
+/// Not thread-safe, ReaderHandler guards it with rw_mtx. Views returned by name() and uid() are valid until the next mutation.
+class UserTable {
+public:
+	using Id = uint32_t;
+	using Group = uint16_t;
+	static constexpr Id none_       = UINT32_MAX;
+	static constexpr Group noGroup_ = 0;
+
+	Id findByName(std::string_view name) const;
+	/// @returns the owner of the card, none_ for unknown cards.
+	Id findByUid(std::string_view uid) const;
+
+	std::string_view name(Id id) const;
+	/// First card of the user, empty if the user has none left.
+	std::string_view uid(Id id) const;
+	int lvl(Id id) const { return users_[id].lvl; }
+	Group group(Id id) const { return users_[id].group; }
+	/// Unix time the badge of a visitor stops working, 0 for a permanent user.
+	uint32_t expires(Id id) const { return users_[id].expires; }
+	size_t cardCount() const { return cardIndex_.count; }
+
+	/// @param uid first card, may be empty for a user without cards.
+	/// @returns the new ID, none_ if the name or the UID is taken.
+	Id add(std::string_view name, std::string_view uid, int lvl);
+	/// Removes the user together with all of its cards.
+	bool remove(Id id);
+	/// @returns false if newName belongs to another user.
+	bool rename(Id id, std::string_view newName);
+	void setLevel(Id id, int lvl) { users_[id].lvl = static_cast<int16_t>(lvl); }
+	void setGroup(Id id, Group group) { users_[id].group = group; }
+	void setExpires(Id id, uint32_t expires) { users_[id].expires = expires; }
+
+	/// @returns the ID of the group, added if it is new. noGroup_ for an empty name or once all 65535 IDs are taken.
+	Group internGroup(std::string_view name);
+	/// @returns noGroup_ for unknown names.
+	Group findGroup(std::string_view name) const;
+	/// Empty for noGroup_.
+	const std::string& groupName(Group group) const { return groups_[group]; }
+	/// Number of group IDs including noGroup_, IDs run from 0 to groupCount() - 1.
+	size_t groupCount() const { return groups_.size(); }
+
+	/// @returns false if the UID already belongs to a user.
+	bool addCard(Id id, std::string_view uid);
+	/// @returns the former owner, none_ if the card is unknown.
+	Id removeCard(std::string_view uid);
+
+	void reserve(size_t users, size_t cards);
+	void clear();
+	size_t size() const { return nameIndex_.count; }
+	/// Every ID handed out so far is below idLimit(), for tables indexed by user ID.
+	Id idLimit() const { return static_cast<Id>(users_.size()); }
+	bool empty() const { return nameIndex_.count == 0; }
+
+	/// Calls fn(id) for every live user, in record order.
+	template<typename Fn>
+	void forEach(Fn&& fn) const {
+		for (Id id = 0; id < users_.size(); ++id)
+			if (users_[id].nameLength)
+				fn(id);
+	}
+
+	/// Calls fn(uid) for every card of the user, oldest first.
+	template<typename Fn>
+	void forEachCard(const Id id, Fn&& fn) const {
+		for (Id card = users_[id].firstCard; card != none_; card = cards_[card].next)
+			fn(cardUid(card));
+	}
+
+private:
+	struct User {
+		uint32_t nameOffset;
+		uint32_t nameLength; // 0 marks a removed user
+		uint32_t firstCard;
+		int16_t lvl;
+		Group group;
+		uint32_t expires; // Unix time, 0 for never
+	};
+
+	struct Card {
+		uint32_t uidOffset;
+		uint32_t uidLength; // 0 marks a removed card
+		Id owner;
+		Id next; // Next card of the same owner
+	};
+	static_assert(sizeof(User) == 20 && sizeof(Card) == 16);
+
+	/// Linear probing over record IDs, erase shifts entries back so no tombstones are needed.
+	struct Index {
+		std::vector<Id> slots;
+		size_t count = 0;
+	};
+
+	std::string_view cardUid(Id card) const;
+	Id findCard(std::string_view uid) const;
+	void unlinkCard(Id card);
+
+	std::string_view key(Id id, bool card) const;
+	Id find(const Index& index, std::string_view key, bool card) const;
+	void insert(Index& index, Id id, bool card);
+	void erase(Index& index, Id id, bool card);
+	void grow(Index& index, size_t capacity, bool card);
+	uint32_t intern(std::string_view str);
+	void compact();
+
+	std::vector<char> pool_;
+	std::vector<User> users_;
+	std::vector<Card> cards_;
+	std::vector<Id> freeUsers_; // Removed records are reused
+	std::vector<Id> freeCards_;
+	Index nameIndex_;  // User IDs by name
+	Index cardIndex_;  // Card IDs by UID
+	std::vector<std::string> groups_{""}; // Group names by ID, never shrinks while running
+	std::unordered_map<std::string, Group> groupIds_;
+	size_t wasted_ = 0; // Pool bytes of removed or renamed strings, reclaimed by compact()
+};
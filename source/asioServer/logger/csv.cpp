@@ -1,4 +1,7 @@
 #include "csv.hpp"
+#include "logclock.hpp"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <ctime>
@@ -6,171 +9,620 @@
 
 #include "boost/asio/error.hpp"
 
-void CsvLogger::addLog(std::string door, std::string name, std::string userID, std::string access) const {
-  /// get date from RPi
-  time_t timestamp = std::time(NULL);
-  struct tm datetime = *localtime(&timestamp);
+#ifdef HAS_ZLIB
+#include <zlib.h>
+#endif
 
-  /// create date and time for log
-  char date[50];
-  strftime(date, 50, "%d/%m/%Y", &datetime);
+#include <fcntl.h>
+#if defined(_WIN32)
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
 
-  char time[50];
-  strftime(time, 50, "%H:%M", &datetime);
+namespace {
+  const std::string header = "Date;Time;Door;Name;UserID;Access;MonoNs;SourceMs\n";
+  const char* folders[] = {"systemLogs", "userLogs", "doorLogs"};
 
-#ifdef DEBUG
-  //std::cout << "Logged " << date << ", " << time << ", " << door << ", " << name << ", " << userID << ", " << access << std::endl;
-#endif DEBUG
-
-  /// *** add system log ***
-  /// get date dd_mm_yyyy for csv name
-  char logDateChar[50];
-  strftime(logDateChar, 50, "%Y_%m_%d", &datetime);
-  /// convert char* to string
-  std::string logDate = logDateChar;
-  /// create log name
-  std::string logNameDate = "Log_" + logDate + ".csv";
-
-  /// get the path of the logs of system
-  std::filesystem::path currentPath = std::filesystem::current_path();
-  /// check if folder exists (it should) else create folder
-  std::filesystem::create_directories(currentPath / "logs" / "systemLogs");
-  std::filesystem::path logPathSystem = currentPath / "logs" / "systemLogs" / logNameDate;
+  /// "Log_john_doe.20251128_101300.csv.gz" -> "Log_john_doe.csv"
+  std::string logNameOf(const std::string& file) {
+    return file.substr(0, file.find('.')) + ".csv";
+  }
 
-  /// bool to check if file already exists
-  bool fileExistsDate = std::filesystem::exists(logPathSystem);
-  /// file pointer, opens an existing csv file or creates a new file
-  std::ofstream foutDate(logPathSystem.string(), std::ios::out | std::ios::app);
-  /// if file didn't exist add header to the new csv file
-  if (!fileExistsDate) {
-    foutDate << "Date;Time;Door;Name;UserID;Access\n";
+  bool isCompressed(const std::filesystem::path& file) {
+    return file.extension() == ".gz";
   }
 
-  /// insert new data to file
-  foutDate << date << ";"
-      << time << ";"
-      << door << ";"
-      << name << ";"
-      << userID << ";"
-      << access
-      << "\n";
-  foutDate.close();
-
-  /// *** add user log ***
-  /// create log name
-  std::string logNameUser = "Log_" + name + ".csv";
+  /// name of the system log that is currently being written, "Log_yyyy_mm_dd.csv"
+  std::string activeSystemLog() {
+    return "Log_" + LogClock::now().fileSuffix + ".csv";
+  }
 
-  /// check if folder exists (it should) else create folder
-  std::filesystem::create_directories(currentPath / "logs" / "userLogs");
-  /// get the path of the logs for users
-  std::filesystem::path logPathUsers = currentPath / "logs" / "userLogs" / logNameUser;
+  /// reads the first record of a csv-file and returns its date, or now if it can't be parsed
+  std::time_t firstRecordTime(const std::filesystem::path& file, std::time_t now) {
+    std::ifstream fin(file);
+    std::string line;
+    std::getline(fin, line); /// skip header
+    if (!std::getline(fin, line))
+      return now;
 
-  /// bool to check if file already exists
-  bool fileExistsUser = std::filesystem::exists(logPathUsers);
-  /// file pointer, opens an existing csv file or creates a new file
-  std::ofstream foutUser(logPathUsers.string(), std::ios::out | std::ios::app);
-  /// if file didn't exist add header to the new csv file
-  if (!fileExistsUser) {
-    foutUser << "Date;Time;Door;Name;UserID;Access\n";
+    std::tm tm{};
+    /// hh:mm:ss.mmm, or hh:mm in logs written before the seconds were added
+    if (std::sscanf(line.c_str(), "%d/%d/%d;%d:%d:%d", &tm.tm_mday, &tm.tm_mon, &tm.tm_year, &tm.tm_hour, &tm.tm_min, &tm.tm_sec) < 3)
+      return now;
+    tm.tm_mon -= 1;
+    tm.tm_year -= 1900;
+    tm.tm_isdst = -1;
+    const std::time_t t = std::mktime(&tm);
+    return t == -1 ? now : t;
   }
 
-  /// insert new data to file
-  foutUser << date << ";"
-      << time << ";"
-      << door << ";"
-      << name << ";"
-      << userID << ";"
-      << access
-      << "\n";
-  foutUser.close();
-
-  /// *** add door log ***
-  /// create log name
-  std::string logNameDoor = "Log_" + door + ".csv";
+  /// true if a csv-file starts with the current header, files written with an older one are rotated before the next record
+  bool currentSchema(const std::filesystem::path& file) {
+    std::ifstream fin(file);
+    std::string line;
+    return std::getline(fin, line) && line + "\n" == header;
+  }
+
+  /// forces written data of one file to disk, metadata only if needed to read it back
+  void syncFd(int fd) {
+#if defined(_WIN32)
+    _commit(fd);
+#elif defined(__APPLE__)
+    fsync(fd);
+#else
+    fdatasync(fd);
+#endif
+  }
+
+  /// active files kept open at once, userLogs alone can hold one per employee
+  constexpr std::size_t maxOpen = 64;
+
+  /// empty fields to append to the rows of a segment written with an older header, which had fewer columns
+  std::string missingColumns(const std::string& segmentHeader) {
+    const auto columns = [](const std::string& line) { return std::count(line.begin(), line.end(), ';'); };
+    const auto missing = columns(header) - columns(segmentHeader);
+    return std::string(missing > 0 ? missing : 0, ';');
+  }
+
+  /// copies every line of a plain or gzipped segment to out, dropping its header line.
+  /// Rows of segments with an older header are padded to the current columns, so an export has one schema
+  void appendSegment(std::ofstream& out, const std::filesystem::path& file) {
+    if (isCompressed(file)) {
+#ifdef HAS_ZLIB
+      gzFile in = gzopen(file.string().c_str(), "rb");
+      if (!in)
+        return;
+      char buf[4096];
+      std::string segmentHeader;
+      std::string line;
+      bool first = true;
+      while (gzgets(in, buf, sizeof(buf))) {
+        const bool complete = buf[std::strlen(buf) - 1] == '\n'; /// lines may span several reads
+        (first ? segmentHeader : line) += buf;
+        if (!complete)
+          continue;
+        if (first) {
+          segmentHeader.pop_back();
+          first = false;
+          continue;
+        }
+        line.pop_back();
+        out << line << missingColumns(segmentHeader) << "\n";
+        line.clear();
+      }
+      gzclose(in);
+#endif
+      return;
+    }
+
+    std::ifstream in(file);
+    std::string segmentHeader;
+    std::getline(in, segmentHeader);
+    const std::string padding = missingColumns(segmentHeader);
+    std::string line;
+    while (std::getline(in, line))
+      out << line << padding << "\n";
+  }
+}
+
+CsvLogger::CsvLogger() {
+  worker_ = std::thread([this] { worker(); });
+}
+
+CsvLogger::~CsvLogger() {
+  setDurability({Durability::none}); /// stops the committer
+  {
+    const std::scoped_lock lock{queueMtx_};
+    stopping_ = true;
+  }
+  queueCv_.notify_all();
+  if (worker_.joinable())
+    worker_.join();
+
+  const std::scoped_lock lock{mtx_};
+  closeAll();
+}
+
+void CsvLogger::setPolicy(const RotationPolicy& policy) {
+  {
+    const std::scoped_lock lock{mtx_};
+    policy_ = policy;
+  }
+  {
+    const std::scoped_lock lock{queueMtx_};
+    queue_.emplace_back(); /// full sweep
+  }
+  queueCv_.notify_one();
+}
+
+void CsvLogger::setDurability(const DurabilityPolicy& durability) {
+  /// stop the old committer first, it reads durability_ without the lock
+  if (committer_.joinable()) {
+    {
+      const std::scoped_lock lock{commitMtx_};
+      commitStopping_ = true;
+    }
+    commitCv_.notify_all();
+    committer_.join();
+    commit(); /// flush whatever the old committer left behind
+  }
 
+  {
+    const std::scoped_lock lock{mtx_};
+    durability_ = durability;
+  }
+
+  if (durability.mode == Durability::group) {
+    commitStopping_ = false;
+    committer_      = std::thread([this] { committer(); });
+  }
+}
+
+CsvLogger::Durability CsvLogger::durability() const {
+  const std::scoped_lock lock{mtx_};
+  return durability_.mode;
+}
+
+CsvLogger::Metrics CsvLogger::metrics() const {
+  return {records_.load(), commits_.load(), maxBatch_.load(), totalLatencyUs_.load(), maxLatencyUs_.load()};
+}
+
+std::string CsvLogger::format(const Metrics& metrics, const Durability mode) {
+  const char* modes[] = {"none", "group", "record"};
+  std::string out = "Audit durability: ";
+  out += modes[static_cast<int>(mode)];
+  out += "\n  records: " + std::to_string(metrics.records);
+  out += "\n  commits: " + std::to_string(metrics.commits);
+  if (metrics.commits) {
+    out += "\n  batch avg/max: " + std::to_string(metrics.records / metrics.commits) + "/" + std::to_string(metrics.maxBatch);
+    out += "\n  commit latency avg/max: " + std::to_string(metrics.totalLatencyUs / metrics.commits) + "us/" +
+           std::to_string(metrics.maxLatencyUs) + "us";
+  }
+  return out;
+}
+
+void CsvLogger::recordCommit(const uint64_t batch, const std::chrono::steady_clock::duration latency) const {
+  const uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+  commits_.fetch_add(1, std::memory_order_relaxed);
+  totalLatencyUs_.fetch_add(us, std::memory_order_relaxed);
+
+  uint64_t seen = maxBatch_.load(std::memory_order_relaxed);
+  while (batch > seen && !maxBatch_.compare_exchange_weak(seen, batch, std::memory_order_relaxed)) {}
+  seen = maxLatencyUs_.load(std::memory_order_relaxed);
+  while (us > seen && !maxLatencyUs_.compare_exchange_weak(seen, us, std::memory_order_relaxed)) {}
+}
+
+/// Group commit thread. Sleeps for groupInterval, or until groupRecords records are pending.
+void CsvLogger::committer() {
+  std::unique_lock lock{commitMtx_};
+  while (!commitStopping_) {
+    commitCv_.wait_for(lock, durability_.groupInterval, [this] {
+      return commitStopping_ || pending_.load(std::memory_order_relaxed) >= durability_.groupRecords;
+    });
+    lock.unlock();
+    commit();
+    lock.lock();
+  }
+}
+
+/// Syncs every dirty descriptor once. The descriptors are duplicated under the lock and synced
+/// outside it, so addLog keeps appending while the disk catches up.
+void CsvLogger::commit() const {
+  std::vector<int> dirty;
+  uint64_t batch = 0;
+  {
+    const std::scoped_lock lock{mtx_};
+    for (auto& [path, log] : open_)
+      if (log.dirty) {
+        const int fd = dup(log.fd);
+        if (fd >= 0)
+          dirty.push_back(fd);
+        log.dirty = false;
+      }
+    batch = pending_.exchange(0, std::memory_order_relaxed);
+  }
+  if (dirty.empty())
+    return;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (const int fd : dirty) {
+    syncFd(fd);
+    close(fd);
+  }
+  recordCommit(batch, std::chrono::steady_clock::now() - start);
+}
+
+/// mtx_ must be held by the caller
+int CsvLogger::descriptor(const std::filesystem::path& path) const {
+  const auto it = open_.find(path.string());
+  if (it != open_.end())
+    return it->second.fd;
+
+  if (open_.size() >= maxOpen)
+    closeAll();
+
+#ifdef _WIN32
+  const int fd = _open(path.string().c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+  if (fd < 0)
+    throw std::runtime_error("[ERROR] could not open log file " + path.string());
+  open_.emplace(path.string(), OpenLog{fd, false});
+  return fd;
+}
+
+/// mtx_ must be held by the caller
+void CsvLogger::closeAll() const {
+  bool synced = false;
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto& [path, log] : open_) {
+    if (log.dirty && durability_.mode != Durability::none) {
+      syncFd(log.fd);
+      synced = true;
+    }
+    close(log.fd);
+  }
+  open_.clear();
+  if (synced)
+    recordCommit(pending_.exchange(0, std::memory_order_relaxed), std::chrono::steady_clock::now() - start);
+}
+
+std::filesystem::path CsvLogger::logRoot() {
+  return std::filesystem::current_path() / "logs";
+}
+
+void CsvLogger::addLog(std::string door, std::string name, std::string userID, std::string access, int64_t sourceMs) const {
+  addRow(door, name, userID, access, sourceMs, true);
+}
+
+void CsvLogger::addAlert(const std::string& door, const std::string& kind) const {
+  addRow(door, "alert", "-", kind, 0, false);
+}
+
+void CsvLogger::addRow(const std::string& door, const std::string& name, const std::string& userID,
+                       const std::string& access, int64_t sourceMs, bool userLog) const {
+  /// date, time and log name suffix are formatted once per second and reused for every record in it
+  const LogClock::Stamp stamp = LogClock::now();
+  const time_t timestamp      = stamp.seconds;
+  const std::string& logDate  = stamp.fileSuffix;
+
+  /// build the row once, it is the same in every log it goes to
+  std::string row;
+  row.reserve(96 + door.size() + name.size() + userID.size());
+  row.append(stamp.date).append(";")
+     .append(stamp.time).append(";")
+     .append(door).append(";")
+     .append(name).append(";")
+     .append(userID).append(";")
+     .append(access).append(";")
+     .append(std::to_string(stamp.monoNs)).append(";")
+     .append(sourceMs ? std::to_string(sourceMs) : "").append("\n");
+
+  bool dayChanged = false;
+  {
+    const std::scoped_lock lock{mtx_};
+    /// *** add system log ***
+    writeRow("systemLogs", "Log_" + logDate + ".csv", row, timestamp);
+    /// *** add user log ***
+    if (userLog)
+      writeRow("userLogs", "Log_" + name + ".csv", row, timestamp);
+    /// *** add door log ***
+    writeRow("doorLogs", "Log_" + door + ".csv", row, timestamp);
+
+    dayChanged = !lastDate_.empty() && lastDate_ != logDate;
+    lastDate_  = logDate;
+
+    records_.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t pending = pending_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (durability_.mode == Durability::record) {
+      const auto start = std::chrono::steady_clock::now();
+      for (auto& [path, log] : open_)
+        if (log.dirty) {
+          syncFd(log.fd);
+          log.dirty = false;
+        }
+      recordCommit(pending_.exchange(0, std::memory_order_relaxed), std::chrono::steady_clock::now() - start);
+    } else if (durability_.mode == Durability::group && pending >= durability_.groupRecords) {
+      commitCv_.notify_one();
+    }
+  }
+
+  /// yesterday's system log is closed now, let the worker compress it
+  if (dayChanged) {
+    {
+      const std::scoped_lock lock{queueMtx_};
+      queue_.emplace_back();
+    }
+    queueCv_.notify_one();
+  }
+}
+
+/// mtx_ must be held by the caller
+void CsvLogger::writeRow(const std::string& folder, const std::string& logName, const std::string& row,
+                         const std::time_t now) const {
   /// check if folder exists (it should) else create folder
-  std::filesystem::create_directories(currentPath / "logs" / "doorLogs");
-  /// get the path of the logs for users
-  std::filesystem::path logPathDoors = currentPath / "logs" / "doorLogs" / logNameDoor;
+  const std::filesystem::path dir = logRoot() / folder;
+  std::filesystem::create_directories(dir);
+  const std::filesystem::path logPath = dir / logName;
 
   /// bool to check if file already exists
-  bool fileExistsDoor = std::filesystem::exists(logPathDoors);
-  /// file pointer, opens an existing csv file or creates a new file
-  std::ofstream foutDoor(logPathDoors.string(), std::ios::out | std::ios::app);
-  /// if file didn't exist add header to the new csv file
-  if (!fileExistsDoor) {
-    foutDoor << "Date;Time;Door;Name;UserID;Access\n";
+  bool fileExists = std::filesystem::exists(logPath);
+  if (fileExists) {
+    auto start = segmentStart_.find(logPath.string());
+    bool oldSchema = false;
+    if (start == segmentStart_.end()) {
+      /// first record since startup, so every segment holds rows of one schema
+      oldSchema = !currentSchema(logPath);
+      start     = segmentStart_.emplace(logPath.string(), firstRecordTime(logPath, now)).first;
+    }
+
+    const bool tooBig = policy_.maxBytes && std::filesystem::file_size(logPath) >= policy_.maxBytes;
+    const bool tooOld = policy_.maxAge.count() && now - start->second >= std::chrono::seconds(policy_.maxAge).count();
+    if (oldSchema || tooBig || tooOld) {
+      rotate(logPath, now);
+      fileExists = false;
+    }
   }
+  if (!fileExists)
+    segmentStart_[logPath.string()] = now;
+
+  /// cached descriptor, opens an existing csv file or creates a new file
+  const int fd = descriptor(logPath);
+  /// if file didn't exist add header to the new csv file, in the same write as the row
+  const std::string data = fileExists ? row : header + row;
 
   /// insert new data to file
-  foutDoor << date << ";"
-      << time << ";"
-      << door << ";"
-      << name << ";"
-      << userID << ";"
-      << access
-      << "\n";
-  foutDoor.close();
+  if (write(fd, data.data(), static_cast<unsigned>(data.size())) != static_cast<long>(data.size()))
+    throw std::runtime_error("[ERROR] could not write to log file " + logPath.string());
+  open_[logPath.string()].dirty = true;
 }
 
-/// returnere path til filen med den dato, som en streng
-std::string CsvLogger::getLogByDate(std::string date) {
-  /// create log name as string
-  std::string logNameDate = "Log_" + date + ".csv";
+/// mtx_ must be held by the caller
+void CsvLogger::rotate(const std::filesystem::path& active, const std::time_t now) const {
+  char stamp[32];
+  std::tm tm{};
+#ifdef _WIN32
+  localtime_s(&tm, &now);
+#else
+  localtime_r(&now, &tm);
+#endif
+  strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &tm);
+
+  /// Log_john_doe.csv -> Log_john_doe.20251128_101300.csv, suffixed if two rotations land in the same second
+  const std::string base = active.stem().string() + "." + stamp;
+  std::filesystem::path segment = active.parent_path() / (base + ".csv");
+  for (int i = 1; std::filesystem::exists(segment) || std::filesystem::exists(segment.string() + ".gz"); ++i)
+    segment = active.parent_path() / (base + "_" + std::to_string(i) + ".csv");
+
+  /// the segment must be complete on disk before it is renamed and compressed
+  if (const auto it = open_.find(active.string()); it != open_.end()) {
+    if (it->second.dirty && durability_.mode != Durability::none)
+      syncFd(it->second.fd);
+    close(it->second.fd);
+    open_.erase(it);
+  }
 
-  /// Get the path of the logs
-  std::filesystem::path currentPath = std::filesystem::current_path();
-  std::filesystem::path logPathSystem = currentPath / "logs" / "systemLogs" / logNameDate;
+  std::filesystem::rename(active, segment);
+  segmentStart_.erase(active.string());
 
-  /// check if a file exist by that date
-  bool fileExistsDate = std::filesystem::exists(logPathSystem);
-  if (!fileExistsDate) {
-    /// add error message, that file doesn't exist
-    throw std::runtime_error("[ERROR] log file by date " + date + " doesn't exist");
-  } else {
-    /// if file exists return path
-    return logPathSystem.string();
+  {
+    const std::scoped_lock lock{queueMtx_};
+    queue_.push_back(segment);
   }
+  queueCv_.notify_one();
 }
 
-/// returnere path til filen med den dato, som en streng
-std::string CsvLogger::getLogByName(std::string name) {
-  /// create log name as string
-  std::string logNameUser = "Log_" + name + ".csv";
+std::vector<std::filesystem::path> CsvLogger::collect(const std::filesystem::path& folder, const std::string& logName) {
+  std::vector<std::filesystem::path> segments;
+  if (!std::filesystem::exists(folder))
+    return segments;
 
-  /// Get the path of the logs
-  std::filesystem::path currentPath = std::filesystem::current_path();
-  std::filesystem::path logPathUsers = currentPath / "logs" / "userLogs" / logNameUser;
+  const std::string prefix = logName.substr(0, logName.size() - 4) + "."; /// "Log_john_doe."
+  for (const auto& entry : std::filesystem::directory_iterator(folder)) {
+    const std::string file = entry.path().filename().string();
+    if (file.rfind(prefix, 0) == 0 && file != logName && file != logName + ".gz")
+      segments.push_back(entry.path());
+  }
+  /// segment stamps are yyyymmdd_hhmmss so a plain sort is chronological
+  std::sort(segments.begin(), segments.end());
+
+  if (std::filesystem::exists(folder / logName))
+    segments.push_back(folder / logName);
+  else if (std::filesystem::exists(folder / (logName + ".gz")))
+    segments.push_back(folder / (logName + ".gz"));
+  return segments;
+}
+
+/// Joins all segments of a log into logs/export so the CLI still receives a single csv-file.
+/// When the log was never rotated the active file is returned untouched.
+std::string CsvLogger::assemble(const std::string& folder, const std::string& logName, const std::string& what) {
+  const std::scoped_lock lock{mtx_};
+  const auto segments = collect(logRoot() / folder, logName);
+  if (segments.empty())
+    throw std::runtime_error("[ERROR] log file by " + what + " doesn't exist");
+
+  if (segments.size() == 1 && !isCompressed(segments.front()))
+    return segments.front().string();
+
+  std::filesystem::create_directories(logRoot() / "export");
+  const std::filesystem::path exportPath = logRoot() / "export" / logName;
+  std::ofstream out(exportPath, std::ios::out | std::ios::trunc);
+  out << header;
+  for (const auto& segment : segments)
+    appendSegment(out, segment);
+  out.close();
+
+  return exportPath.string();
+}
 
-  /// check if a file exist by that name
-  bool fileExistsUser = std::filesystem::exists(logPathUsers);
-  if (!fileExistsUser) {
-    /// add error message, that file doesn't exist
-    throw std::runtime_error("[ERROR] log file by name " + name + " doesn't exist");
-  } else {
-    /// if file exists return path
-    return logPathUsers.string();
+void CsvLogger::worker() {
+  /// compression is housekeeping, never compete with the io threads for CPU
+#if defined(_WIN32)
+  SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__)
+  setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+
+  while (true) {
+    std::filesystem::path job;
+    {
+      std::unique_lock lock{queueMtx_};
+      queueCv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (stopping_)
+        return;
+      job = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    try {
+      if (job.empty()) {
+        sweep();
+      } else {
+        compress(job);
+        applyRetention(job.parent_path(), logNameOf(job.filename().string()));
+      }
+    }
+    catch (const std::exception& e) {
+#ifdef DEBUG
+      std::cout << "Log housekeeping failed: " << e.what() << std::endl;
+#endif
+    }
+  }
+}
+
+/// Compresses every closed segment and applies retention to every log in all three folders.
+void CsvLogger::sweep() {
+  const std::string today = activeSystemLog();
+
+  for (const char* folder : folders) {
+    const std::filesystem::path dir = logRoot() / folder;
+    if (!std::filesystem::exists(dir))
+      continue;
+
+    std::vector<std::filesystem::path> closed;
+    std::vector<std::string> logNames;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+      const std::string file = entry.path().filename().string();
+      if (entry.path().extension() != ".csv")
+        continue;
+      const bool isSegment = file != logNameOf(file);
+      const bool isPastDay = std::string(folder) == "systemLogs" && file != today;
+      if (isSegment || isPastDay)
+        closed.push_back(entry.path());
+      logNames.push_back(logNameOf(file));
+    }
+
+    for (const auto& segment : closed)
+      compress(segment);
+
+    std::sort(logNames.begin(), logNames.end());
+    logNames.erase(std::unique(logNames.begin(), logNames.end()), logNames.end());
+    for (const auto& logName : logNames)
+      applyRetention(dir, logName);
+  }
+}
+
+void CsvLogger::compress(const std::filesystem::path& segment) {
+#ifdef HAS_ZLIB
+  {
+    const std::scoped_lock lock{mtx_};
+    if (!policy_.compress)
+      return;
+  }
+  if (isCompressed(segment) || !std::filesystem::exists(segment))
+    return;
+
+  const std::string tmp = segment.string() + ".gz.tmp";
+  {
+    std::ifstream in(segment, std::ios::binary);
+    gzFile out = gzopen(tmp.c_str(), "wb6");
+    if (!in || !out) {
+      if (out)
+        gzclose(out);
+      return;
+    }
+    char buf[64 * 1024];
+    while (in.read(buf, sizeof(buf)) || in.gcount() > 0)
+      gzwrite(out, buf, static_cast<unsigned>(in.gcount()));
+    gzclose(out);
   }
+
+  /// swap under the logger lock so a concurrent getXLog never sees both or neither
+  const std::scoped_lock lock{mtx_};
+  std::filesystem::rename(tmp, segment.string() + ".gz");
+  std::filesystem::remove(segment);
+#else
+  (void)segment;
+#endif
+}
+
+/// Deletes closed segments of one log that are too old, or too many.
+void CsvLogger::applyRetention(const std::filesystem::path& folder, const std::string& logName) {
+  const std::scoped_lock lock{mtx_};
+  auto segments = collect(folder, logName);
+
+  /// the active file is never deleted, unless it is the system log of a past day
+  const bool pastDay = folder.filename() == "systemLogs" && logName != activeSystemLog();
+  if (!segments.empty() && !pastDay) {
+    const std::string last = segments.back().filename().string();
+    if (last == logName || last == logName + ".gz")
+      segments.pop_back();
+  }
+
+  const auto now = std::filesystem::file_time_type::clock::now();
+  std::vector<std::filesystem::path> kept;
+  for (const auto& segment : segments) {
+    if (policy_.retention.count() && now - std::filesystem::last_write_time(segment) > policy_.retention)
+      std::filesystem::remove(segment);
+    else
+      kept.push_back(segment);
+  }
+
+  if (policy_.maxSegments && kept.size() > policy_.maxSegments)
+    for (std::size_t i = 0; i < kept.size() - policy_.maxSegments; ++i)
+      std::filesystem::remove(kept[i]);
 }
 
 /// returnere path til filen med den dato, som en streng
+std::string CsvLogger::getLogByDate(std::string date) {
+  return assemble("systemLogs", "Log_" + date + ".csv", "date " + date);
+}
+
+/// returnere path til filen med det navn, som en streng
+std::string CsvLogger::getLogByName(std::string name) {
+  return assemble("userLogs", "Log_" + name + ".csv", "name " + name);
+}
+
+/// returnere path til filen med den dør, som en streng
 std::string CsvLogger::getLogByDoor(std::string door) {
-  /// create log name as string
-  std::string logNameDoor = "Log_" + door + ".csv";
-
-  /// Get the path of the logs
-  std::filesystem::path currentPath = std::filesystem::current_path();
-  std::filesystem::path logPathDoors = currentPath / "logs" / "doorLogs" / logNameDoor;
-
-  /// check if a file exist by that door
-  bool fileExistsDoor = std::filesystem::exists(logPathDoors);
-  if (!fileExistsDoor) {
-    /// add error message, that file doesn't exist
-    throw std::runtime_error("[ERROR] log file by door " + door + " doesn't exist");
-  } else {
-    /// if file exists return path
-    return logPathDoors.string();
-  }
+  return assemble("doorLogs", "Log_" + door + ".csv", "door " + door);
 }
 
 /*!
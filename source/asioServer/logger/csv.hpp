@@ -1,11 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 class CsvLogger {
     public:
+        /// RotationPolicy decides when an active csv-file is closed into a segment
+        /// and how long closed segments are kept around
+        struct RotationPolicy {
+            std::uintmax_t maxBytes = 1024 * 1024;  /// rotate once the active file exceeds this size, 0 disables
+            std::chrono::hours maxAge{24 * 30};     /// rotate once the first record is older than this, 0 disables
+            std::chrono::hours retention{24 * 365}; /// delete closed segments older than this, 0 keeps forever
+            std::size_t maxSegments = 0;            /// closed segments kept per log, 0 keeps all
+            bool compress = true;                   /// gzip closed segments on the background thread
+        };
+
+        /// Durability decides when appended records are forced to disk with fdatasync
+        enum class Durability {
+            none,   /// leave it to the OS page cache
+            group,  /// one fdatasync per dirty file every groupInterval or groupRecords records
+            record  /// fdatasync before addLog/addAlert returns
+        };
+
+        struct DurabilityPolicy {
+            Durability mode = Durability::group;
+            std::chrono::milliseconds groupInterval{50};
+            std::size_t groupRecords = 64;
+        };
+
+        /// Commit metrics, latency is the time spent in fdatasync for one commit
+        struct Metrics {
+            uint64_t records{};
+            uint64_t commits{};
+            uint64_t maxBatch{};
+            uint64_t totalLatencyUs{};
+            uint64_t maxLatencyUs{};
+        };
+
+        CsvLogger();
+        ~CsvLogger();
+
+        /// setPolicy replaces the rotation policy and queues a sweep of all log folders
+        void setPolicy(const RotationPolicy& policy);
+
+        /// setDurability replaces the durability policy, starting or stopping the group commit thread
+        void setDurability(const DurabilityPolicy& durability);
+
+        Metrics metrics() const;
+        static std::string format(const Metrics& metrics, Durability mode);
+        Durability durability() const;
+
         /// addLog adds a new line in the csv-file for the corresponding date
         /// it adds data for these specs: Date, Time, Door, Name, UserID, Acces
+        /// sourceMs is the door client's clock for decisions it made offline, left empty for 0
         /// void addLog(const std::string& info);
-        void addLog(std::string door, std::string name, std::string userID, std::string access) const;
+        void addLog(std::string door, std::string name, std::string userID, std::string access, int64_t sourceMs = 0) const;
+
+        /// addAlert logs a door alert of the given kind to the system and door logs only,
+        /// so it never lands in a user's log or creates one
+        void addAlert(const std::string& door, const std::string& kind) const;
 
         /// getLogByName transfers the csv-file with the corresponding date
         /// to the admin pc using TCP
@@ -16,6 +79,64 @@ class CsvLogger {
 
         /// getLogByDoor transfers the csv-file withe the corresponding door name
         std::string getLogByDoor(std::string door);
-};
 
+    private:
+        /// addRow writes one record to the system and door logs, and to the user log of name if userLog
+        void addRow(const std::string& door, const std::string& name, const std::string& userID, const std::string& access,
+                    int64_t sourceMs, bool userLog) const;
+        /// writeRow appends one row to folder/logName, rotating the file first if the policy says so
+        void writeRow(const std::string& folder, const std::string& logName, const std::string& row,
+                      std::time_t now) const;
+        /// rotate closes the active file into a timestamped segment and queues it for compression
+        void rotate(const std::filesystem::path& active, std::time_t now) const;
+        /// collect returns every file belonging to a log, oldest segment first and the active file last
+        static std::vector<std::filesystem::path> collect(const std::filesystem::path& folder, const std::string& logName);
+        /// assemble concatenates every segment of a log into one file and returns its path
+        std::string assemble(const std::string& folder, const std::string& logName, const std::string& what);
+
+        /// returns a cached append-only descriptor for an active file, mtx_ must be held
+        int descriptor(const std::filesystem::path& path) const;
+        /// closes every cached descriptor, syncing dirty ones unless durability is none, mtx_ must be held
+        void closeAll() const;
+        void committer();
+        void commit() const;
+        void recordCommit(uint64_t batch, std::chrono::steady_clock::duration latency) const;
+
+        void worker();
+        void sweep();
+        void compress(const std::filesystem::path& segment);
+        void applyRetention(const std::filesystem::path& folder, const std::string& logName);
+
+        static std::filesystem::path logRoot();
+
+        RotationPolicy policy_;
 
+        mutable std::mutex mtx_;                                              /// Guards the csv-files and the segment cache
+        mutable std::unordered_map<std::string, std::time_t> segmentStart_; /// Time of the first record in each active file
+        mutable std::string lastDate_;                                        /// Used to notice when yesterday's system log closes
+
+        struct OpenLog {
+            int fd;
+            bool dirty;
+        };
+        mutable std::unordered_map<std::string, OpenLog> open_; /// Active files kept open between records
+        DurabilityPolicy durability_;
+        mutable std::atomic<uint64_t> pending_{0};             /// Records appended since the last commit
+
+        mutable std::atomic<uint64_t> records_{0};
+        mutable std::atomic<uint64_t> commits_{0};
+        mutable std::atomic<uint64_t> maxBatch_{0};
+        mutable std::atomic<uint64_t> totalLatencyUs_{0};
+        mutable std::atomic<uint64_t> maxLatencyUs_{0};
+
+        std::mutex commitMtx_;
+        mutable std::condition_variable commitCv_;
+        bool commitStopping_ = false;
+        std::thread committer_;
+
+        mutable std::mutex queueMtx_;
+        mutable std::condition_variable queueCv_;
+        mutable std::deque<std::filesystem::path> queue_; /// Closed segments awaiting compression, empty path means full sweep
+        bool stopping_ = false;
+        std::thread worker_;
+};
@@ -0,0 +1,60 @@
+#include "logclock.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+namespace {
+  struct Cache {
+    std::time_t second = -1;
+    std::string date;
+    std::string time;
+    std::string fileSuffix;
+    std::string minute; /// hh:mm:ss without millis
+    LogClock::Local local{};
+  };
+  thread_local Cache cache;
+
+  /// refresh only formats date and time when the second changes
+  void refresh(const std::time_t seconds) {
+    if (seconds == cache.second)
+      return;
+    std::tm datetime{};
+#ifdef _WIN32
+    localtime_s(&datetime, &seconds);
+#else
+    localtime_r(&seconds, &datetime);
+#endif
+    char buf[32];
+    strftime(buf, sizeof(buf), "%d/%m/%Y", &datetime);
+    cache.date = buf;
+    strftime(buf, sizeof(buf), "%H:%M:%S", &datetime);
+    cache.minute = buf;
+    strftime(buf, sizeof(buf), "%Y_%m_%d", &datetime);
+    cache.fileSuffix = buf;
+    cache.local.minuteOfWeek = ((datetime.tm_wday + 6) % 7) * 24 * 60 + datetime.tm_hour * 60 + datetime.tm_min;
+    cache.local.day = static_cast<int32_t>(std::chrono::sys_days{
+        std::chrono::year{datetime.tm_year + 1900} / (datetime.tm_mon + 1) / datetime.tm_mday}.time_since_epoch().count());
+    cache.second = seconds;
+  }
+}
+
+LogClock::Stamp LogClock::now() {
+  const auto wall = std::chrono::system_clock::now();
+  const auto mono = std::chrono::steady_clock::now();
+  const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(wall.time_since_epoch()).count();
+  const std::time_t seconds = static_cast<std::time_t>(ms / 1000);
+  refresh(seconds);
+
+  /// millis change every call, patch them onto the cached seconds
+  char millis[8];
+  std::snprintf(millis, sizeof(millis), ".%03d", static_cast<int>(ms % 1000));
+  cache.time.assign(cache.minute).append(millis);
+
+  return {cache.date, cache.time, cache.fileSuffix, seconds,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(mono.time_since_epoch()).count()};
+}
+
+LogClock::Local LogClock::local() {
+  refresh(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+  return cache.local;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+/// Timestamps for log records.
+/// localtime and strftime only run once per second per thread, every other call reuses the cached strings.
+class LogClock {
+    public:
+        struct Stamp {
+            const std::string& date;       /// dd/mm/yyyy
+            const std::string& time;       /// hh:mm:ss.mmm
+            const std::string& fileSuffix; /// yyyy_mm_dd, used for the system log name
+            std::time_t seconds;           /// wall clock, whole seconds
+            int64_t monoNs;                /// steady clock, orders events the wall clock can't
+        };
+
+        struct Local {
+            int minuteOfWeek; /// 0 is monday 00:00
+            int32_t day;      /// days since 01/01/1970
+        };
+
+        /// now returns references into a thread_local cache, they stay valid until the next call on the same thread
+        static Stamp now();
+
+        /// local returns the local minute of the week and date from the same cache, without formatting anything
+        static Local local();
+};
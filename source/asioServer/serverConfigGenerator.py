@@ -0,0 +1,33 @@
+import json
+import random
+import sys
+
+# Writes a config.json with many users for load testing config ingestion.
+# Usage: python serverConfigGenerator.py <users> [path] [rules]
+# With rules, users get one of 200 groups, doors one of 20 zones, and that many random allow/deny rules are added.
+# Start a DEBUG build next to it - it prints the config load time, rule publish time and peak RSS after loading.
+# Delete config.bin first to measure the config.json import instead of the snapshot.
+
+users = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+path = sys.argv[2] if len(sys.argv) > 2 else "config.json"
+rules = int(sys.argv[3]) if len(sys.argv) > 3 else 0
+
+config = {
+    "doors": [{"name": "maindoor", "lvl": 2}] + [{"name": f"door{i}", "lvl": i % 5 + 1} for i in range(50)],
+    "users": [{"name": f"user_{i}", "uid": f"{i:08x}", "lvl": i % 5 + 1} for i in range(users)],
+}
+
+if rules:
+    random.seed(1)
+    for i, door in enumerate(config["doors"]):
+        door["zone"] = f"zone_{i % 20}"
+    for i, user in enumerate(config["users"]):
+        user["group"] = f"group_{i % 200}"
+    config["rules"] = [{"effect": random.choice(["allow", "allow", "allow", "deny"]),
+                        "group": f"group_{random.randrange(200)}" if random.randrange(50) else "*",
+                        "zone": f"zone_{random.randrange(20)}" if random.randrange(50) else "*"}
+                       for _ in range(rules)]
+
+with open(path, "w") as f:
+    json.dump(config, f, indent=4)
+print(f"Wrote {users} users and {rules} rules to {path}")
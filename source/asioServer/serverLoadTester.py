@@ -0,0 +1,78 @@
+import random
+import socket
+import sys
+import threading
+import time
+
+# Emulates many door clients scanning as fast as the server answers.
+# Usage: python serverLoadTester.py <ip> <clients> <scans per client> <door> <uid> [cli name] [foreign %]
+# When a cli name is given, getMetrics is fetched over the CLI port afterwards.
+# foreign % of the scans use random UIDs, like transit passes and phones held to a street-facing reader.
+
+ip = sys.argv[1] if len(sys.argv) > 1 else input("Input ip: ").strip()
+clients = int(sys.argv[2]) if len(sys.argv) > 2 else 4
+scans = int(sys.argv[3]) if len(sys.argv) > 3 else 1000
+door = sys.argv[4] if len(sys.argv) > 4 else "maindoor"
+uid = sys.argv[5] if len(sys.argv) > 5 else "6a13ba66"
+cli_name = sys.argv[6] if len(sys.argv) > 6 and sys.argv[6] != "-" else None
+foreign = float(sys.argv[7]) if len(sys.argv) > 7 else 0
+
+latencies = []
+lock = threading.Lock()
+
+
+def client():
+    s = socket.create_connection((ip, 9000))
+    s.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    f = s.makefile("rb")
+    local = []
+    for _ in range(scans):
+        start = time.perf_counter()
+        scanned = f"{random.getrandbits(32):08x}" if random.random() * 100 < foreign else uid
+        s.sendall(f"{door}:{scanned}\n".encode())
+        f.readline()
+        local.append(time.perf_counter() - start)
+    s.close()
+    with lock:
+        latencies.extend(local)
+
+
+def cli_command(cmd):
+    s = socket.create_connection((ip, 9001))
+    s.settimeout(1)
+    f = s.makefile("rb")
+    f.readline()  # Input CLI Identification
+    s.sendall(f"{cli_name}\n".encode())
+    f.readline()  # CLI is ready
+    s.sendall(f"{cmd}\n".encode())
+    out = b""
+    try:
+        while True:
+            chunk = s.recv(4096)
+            if not chunk:
+                break
+            out += chunk
+    except socket.timeout:
+        pass
+    s.sendall(b"exit\n")
+    s.close()
+    return out.decode().replace("type:string%%%", "")
+
+
+threads = [threading.Thread(target=client) for _ in range(clients)]
+start = time.perf_counter()
+for t in threads:
+    t.start()
+for t in threads:
+    t.join()
+elapsed = time.perf_counter() - start
+
+latencies.sort()
+total = len(latencies)
+print(f"{total} scans from {clients} clients in {elapsed:.2f}s -> {total / elapsed:.0f} scans/s")
+for p in (50, 90, 99, 100):
+    idx = min(total - 1, int(total * p / 100))
+    print(f"p{p}: {latencies[idx] * 1e6:.0f}us")
+
+if cli_name:
+    print(cli_command("getMetrics"))
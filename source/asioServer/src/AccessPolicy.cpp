@@ -0,0 +1,145 @@
+#include "AccessPolicy.hpp"
+
+#include <algorithm>
+
+#include "json.hpp"
+#include "TcpConnection.hpp" // DEBUG_OUT
+
+const char* AccessPolicy::name(const Effect effect) {
+	switch (effect) {
+		case Effect::allow:
+			return "allow";
+		case Effect::deny:
+			return "deny";
+		default:
+			return "none";
+	}
+}
+
+std::string AccessPolicy::format(const Rule& rule) {
+	return std::string(name(rule.effect)) + ' ' + rule.group + ' ' + rule.zone;
+}
+
+void AccessPolicy::load(const std::string& json) {
+	rules_.clear();
+	const nlohmann::json parsed = nlohmann::json::parse(json, nullptr, false);
+	if (!parsed.is_array())
+		return;
+
+	rules_.reserve(parsed.size());
+	for (const auto& entry : parsed) {
+		const std::string effect = entry.is_object() ? entry.value("effect", "") : "";
+		const std::string group  = entry.is_object() ? entry.value("group", "") : "";
+		const std::string zone   = entry.is_object() ? entry.value("zone", "") : "";
+		if ((effect != "allow" && effect != "deny") || group.empty() || zone.empty()) {
+			DEBUG_OUT("Invalid rule in config.json - skipping one.\n");
+			continue;
+		}
+		rules_.push_back({effect == "allow" ? Effect::allow : Effect::deny, group, zone});
+	}
+}
+
+std::string AccessPolicy::json() const {
+	nlohmann::json out = nlohmann::json::array();
+	for (const auto& rule : rules_)
+		out.push_back({{"effect", name(rule.effect)}, {"group", rule.group}, {"zone", rule.zone}});
+	return out.dump();
+}
+
+bool AccessPolicy::add(const Rule& rule) {
+	if (std::ranges::find(rules_, rule) != rules_.end())
+		return false;
+	rules_.push_back(rule);
+	return true;
+}
+
+size_t AccessPolicy::remove(const std::string& group, const std::string& zone) {
+	return std::erase_if(rules_, [&](const Rule& rule) { return rule.group == group && rule.zone == zone; });
+}
+
+std::string AccessPolicy::describe() const {
+	if (rules_.empty())
+		return "No rules - levels decide at every door";
+
+	std::string out = "Rules (deny wins over allow):";
+	for (const auto& rule : rules_)
+		out += "\n  " + format(rule);
+	return out;
+}
+
+void AccessPolicy::publish(const UserTable& users, ConfigSnapshot::Doors& doors) {
+	// New zones get the next ID, 0 is for doors without a zone
+	for (auto& [name, door] : doors) {
+		if (door.zone.empty()) {
+			door.zoneId = 0;
+			continue;
+		}
+		auto zone = zoneIds_.find(door.zone);
+		if (zone == zoneIds_.end()) {
+			if (zones_.size() > UINT16_MAX) {
+				DEBUG_OUT("More than 65535 zones - door " + name + " is treated as a door without a zone.\n");
+				door.zoneId = 0;
+				continue;
+			}
+			zones_.push_back(door.zone);
+			zone = zoneIds_.emplace(door.zone, static_cast<uint16_t>(zones_.size() - 1)).first;
+		}
+		door.zoneId = zone->second;
+	}
+
+	rows_    = users.groupCount();
+	columns_ = zones_.size();
+	matrix_.assign((rows_ * columns_ + 31) / 32, 0);
+
+	auto set = [this](const size_t group, const size_t zone, const Effect effect) {
+		const size_t cell = group * columns_ + zone;
+		uint64_t& word    = matrix_[cell / 32];
+		const int shift   = cell % 32 * 2;
+		// Effect values are ordered so the larger one wins, deny over allow over none
+		if (static_cast<uint64_t>(effect) > (word >> shift & 3))
+			word = (word & ~(uint64_t{3} << shift)) | static_cast<uint64_t>(effect) << shift;
+	};
+
+	for (const auto& rule : rules_) {
+		size_t firstGroup = 0, lastGroup = rows_;
+		if (rule.group != "*") {
+			firstGroup = users.findGroup(rule.group);
+			lastGroup  = firstGroup + 1;
+			if (firstGroup == UserTable::noGroup_)
+				continue; // No user is in this group yet
+		}
+		size_t firstZone = 0, lastZone = columns_;
+		if (rule.zone != "*") {
+			const auto zone = zoneIds_.find(rule.zone);
+			if (zone == zoneIds_.end())
+				continue; // No door is in this zone yet
+			firstZone = zone->second;
+			lastZone  = firstZone + 1;
+		}
+
+		for (size_t group = firstGroup; group < lastGroup; ++group)
+			for (size_t zone = firstZone; zone < lastZone; ++zone)
+				set(group, zone, rule.effect);
+	}
+}
+
+uint16_t AccessPolicy::findZone(const std::string_view zone) const {
+	const auto id = zoneIds_.find(std::string(zone));
+	return id == zoneIds_.end() ? 0 : id->second;
+}
+
+std::string AccessPolicy::explain(const std::string_view group, const std::string_view zone) const {
+	Effect effect   = Effect::none;
+	std::string out = "  rules:";
+	for (const auto& rule : rules_) {
+		if (!matches(rule.group, group) || !matches(rule.zone, zone))
+			continue;
+		out += "\n    " + format(rule);
+		effect = std::max(effect, rule.effect);
+	}
+	if (effect == Effect::none)
+		out += " none apply, the levels decide";
+	else
+		out += "\n  rule effect: " + std::string(name(effect));
+	return out;
+}
@@ -0,0 +1,251 @@
+#include "AccessStats.hpp"
+
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "json.hpp"
+#include "TcpConnection.hpp" // DEBUG_OUT
+
+AccessStats::AccessStats(std::string checkpointPath, const std::chrono::seconds checkpointInterval) : checkpointPath_(std::move(checkpointPath)),
+																									  checkpointInterval_(checkpointInterval) {
+	restore();
+	worker_ = std::thread([this] { worker(); });
+}
+
+/// Destructor\n
+/// Stops the checkpoint thread and writes a final checkpoint.
+AccessStats::~AccessStats() {
+	{
+		const std::scoped_lock lock{stopMtx_};
+		stopping_ = true;
+	}
+	stopCv_.notify_all();
+	if (worker_.joinable())
+		worker_.join();
+	checkpoint();
+}
+
+/// Records one decision. Called from the decision path, so it never blocks on other threads once the key is known.
+/// @param door name of the door the scan happened at.
+/// @param user name of the scanned user, empty if the UID was unknown.
+/// @param outcome approved_, denied_ or unknown_.
+/// @returns void
+void AccessStats::record(const std::string& door, const std::string& user, const Outcome outcome) const {
+	Shard& shard      = localShard();
+	const int64_t now = currentHour();
+
+	shard.find(shard.doors, door).add(now, outcome);
+	if (!user.empty())
+		shard.find(shard.users, user).add(now, outcome);
+}
+
+void AccessStats::Counters::add(const int64_t hour, const Outcome outcome) {
+	// Only the owning thread writes, so resetting a stale bucket needs no CAS.
+	Bucket& bucket = buckets[hour % bucketCount_];
+	if (bucket.hour.load(std::memory_order_relaxed) != hour) {
+		for (auto& count : bucket.count)
+			count.store(0, std::memory_order_relaxed);
+		bucket.hour.store(hour, std::memory_order_release);
+	}
+	bucket.count[outcome].fetch_add(1, std::memory_order_relaxed);
+	total[outcome].fetch_add(1, std::memory_order_relaxed);
+}
+
+AccessStats::Counters& AccessStats::Shard::find(std::unordered_map<std::string, std::unique_ptr<Counters>>& map, const std::string& key) {
+	// Lookup without the lock is safe since this thread is the only one inserting.
+	const auto it = map.find(key);
+	if (it != map.end())
+		return *it->second;
+
+	const std::scoped_lock lock{mtx};
+	return *map.emplace(key, std::make_unique<Counters>()).first->second;
+}
+
+AccessStats::Shard& AccessStats::localShard() const {
+	thread_local const AccessStats* owner = nullptr;
+	thread_local Shard* shard             = nullptr;
+
+	if (owner != this) {
+		const std::scoped_lock lock{shardsMtx_};
+		shard = shards_.emplace_back(std::make_unique<Shard>()).get();
+		owner = this;
+	}
+	return *shard;
+}
+
+int64_t AccessStats::currentHour() {
+	return std::chrono::duration_cast<std::chrono::hours>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/// Merges every thread's counters.\n
+/// Cost is shards * keys * buckets, independent of how many decisions were logged.
+/// @param hours window of hourly buckets to sum, 0 for lifetime totals.
+/// @returns Report sorted by name.
+AccessStats::Report AccessStats::merge(const uint32_t hours) const {
+	Report report;
+	const int64_t now = currentHour();
+
+	auto mergeMap = [&](const std::unordered_map<std::string, std::unique_ptr<Counters>>& from, std::map<std::string, Totals>& into) {
+		for (const auto& [key, counters] : from) {
+			Totals& totals = into[key];
+			if (hours == 0) {
+				totals.approved += counters->total[approved_].load(std::memory_order_relaxed);
+				totals.denied += counters->total[denied_].load(std::memory_order_relaxed);
+				totals.unknown += counters->total[unknown_].load(std::memory_order_relaxed);
+				continue;
+			}
+			for (const auto& bucket : counters->buckets) {
+				const int64_t hour = bucket.hour.load(std::memory_order_acquire);
+				if (hour <= now - hours || hour > now)
+					continue;
+				totals.approved += bucket.count[approved_].load(std::memory_order_relaxed);
+				totals.denied += bucket.count[denied_].load(std::memory_order_relaxed);
+				totals.unknown += bucket.count[unknown_].load(std::memory_order_relaxed);
+			}
+		}
+	};
+
+	const std::scoped_lock lock{shardsMtx_};
+	for (const auto& shard : shards_) {
+		const std::scoped_lock shardLock{shard->mtx};
+		mergeMap(shard->doors, report.doors);
+		mergeMap(shard->users, report.users);
+	}
+	return report;
+}
+
+std::string AccessStats::format(const Report& report) {
+	std::string out = "approved/denied/unknown";
+	auto formatMap  = [&out](const std::string& title, const std::map<std::string, Totals>& map) {
+		out += "\n" + title + ":";
+		for (const auto& [name, totals] : map)
+			out += "\n  " + name + ": " + std::to_string(totals.approved) + '/' + std::to_string(totals.denied) + '/' +
+				std::to_string(totals.unknown);
+	};
+	formatMap("Doors", report.doors);
+	formatMap("Users", report.users);
+	return out;
+}
+
+/// Writes lifetime totals and all live hourly buckets to checkpointPath_.\n
+/// Uses a temporary file and rename like config.json, so a crash mid-write keeps the previous checkpoint.
+/// @returns void
+void AccessStats::checkpoint() const {
+	nlohmann::json out = {{"doors", nlohmann::json::object()}, {"users", nlohmann::json::object()}};
+	const int64_t now  = currentHour();
+
+	auto dumpMap = [&](const std::unordered_map<std::string, std::unique_ptr<Counters>>& from, nlohmann::json& into) {
+		for (const auto& [key, counters] : from) {
+			auto& entry = into[key];
+			if (!entry.contains("total")) {
+				entry["total"]   = {0, 0, 0};
+				entry["buckets"] = nlohmann::json::object();
+			}
+			for (int i = 0; i < 3; ++i)
+				entry["total"][i] = entry["total"][i].get<uint64_t>() + counters->total[i].load(std::memory_order_relaxed);
+
+			for (const auto& bucket : counters->buckets) {
+				const int64_t hour = bucket.hour.load(std::memory_order_acquire);
+				if (hour <= now - bucketCount_ || hour > now)
+					continue;
+				auto& slot = entry["buckets"][std::to_string(hour)];
+				if (slot.is_null())
+					slot = {0, 0, 0};
+				for (int i = 0; i < 3; ++i)
+					slot[i] = slot[i].get<uint64_t>() + bucket.count[i].load(std::memory_order_relaxed);
+			}
+		}
+	};
+
+	{
+		const std::scoped_lock lock{shardsMtx_};
+		for (const auto& shard : shards_) {
+			const std::scoped_lock shardLock{shard->mtx};
+			dumpMap(shard->doors, out["doors"]);
+			dumpMap(shard->users, out["users"]);
+		}
+	}
+
+	try {
+		const std::string tmp = checkpointPath_ + ".tmp";
+		{
+			std::ofstream file{tmp};
+			file << out.dump();
+		}
+		std::filesystem::rename(tmp, checkpointPath_);
+	}
+	catch (const std::exception& e) {
+		DEBUG_OUT("Stats checkpoint failed: " + std::string(e.what()));
+	}
+}
+
+/// Loads the last checkpoint into a shard no thread writes to, so restarts don't reset the numbers.\n
+/// A checkpoint that doesn't parse or holds anything but non-negative numbers is dropped as a whole.
+/// @returns void
+void AccessStats::restore() {
+	std::ifstream file{checkpointPath_};
+	if (!file.is_open())
+		return;
+
+	auto restored = std::make_unique<Shard>();
+	try {
+		nlohmann::json in;
+		file >> in;
+		if (!in.is_object())
+			throw std::invalid_argument("root is not an object");
+
+		const auto count = [](const nlohmann::json& value) {
+			if (!value.is_number_unsigned())
+				throw std::invalid_argument("count is not a non-negative integer");
+			return value.get<uint64_t>();
+		};
+		const auto loadMap = [&count](const nlohmann::json& from, std::unordered_map<std::string, std::unique_ptr<Counters>>& into) {
+			if (!from.is_object())
+				return;
+			for (const auto& [key, entry] : from.items()) {
+				if (!entry.is_object())
+					throw std::invalid_argument("entry of " + key + " is not an object");
+				auto counters = std::make_unique<Counters>();
+				if (entry.contains("total") && entry["total"].is_array() && entry["total"].size() == 3)
+					for (int i = 0; i < 3; ++i)
+						counters->total[i] = count(entry["total"][i]);
+				if (entry.contains("buckets") && entry["buckets"].is_object())
+					for (const auto& [hourKey, counts] : entry["buckets"].items()) {
+						int64_t hour{};
+						const auto [end, ec] = std::from_chars(hourKey.data(), hourKey.data() + hourKey.size(), hour);
+						if (ec != std::errc{} || end != hourKey.data() + hourKey.size() || hour < 0 || !counts.is_array())
+							throw std::invalid_argument("invalid bucket " + hourKey + " of " + key);
+						Bucket& bucket = counters->buckets[hour % bucketCount_];
+						bucket.hour    = hour;
+						for (int i = 0; i < 3 && i < static_cast<int>(counts.size()); ++i)
+							bucket.count[i] = count(counts[i]);
+					}
+				into.emplace(key, std::move(counters));
+			}
+		};
+		loadMap(in.value("doors", nlohmann::json::object()), restored->doors);
+		loadMap(in.value("users", nlohmann::json::object()), restored->users);
+	}
+	catch (const nlohmann::json::exception& e) {
+		DEBUG_OUT("Invalid stats checkpoint, starting from zero - " + std::string(e.what()));
+		return;
+	}
+	catch (const std::exception& e) {
+		DEBUG_OUT("Invalid stats checkpoint, starting from zero - " + std::string(e.what()));
+		return;
+	}
+
+	const std::scoped_lock lock{shardsMtx_};
+	shards_.push_back(std::move(restored));
+}
+
+void AccessStats::worker() {
+	std::unique_lock lock{stopMtx_};
+	while (!stopCv_.wait_for(lock, checkpointInterval_, [this] { return stopping_; })) {
+		lock.unlock();
+		checkpoint();
+		lock.lock();
+	}
+}
@@ -0,0 +1,391 @@
+#include "ConfigFile.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "json.hpp"
+#include "TcpConnection.hpp" // DEBUG_OUT
+
+namespace {
+	/// SAX handler for config.json.\n
+	/// Depth 1 is the root object, depth 2 the "users"/"doors"/"revoked"/"rules" arrays and the "logs"/"schedules" objects, depth 3 one user
+	/// or door and depth 4 the "cards" array of a user.
+	/// Only the entry currently being parsed is held in memory. The small "logs", "rules" and "schedules" sections are kept whole.
+	class ConfigSax final : public nlohmann::json_sax<nlohmann::json> {
+	public:
+		ConfigSax(ConfigSnapshot::Doors& doors, UserTable& users, std::vector<std::string>& revoked) : doors_(doors),
+																									   users_(users),
+																									   revoked_(revoked) {}
+
+		std::string logs() const {
+			return logs_.dump();
+		}
+
+		std::string schedules() const {
+			return schedules_.dump();
+		}
+
+		std::string rules() const {
+			return rules_.dump();
+		}
+
+		bool null() override {
+			return value(nullptr);
+		}
+
+		bool boolean(const bool val) override {
+			return value(val);
+		}
+
+		bool number_integer(const number_integer_t val) override {
+			if (inEntry() && field_ == "lvl") {
+				entry_.lvl    = val;
+				entry_.hasLvl = true;
+				return true;
+			}
+			if (inEntry() && section_ == usersSection && field_ == "expires" && val > 0 && val <= UINT32_MAX) {
+				entry_.expires = static_cast<uint32_t>(val);
+				return true;
+			}
+			return value(val);
+		}
+
+		bool number_unsigned(const number_unsigned_t val) override {
+			return number_integer(static_cast<number_integer_t>(val));
+		}
+
+		bool number_float(const number_float_t val, const string_t&) override {
+			return value(val);
+		}
+
+		bool string(string_t& val) override {
+			if (inCards_) {
+				entry_.cards.push_back(std::move(val));
+				return true;
+			}
+			if (depth_ == 2 && section_ == revokedSection) {
+				revoked_.push_back(std::move(val));
+				return true;
+			}
+			if (inEntry() && field_ == "name") {
+				entry_.name    = std::move(val);
+				entry_.hasName = true;
+				return true;
+			}
+			if (inEntry() && field_ == "uid") {
+				entry_.uid = std::move(val);
+				return true;
+			}
+			if (inEntry() && section_ == doorsSection && field_ == "schedule") {
+				entry_.schedule = std::move(val);
+				return true;
+			}
+			if (inEntry() && section_ == doorsSection && field_ == "zone") {
+				entry_.zone = std::move(val);
+				return true;
+			}
+			if (inEntry() && section_ == doorsSection && field_ == "direction" && (val == "in" || val == "out")) {
+				entry_.direction = val == "in" ? ConfigSnapshot::Door::Direction::entry : ConfigSnapshot::Door::Direction::exit;
+				return true;
+			}
+			if (inEntry() && section_ == usersSection && field_ == "group") {
+				entry_.group = std::move(val);
+				return true;
+			}
+			return value(val);
+		}
+
+		bool binary(binary_t&) override {
+			return value(nullptr);
+		}
+
+		bool start_object(std::size_t) override {
+			++depth_;
+			if (capture(nlohmann::json::object()))
+				return true;
+			if (depth_ == 3 && (section_ == usersSection || section_ == doorsSection))
+				entry_ = {};
+			else if (depth_ > 3 && section_ != otherSection)
+				entry_.valid = false; // users and doors only hold flat values
+			return true;
+		}
+
+		bool end_object() override {
+			if (!captured_.empty())
+				captured_.pop_back();
+			else if (depth_ == 3 && (section_ == usersSection || section_ == doorsSection))
+				insert();
+			--depth_;
+			field_.clear();
+			return true;
+		}
+
+		bool start_array(std::size_t) override {
+			++depth_;
+			if (capture(nlohmann::json::array()))
+				return true;
+			if (depth_ == 4 && section_ == usersSection && field_ == "cards")
+				inCards_ = true;
+			else if (depth_ > 2 && (section_ == usersSection || section_ == doorsSection))
+				entry_.valid = false;
+			return true;
+		}
+
+		bool end_array() override {
+			if (!captured_.empty())
+				captured_.pop_back();
+			else if (depth_ == 4)
+				inCards_ = false;
+			--depth_;
+			return true;
+		}
+
+		bool key(string_t& val) override {
+			if (depth_ == 1) {
+				section_ = val == "users"       ? usersSection
+						   : val == "doors"     ? doorsSection
+						   : val == "logs"      ? logsSection
+						   : val == "revoked"   ? revokedSection
+						   : val == "rules"     ? rulesSection
+						   : val == "schedules" ? schedulesSection
+						   : otherSection;
+				return true;
+			}
+			field_ = std::move(val);
+			return true;
+		}
+
+		bool parse_error([[maybe_unused]] std::size_t position, const std::string&, [[maybe_unused]] const nlohmann::detail::exception& e) override {
+			DEBUG_OUT("Invalid JSON in config.json at byte " + std::to_string(position) + " - " + std::string(e.what()));
+			return false;
+		}
+
+	private:
+		enum Section { otherSection, usersSection, doorsSection, logsSection, revokedSection, rulesSection, schedulesSection };
+
+		struct Entry {
+			std::string name;
+			std::string uid;
+			std::string schedule;
+			std::string zone;
+			std::string group;
+			ConfigSnapshot::Door::Direction direction{};
+			std::vector<std::string> cards;
+			int64_t lvl{};
+			uint32_t expires{};
+			bool hasName{false};
+			bool hasLvl{false};
+			bool valid{true};
+		};
+
+		bool inEntry() const {
+			return depth_ == 3 && (section_ == usersSection || section_ == doorsSection);
+		}
+
+		/// Opens a nested object or array inside "logs", "rules" or "schedules", or the section itself.
+		/// @returns false outside those sections, or for a section of the wrong type.
+		bool capture(nlohmann::json container) {
+			if (depth_ == 2 && (section_ == logsSection || section_ == rulesSection || section_ == schedulesSection)) {
+				nlohmann::json& section = section_ == logsSection ? logs_ : section_ == rulesSection ? rules_ : schedules_;
+				if (container.type() != section.type())
+					return false;
+				captured_.push_back(&section);
+				return true;
+			}
+			if (captured_.empty())
+				return false;
+			nlohmann::json& parent = *captured_.back();
+			captured_.push_back(parent.is_array() ? &parent.emplace_back(std::move(container)) : &(parent[field_] = std::move(container)));
+			return true;
+		}
+
+		/// Any value that isn't a valid name/uid/lvl/schedule/zone/direction/group/expires/card.
+		/// Inside an entry it invalidates the entry, inside "logs", "rules" or "schedules" it is kept.
+		bool value(nlohmann::json val) {
+			if (!captured_.empty()) {
+				nlohmann::json& parent = *captured_.back();
+				if (parent.is_array())
+					parent.push_back(std::move(val));
+				else
+					parent[field_] = std::move(val);
+			} else if (inCards_ || (inEntry() && (field_ == "name" || field_ == "uid" || field_ == "lvl" || field_ == "schedule" ||
+												  field_ == "zone" || field_ == "direction" || field_ == "group" ||
+												  field_ == "expires")))
+				entry_.valid = false;
+			return true;
+		}
+
+		void insert() {
+			if (section_ == doorsSection) {
+				if (entry_.valid && entry_.hasName && entry_.hasLvl)
+					doors_[entry_.name] = {static_cast<int>(entry_.lvl), std::move(entry_.schedule), std::move(entry_.zone), entry_.direction};
+				else
+					DEBUG_OUT("Invalid door entry in config.json - skipping one.\n");
+				return;
+			}
+
+			// "uid" is the first card, "cards" holds any further ones. A user may have no card left after revocations.
+			if (!entry_.valid || !entry_.hasName || !entry_.hasLvl) {
+				DEBUG_OUT("Invalid user entry in config.json - skipping one.\n");
+				return;
+			}
+			const UserTable::Id id = users_.add(entry_.name, entry_.uid, static_cast<int>(entry_.lvl));
+			if (id == UserTable::none_) {
+				DEBUG_OUT("Duplicate user name or UID in config.json - skipping one.\n");
+				return;
+			}
+			users_.setGroup(id, users_.internGroup(entry_.group));
+			users_.setExpires(id, entry_.expires);
+			for (const auto& card : entry_.cards)
+				if (!users_.addCard(id, card))
+					DEBUG_OUT("Duplicate card " + card + " in config.json - skipping it.\n");
+		}
+
+		ConfigSnapshot::Doors& doors_;
+		UserTable& users_;
+		std::vector<std::string>& revoked_;
+		nlohmann::json logs_      = nlohmann::json::object();
+		nlohmann::json schedules_ = nlohmann::json::object();
+		nlohmann::json rules_     = nlohmann::json::array();
+		std::vector<nlohmann::json*> captured_; // Open objects and arrays inside "logs", "rules" or "schedules", innermost last
+
+		int depth_ = 0;
+		Section section_ = otherSection;
+		bool inCards_    = false;
+		std::string field_;
+		Entry entry_;
+	};
+
+	std::string quoted(const std::string_view str) {
+		return nlohmann::json(str).dump();
+	}
+}
+
+/// Parses config.json with one pass of the SAX parser, inserting entries as soon as their object closes.
+/// @returns loaded, missing or invalid. On invalid the tables are cleared like a fresh start.
+ConfigFile::Result ConfigFile::load(const std::string& path, ConfigSnapshot::Doors& doors, UserTable& users,
+									std::vector<std::string>& revoked, std::string& logs, std::string& schedules, std::string& rules) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open() || file.peek() == std::ifstream::traits_type::eof())
+		return Result::missing;
+
+	ConfigSax sax(doors, users, revoked);
+	if (!nlohmann::json::sax_parse(file, &sax)) {
+		doors.clear();
+		users.clear();
+		revoked.clear();
+		logs      = "{}";
+		schedules = "{}";
+		rules     = "[]";
+		return Result::invalid;
+	}
+	logs      = sax.logs();
+	schedules = sax.schedules();
+	rules     = sax.rules();
+	return Result::loaded;
+}
+
+/// Writes config.json from the tables. No DOM is built, only the small "logs", "rules" and "schedules" sections are parsed to pretty-print them.
+/// @returns true on success.
+bool ConfigFile::save(const std::string& path, const ConfigSnapshot::Doors& doors, const UserTable& users,
+					  const std::vector<std::string>& revoked, const std::string& logs, const std::string& schedules,
+					  const std::string& rules) {
+	std::vector<const ConfigSnapshot::Doors::value_type*> sortedDoors;
+	sortedDoors.reserve(doors.size());
+	for (const auto& door : doors)
+		sortedDoors.push_back(&door);
+	std::ranges::sort(sortedDoors, {}, [](const auto* door) { return door->first; });
+
+	std::vector<UserTable::Id> sortedUsers;
+	sortedUsers.reserve(users.size());
+	users.forEach([&sortedUsers](const UserTable::Id id) { sortedUsers.push_back(id); });
+	std::ranges::sort(sortedUsers, {}, [&users](const UserTable::Id id) { return users.name(id); });
+
+	const std::string tmp = path + ".tmp";
+	{
+		std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+		if (!out)
+			return false;
+
+		out << "{\n    \"doors\": [";
+		for (size_t i = 0; i < sortedDoors.size(); ++i) {
+			const auto& [name, door] = *sortedDoors[i];
+			out << (i ? "," : "") << "\n        {\n";
+			if (door.direction != ConfigSnapshot::Door::Direction::none)
+				out << "            \"direction\": " << (door.direction == ConfigSnapshot::Door::Direction::entry ? "\"in\"" : "\"out\"") << ",\n";
+			out << "            \"lvl\": " << door.lvl << ",\n"
+				<< "            \"name\": " << quoted(name);
+			if (!door.schedule.empty())
+				out << ",\n            \"schedule\": " << quoted(door.schedule);
+			if (!door.zone.empty())
+				out << ",\n            \"zone\": " << quoted(door.zone);
+			out << "\n        }";
+		}
+		out << (sortedDoors.empty() ? "]" : "\n    ]");
+
+		// Small sections kept as JSON text, written at the root indentation and only when non-empty
+		auto writeSection = [&out](const char* key, const std::string& text) {
+			const nlohmann::json parsed = nlohmann::json::parse(text, nullptr, false);
+			if (!parsed.is_structured() || parsed.empty())
+				return;
+			std::string pretty = parsed.dump(4);
+			for (size_t pos = pretty.find('\n'); pos != std::string::npos; pos = pretty.find('\n', pos + 1))
+				pretty.insert(pos + 1, "    ");
+			out << ",\n    \"" << key << "\": " << pretty;
+		};
+
+		writeSection("logs", logs);
+
+		if (!revoked.empty()) {
+			out << ",\n    \"revoked\": [";
+			for (size_t i = 0; i < revoked.size(); ++i)
+				out << (i ? "," : "") << "\n        " << quoted(revoked[i]);
+			out << "\n    ]";
+		}
+
+		writeSection("rules", rules);
+		writeSection("schedules", schedules);
+
+		out << ",\n    \"users\": [";
+		for (size_t i = 0; i < sortedUsers.size(); ++i) {
+			const UserTable::Id id = sortedUsers[i];
+			out << (i ? "," : "") << "\n        {\n";
+
+			// First card goes to "uid" like before multiple cards existed, the rest to "cards"
+			std::string cards;
+			bool first = true;
+			users.forEachCard(id, [&](const std::string_view uid) {
+				if (!first)
+					cards += (cards.empty() ? "\n                " : ",\n                ") + quoted(uid);
+				first = false;
+			});
+			if (!cards.empty())
+				out << "            \"cards\": [" << cards << "\n            ],\n";
+			if (users.expires(id))
+				out << "            \"expires\": " << users.expires(id) << ",\n";
+			if (users.group(id) != UserTable::noGroup_)
+				out << "            \"group\": " << quoted(users.groupName(users.group(id))) << ",\n";
+
+			out << "            \"lvl\": " << users.lvl(id) << ",\n"
+				<< "            \"name\": " << quoted(users.name(id));
+			if (!users.uid(id).empty())
+				out << ",\n            \"uid\": " << quoted(users.uid(id));
+			out << "\n        }";
+		}
+		out << (sortedUsers.empty() ? "]" : "\n    ]") << "\n}";
+
+		if (!out)
+			return false;
+	}
+
+	try {
+		std::filesystem::rename(tmp, path);
+	}
+	catch (const std::exception& e) {
+		DEBUG_OUT("Writing config.json failed: " + std::string(e.what()));
+		return false;
+	}
+	return true;
+}
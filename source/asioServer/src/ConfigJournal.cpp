@@ -0,0 +1,60 @@
+#include "ConfigJournal.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+ConfigJournal::ConfigJournal(std::string path) : path_(std::move(path)) {}
+
+bool ConfigJournal::append(const std::string& line) const {
+	const std::string data = line + '\n';
+#ifdef _WIN32
+	const int fd = _open(path_.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, 0644);
+	if (fd < 0)
+		return false;
+	const bool ok = _write(fd, data.data(), static_cast<unsigned>(data.size())) == static_cast<int>(data.size()) && _commit(fd) == 0;
+	_close(fd);
+#else
+	const int fd = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return false;
+	// One write keeps the line whole, O_APPEND keeps it at the end
+	bool ok = ::write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+#if defined(__APPLE__)
+	ok = ok && ::fsync(fd) == 0;
+#else
+	ok = ok && ::fdatasync(fd) == 0;
+#endif
+	::close(fd);
+#endif
+	return ok;
+}
+
+size_t ConfigJournal::replay(const std::function<void(const std::string&)>& apply) const {
+	std::ifstream in(path_, std::ios::binary);
+	if (!in)
+		return 0;
+
+	size_t count = 0;
+	std::string line;
+	while (std::getline(in, line)) {
+		if (in.eof())
+			break; // No trailing newline, the append never completed
+		if (!line.empty())
+			apply(line);
+		++count;
+	}
+	return count;
+}
+
+void ConfigJournal::clear() const {
+	std::error_code ec;
+	std::filesystem::remove(path_, ec);
+}
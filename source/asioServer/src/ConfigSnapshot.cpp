@@ -0,0 +1,325 @@
+#include "ConfigSnapshot.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "TcpConnection.hpp" // DEBUG_OUT
+
+namespace {
+	constexpr char magic[4] = {'P', 'J', '3', 'S'};
+
+	/// Read-only view of a whole file. mmap where available, otherwise a plain read into memory.
+	class FileView {
+	public:
+		explicit FileView(const std::string& path) {
+#ifndef _WIN32
+			const int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return;
+			struct stat st{};
+			if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+				void* map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (map != MAP_FAILED) {
+					::madvise(map, st.st_size, MADV_SEQUENTIAL);
+					data_ = static_cast<const char*>(map);
+					size_ = st.st_size;
+				}
+			}
+			::close(fd);
+#else
+			std::ifstream in(path, std::ios::binary);
+			if (!in)
+				return;
+			buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+			data_ = buffer_.data();
+			size_ = buffer_.size();
+#endif
+		}
+
+		~FileView() {
+#ifndef _WIN32
+			if (data_)
+				::munmap(const_cast<char*>(data_), size_);
+#endif
+		}
+
+		FileView(const FileView&)            = delete;
+		FileView& operator=(const FileView&) = delete;
+
+		const char* data() const { return data_; }
+		size_t size() const { return size_; }
+
+	private:
+		const char* data_ = nullptr;
+		size_t size_      = 0;
+#ifdef _WIN32
+		std::vector<char> buffer_;
+#endif
+	};
+}
+
+bool ConfigSnapshot::sourceStamp(const std::string& source, uint64_t& size, int64_t& mtime) {
+	std::error_code ec;
+	size = std::filesystem::file_size(source, ec);
+	if (ec)
+		return false;
+	mtime = std::filesystem::last_write_time(source, ec).time_since_epoch().count();
+	return !ec;
+}
+
+uint64_t ConfigSnapshot::checksum(const char* data, const size_t size) {
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+/// Loads the access tables from a snapshot in a single pass over the mapped file.
+/// @param path snapshot file, "config.bin".
+/// @param source the config.json the snapshot must match.
+/// @returns true if the tables were filled from the snapshot.
+bool ConfigSnapshot::load(const std::string& path, const std::string& source, Doors& doors, UserTable& users,
+						  std::vector<std::string>& revoked, std::string& logs, std::string& schedules, std::string& rules) {
+	const FileView file(path);
+	if (!file.data() || file.size() < sizeof(Header))
+		return false;
+
+	Header header{};
+	std::memcpy(&header, file.data(), sizeof(Header));
+	if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version_) {
+		DEBUG_OUT("config.bin has an unknown format or version - rebuilding from config.json");
+		return false;
+	}
+
+	uint64_t size{};
+	int64_t mtime{};
+	if (!sourceStamp(source, size, mtime) || size != header.sourceSize || mtime != header.sourceMtime) {
+		DEBUG_OUT("config.json changed since config.bin was written - rebuilding");
+		return false;
+	}
+
+	const size_t doorBytes    = static_cast<size_t>(header.doorCount) * sizeof(DoorRecord);
+	const size_t userBytes    = static_cast<size_t>(header.userCount) * sizeof(UserRecord);
+	const size_t cardBytes    = static_cast<size_t>(header.cardCount) * sizeof(CardRecord);
+	const size_t revokedBytes = static_cast<size_t>(header.revokedCount) * sizeof(StringRecord);
+	const size_t groupBytes   = static_cast<size_t>(header.groupCount) * sizeof(StringRecord);
+	if (file.size() != sizeof(Header) + doorBytes + userBytes + cardBytes + revokedBytes + groupBytes + header.poolBytes) {
+		DEBUG_OUT("config.bin is truncated - rebuilding from config.json");
+		return false;
+	}
+
+	const char* body = file.data() + sizeof(Header);
+	if (checksum(body, file.size() - sizeof(Header)) != header.checksum) {
+		DEBUG_OUT("config.bin checksum mismatch - rebuilding from config.json");
+		return false;
+	}
+
+	const char* doorArray    = body;
+	const char* userArray    = doorArray + doorBytes;
+	const char* cardArray    = userArray + userBytes;
+	const char* revokedArray = cardArray + cardBytes;
+	const char* groupArray   = revokedArray + revokedBytes;
+	const char* pool         = groupArray + groupBytes;
+	auto inPool              = [&](const uint32_t offset, const uint32_t length) {
+		return static_cast<uint64_t>(offset) + length <= header.poolBytes;
+	};
+	auto record = [](const char* array, const uint32_t i, auto& out) {
+		std::memcpy(&out, array + i * sizeof(out), sizeof(out));
+	};
+	if (!inPool(header.logsOffset, header.logsLength) || !inPool(header.schedulesOffset, header.schedulesLength) ||
+		!inPool(header.rulesOffset, header.rulesLength) || header.groupCount == 0 || header.groupCount > UINT16_MAX + 1)
+		return false;
+
+	// Validate every record before touching the tables, so a bad snapshot never leaves them half filled.
+	for (uint32_t i = 0; i < header.doorCount; ++i) {
+		DoorRecord door{};
+		record(doorArray, i, door);
+		if (!inPool(door.nameOffset, door.nameLength) || !inPool(door.scheduleOffset, door.scheduleLength) ||
+			!inPool(door.zoneOffset, door.zoneLength) || door.direction > static_cast<uint32_t>(Door::Direction::exit))
+			return false;
+	}
+	for (uint32_t i = 0; i < header.userCount; ++i) {
+		UserRecord user{};
+		record(userArray, i, user);
+		if (!inPool(user.nameOffset, user.nameLength) || user.group >= header.groupCount)
+			return false;
+	}
+	for (uint32_t i = 0; i < header.cardCount; ++i) {
+		CardRecord card{};
+		record(cardArray, i, card);
+		if (!inPool(card.uidOffset, card.uidLength) || card.owner >= header.userCount)
+			return false;
+	}
+	for (uint32_t i = 0; i < header.revokedCount; ++i) {
+		StringRecord uid{};
+		record(revokedArray, i, uid);
+		if (!inPool(uid.offset, uid.length))
+			return false;
+	}
+	for (uint32_t i = 0; i < header.groupCount; ++i) {
+		StringRecord group{};
+		record(groupArray, i, group);
+		if (!inPool(group.offset, group.length) || (i == 0) != (group.length == 0))
+			return false;
+	}
+
+	doors.reserve(header.doorCount);
+	for (uint32_t i = 0; i < header.doorCount; ++i) {
+		DoorRecord door{};
+		record(doorArray, i, door);
+		doors.emplace(std::string(pool + door.nameOffset, door.nameLength),
+					  Door{door.lvl, std::string(pool + door.scheduleOffset, door.scheduleLength),
+						   std::string(pool + door.zoneOffset, door.zoneLength), static_cast<Door::Direction>(door.direction)});
+	}
+
+	// Group names are interned in ID order, so the IDs in the user records stay valid
+	for (uint32_t i = 1; i < header.groupCount; ++i) {
+		StringRecord group{};
+		record(groupArray, i, group);
+		users.internGroup({pool + group.offset, group.length});
+	}
+
+	users.reserve(header.userCount, header.cardCount);
+	std::vector<UserTable::Id> ids(header.userCount);
+	for (uint32_t i = 0; i < header.userCount; ++i) {
+		UserRecord user{};
+		record(userArray, i, user);
+		ids[i] = users.add({pool + user.nameOffset, user.nameLength}, {}, user.lvl);
+		if (ids[i] == UserTable::none_)
+			continue;
+		users.setGroup(ids[i], static_cast<UserTable::Group>(user.group));
+		users.setExpires(ids[i], user.expires);
+	}
+	for (uint32_t i = 0; i < header.cardCount; ++i) {
+		CardRecord card{};
+		record(cardArray, i, card);
+		if (ids[card.owner] != UserTable::none_)
+			users.addCard(ids[card.owner], {pool + card.uidOffset, card.uidLength});
+	}
+
+	revoked.reserve(header.revokedCount);
+	for (uint32_t i = 0; i < header.revokedCount; ++i) {
+		StringRecord uid{};
+		record(revokedArray, i, uid);
+		revoked.emplace_back(pool + uid.offset, uid.length);
+	}
+
+	logs.assign(pool + header.logsOffset, header.logsLength);
+	schedules.assign(pool + header.schedulesOffset, header.schedulesLength);
+	rules.assign(pool + header.rulesOffset, header.rulesLength);
+	return true;
+}
+
+/// Writes a snapshot of the tables, stamped with the current size and mtime of source.\n
+/// Call after config.json has been written, otherwise the next load rejects the snapshot.
+/// @returns false if the snapshot could not be written. config.json is still valid in that case.
+bool ConfigSnapshot::save(const std::string& path, const std::string& source, const Doors& doors, const UserTable& users,
+						  const std::vector<std::string>& revoked, const std::string& logs, const std::string& schedules,
+						  const std::string& rules) {
+	Header header{};
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version      = version_;
+	header.doorCount    = static_cast<uint32_t>(doors.size());
+	header.userCount    = static_cast<uint32_t>(users.size());
+	header.cardCount    = static_cast<uint32_t>(users.cardCount());
+	header.revokedCount = static_cast<uint32_t>(revoked.size());
+	header.groupCount   = static_cast<uint32_t>(users.groupCount());
+	if (!sourceStamp(source, header.sourceSize, header.sourceMtime))
+		return false;
+
+	std::string pool;
+	auto intern = [&pool](const std::string_view str, uint32_t& offset, uint32_t& length) {
+		offset = static_cast<uint32_t>(pool.size());
+		length = static_cast<uint32_t>(str.size());
+		pool += str;
+	};
+
+	std::vector<char> body(doors.size() * sizeof(DoorRecord) + users.size() * sizeof(UserRecord) +
+						   users.cardCount() * sizeof(CardRecord) + (revoked.size() + users.groupCount()) * sizeof(StringRecord));
+	char* out = body.data();
+	auto emit = [&out](const auto& record) {
+		std::memcpy(out, &record, sizeof(record));
+		out += sizeof(record);
+	};
+
+	for (const auto& [name, entry] : doors) {
+		DoorRecord door{};
+		intern(name, door.nameOffset, door.nameLength);
+		intern(entry.schedule, door.scheduleOffset, door.scheduleLength);
+		intern(entry.zone, door.zoneOffset, door.zoneLength);
+		door.lvl       = entry.lvl;
+		door.direction = static_cast<uint32_t>(entry.direction);
+		emit(door);
+	}
+
+	users.forEach([&](const UserTable::Id id) {
+		UserRecord user{};
+		intern(users.name(id), user.nameOffset, user.nameLength);
+		user.lvl     = users.lvl(id);
+		user.group   = users.group(id);
+		user.expires = users.expires(id);
+		emit(user);
+	});
+
+	// Cards refer to their owner by position in the user array, which follows forEach order
+	uint32_t owner = 0;
+	users.forEach([&](const UserTable::Id id) {
+		users.forEachCard(id, [&](const std::string_view uid) {
+			CardRecord card{};
+			intern(uid, card.uidOffset, card.uidLength);
+			card.owner = owner;
+			emit(card);
+		});
+		++owner;
+	});
+
+	for (const auto& uid : revoked) {
+		StringRecord record{};
+		intern(uid, record.offset, record.length);
+		emit(record);
+	}
+	for (size_t group = 0; group < users.groupCount(); ++group) {
+		StringRecord record{};
+		intern(users.groupName(static_cast<UserTable::Group>(group)), record.offset, record.length);
+		emit(record);
+	}
+	intern(logs, header.logsOffset, header.logsLength);
+	intern(schedules, header.schedulesOffset, header.schedulesLength);
+	intern(rules, header.rulesOffset, header.rulesLength);
+
+	if (pool.size() > UINT32_MAX) {
+		DEBUG_OUT("Config too large for config.bin - falling back to config.json on restart");
+		return false;
+	}
+	body.insert(body.end(), pool.begin(), pool.end());
+	header.poolBytes = pool.size();
+	header.checksum  = checksum(body.data(), body.size());
+
+	try {
+		const std::string tmp = path + ".tmp";
+		{
+			std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			file.write(body.data(), static_cast<std::streamsize>(body.size()));
+			if (!file)
+				return false;
+		}
+		std::filesystem::rename(tmp, path);
+	}
+	catch (const std::exception& e) {
+		DEBUG_OUT("Writing config.bin failed: " + std::string(e.what()));
+		return false;
+	}
+	return true;
+}
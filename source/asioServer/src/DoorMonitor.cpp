@@ -0,0 +1,145 @@
+#include "DoorMonitor.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <map>
+
+const char* DoorMonitor::name(const Kind kind) {
+	switch (kind) {
+		case Kind::heldOpen:
+			return "held_open";
+		case Kind::tailgating:
+			return "tailgating";
+		default:
+			return "forced";
+	}
+}
+
+/// "dd/mm/yyyy hh:mm:ss door kind detail"
+std::string DoorMonitor::format(const Alert& alert) {
+	const std::time_t seconds = alert.timeMs / 1000;
+	std::tm tm{};
+#ifdef _WIN32
+	localtime_s(&tm, &seconds);
+#else
+	localtime_r(&seconds, &tm);
+#endif
+	char stamp[32];
+	std::strftime(stamp, sizeof(stamp), "%d/%m/%Y %H:%M:%S", &tm);
+
+	std::string out = std::string(stamp) + ' ' + alert.door + ' ' + name(alert.kind);
+	if (alert.kind == Kind::heldOpen)
+		out += " for " + std::to_string(alert.detailMs / 1000) + "s";
+	else if (alert.kind == Kind::tailgating)
+		out += ", approved " + std::to_string(alert.detailMs / 1000) + "s before";
+	return out;
+}
+
+void DoorMonitor::approved(const std::string& door, const int64_t timeMs) {
+	Door& state = doors_[door];
+	state.approvals.push_back(timeMs);
+	state.lastApproval = timeMs;
+	// Approvals nobody opened the door for are dropped on the next opening, but cap them for doors that never report
+	if (state.approvals.size() > 16)
+		state.approvals.pop_front();
+}
+
+void DoorMonitor::opened(const std::string& door, const int64_t timeMs, const int64_t sourceMs) {
+	Door& state = doors_[door];
+	if (state.open)
+		return; // Repeated event
+	state.open           = true;
+	state.heldReported   = false;
+	state.openedAt       = timeMs;
+	state.openedAtSource = sourceMs;
+	++state.openings;
+	++open_;
+
+	while (!state.approvals.empty() && timeMs - state.approvals.front() > window_)
+		state.approvals.pop_front();
+	if (!state.approvals.empty())
+		state.approvals.pop_front();
+	else if (lostAt_ && timeMs - lostAt_ <= window_)
+		return; // Its approval may be among the lost ones, better no alert than a false one
+	else if (state.lastApproval && timeMs - state.lastApproval <= window_)
+		raise(door, state, timeMs, Kind::tailgating, timeMs - state.lastApproval);
+	else
+		raise(door, state, timeMs, Kind::forced, 0);
+}
+
+void DoorMonitor::closed(const std::string& door, const int64_t timeMs, const int64_t sourceMs) {
+	const auto entry = doors_.find(door);
+	if (entry == doors_.end() || !entry->second.open)
+		return; // Closed before we heard it open, e.g. after a restart
+	Door& state = entry->second;
+	state.open  = false;
+	--open_;
+
+	const int64_t duration = sourceMs && state.openedAtSource ? sourceMs - state.openedAtSource : timeMs - state.openedAt;
+	if (duration > heldOpen_ && !state.heldReported)
+		raise(door, state, timeMs, Kind::heldOpen, duration);
+}
+
+void DoorMonitor::lost(const int64_t timeMs) {
+	lostAt_ = std::max(lostAt_, timeMs);
+}
+
+void DoorMonitor::sweep(const int64_t nowMs) {
+	if (!open_)
+		return;
+	for (auto& [door, state] : doors_) {
+		if (state.open && !state.heldReported && nowMs - state.openedAt > heldOpen_) {
+			raise(door, state, nowMs, Kind::heldOpen, nowMs - state.openedAt);
+			state.heldReported = true;
+		}
+	}
+}
+
+void DoorMonitor::forget(const std::string& door) {
+	const auto entry = doors_.find(door);
+	if (entry == doors_.end())
+		return;
+	if (entry->second.open)
+		--open_;
+	doors_.erase(entry);
+}
+
+std::vector<DoorMonitor::Alert> DoorMonitor::takeRaised() {
+	std::vector<Alert> out;
+	out.swap(raised_);
+	return out;
+}
+
+std::string DoorMonitor::describe() const {
+	if (doors_.empty())
+		return "No door events yet";
+
+	// Sorted by name for a stable listing
+	const std::map<std::string, const Door*> sorted = [this] {
+		std::map<std::string, const Door*> out;
+		for (const auto& [door, state] : doors_)
+			out.emplace(door, &state);
+		return out;
+	}();
+
+	std::string out = "Doors:";
+	for (const auto& [door, state] : sorted)
+		out += "\n  " + door + ": " + (state->open ? "open" : "closed") + ", " + std::to_string(state->openings) + " openings, "
+			   + std::to_string(state->alerts[static_cast<int>(Kind::heldOpen)]) + " held open, "
+			   + std::to_string(state->alerts[static_cast<int>(Kind::tailgating)]) + " tailgating, "
+			   + std::to_string(state->alerts[static_cast<int>(Kind::forced)]) + " forced";
+
+	out += history_.empty() ? "\nNo alerts" : "\nRecent alerts:";
+	for (auto alert = history_.rbegin(); alert != history_.rend(); ++alert)
+		out += "\n  " + format(*alert);
+	return out;
+}
+
+void DoorMonitor::raise(const std::string& door, Door& state, const int64_t timeMs, const Kind kind, const int64_t detailMs) {
+	++state.alerts[static_cast<int>(kind)];
+	const Alert alert{timeMs, door, kind, detailMs};
+	raised_.push_back(alert);
+	history_.push_back(alert);
+	if (history_.size() > historySize_)
+		history_.pop_front();
+}
@@ -0,0 +1,72 @@
+#include "DoorSync.hpp"
+#include "DoorSnapshot.h"
+
+#include <algorithm>
+#include <ctime>
+
+DoorSync::DoorSync(const std::string& keyPath) : key_(snapshot::readKey(keyPath)) {}
+
+std::string DoorSync::reply(const std::string& door, std::vector<std::string> entries, const std::string& have) {
+	snapshot::Message message;
+	message.door    = door;
+	message.time    = std::time(nullptr);
+	message.base    = "0";
+	message.version = snapshot::version(entries);
+
+	const std::scoped_lock lock{mtx_};
+	auto& recent = recent_[door];
+	if (have == message.version) {
+		message.base = have; // Up to date, an empty delta
+	} else {
+		const auto old = std::find_if(recent.begin(), recent.end(), [&](const Version& version) { return version.version == have; });
+		if (old != recent.end()) {
+			message.base    = have;
+			message.entries = delta(old->entries, entries);
+		}
+	}
+
+	if (message.base == "0") {
+		for (const std::string& entry : entries) {
+			if (!message.entries.empty())
+				message.entries += ',';
+			message.entries += entry;
+		}
+	}
+
+	if (recent.empty() || recent.back().version != message.version) {
+		recent.push_back({message.version, std::move(entries)});
+		if (recent.size() > history_)
+			recent.pop_front();
+	}
+	return snapshot::encode(message, key_);
+}
+
+void DoorSync::forget(const std::string& door) {
+	const std::scoped_lock lock{mtx_};
+	recent_.erase(door);
+}
+
+std::string DoorSync::delta(const std::vector<std::string>& from, const std::vector<std::string>& to) {
+	std::string out;
+	auto add = [&](const char sign, const std::string& entry) {
+		if (!out.empty())
+			out += ',';
+		out += sign;
+		// Removals only name the card, a changed expiry is a removal and an addition
+		out += sign == '-' ? entry.substr(0, entry.find('=')) : entry;
+	};
+
+	auto a = from.begin();
+	auto b = to.begin();
+	while (a != from.end() || b != to.end()) {
+		if (b == to.end() || (a != from.end() && *a < *b))
+			add('-', *a++);
+		else if (a == from.end() || *b < *a)
+			add('+', *b++);
+		else {
+			++a;
+			++b;
+		}
+	}
+	return out;
+}
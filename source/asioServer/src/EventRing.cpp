@@ -0,0 +1,96 @@
+#include "EventRing.hpp"
+
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+namespace {
+	template<size_t N>
+	void copyField(char (&dst)[N], const std::string& src) {
+		const size_t len = std::min(src.size(), N - 1);
+		std::memcpy(dst, src.data(), len);
+		dst[len] = '\0';
+	}
+}
+
+EventRing::EventRing(const size_t capacity) : mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1),
+											  slots_(std::make_unique<Slot[]>(mask_ + 1)) {}
+
+/// Publishes one decision or door event. Safe to call from any number of threads concurrently.
+/// @returns void
+void EventRing::push(const std::string& door, const std::string& name, const std::string& uid, const std::string& access, const int64_t sourceMs) {
+	const uint64_t ticket = head_.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot            = slots_[ticket & mask_];
+
+	slot.seq.store(ticket * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot.event.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	slot.event.sourceMs = sourceMs;
+	copyField(slot.event.door, door);
+	copyField(slot.event.name, name);
+	copyField(slot.event.uid, uid);
+	copyField(slot.event.access, access);
+
+	slot.seq.store((ticket + 1) * 2, std::memory_order_release);
+}
+
+uint64_t EventRing::head() const {
+	return head_.load(std::memory_order_acquire);
+}
+
+uint64_t EventRing::read(uint64_t& cursor, std::vector<Event>& out, const size_t max) const {
+	uint64_t dropped   = 0;
+	const uint64_t end = head();
+
+	// Everything older than one lap has been overwritten already.
+	if (end - cursor > mask_ + 1) {
+		dropped += end - cursor - (mask_ + 1);
+		cursor = end - (mask_ + 1);
+	}
+
+	while (cursor < end && out.size() < max) {
+		const Slot& slot        = slots_[cursor & mask_];
+		const uint64_t expected = (cursor + 1) * 2;
+
+		const uint64_t before = slot.seq.load(std::memory_order_acquire);
+		if (before < expected)
+			break; // Writer still busy with this ticket, try again on the next flush
+		if (before != expected) {
+			++dropped; // Lapped by a newer ticket
+			++cursor;
+			continue;
+		}
+
+		Event copy = slot.event;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.seq.load(std::memory_order_relaxed) != expected) {
+			++dropped;
+			++cursor;
+			continue;
+		}
+		out.push_back(copy);
+		++cursor;
+	}
+	return dropped;
+}
+
+/// "dd/mm/yyyy hh:mm:ss.mmm door name uid access"
+std::string EventRing::format(const Event& event) {
+	const std::time_t seconds = event.timeMs / 1000;
+	std::tm tm{};
+#ifdef _WIN32
+	localtime_s(&tm, &seconds);
+#else
+	localtime_r(&seconds, &tm);
+#endif
+	char stamp[32];
+	std::strftime(stamp, sizeof(stamp), "%d/%m/%Y %H:%M:%S", &tm);
+
+	char ms[8];
+	std::snprintf(ms, sizeof(ms), ".%03d", static_cast<int>(event.timeMs % 1000));
+
+	return std::string(stamp) + ms + ' ' + event.door + ' ' + event.name + ' ' + event.uid + ' ' + event.access;
+}
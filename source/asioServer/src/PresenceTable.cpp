@@ -0,0 +1,115 @@
+#include "PresenceTable.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include "TcpConnection.hpp" // DEBUG_OUT
+
+void PresenceTable::resize(const size_t users, const size_t zones) {
+	if (users > userCapacity_) {
+		const size_t capacity = std::max(users, userCapacity_ * 2);
+		auto grown            = std::make_unique<std::atomic<uint16_t>[]>(capacity);
+		for (size_t i = 0; i < userCapacity_; ++i)
+			grown[i].store(users_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		users_        = std::move(grown);
+		userCapacity_ = capacity;
+	}
+	if (zones > zoneCapacity_) {
+		auto grown = std::make_unique<Counter[]>(zones);
+		for (size_t i = 0; i < zoneCapacity_; ++i)
+			grown[i].value.store(counters_[i].value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		counters_     = std::move(grown);
+		zoneCapacity_ = zones;
+	}
+}
+
+bool PresenceTable::enter(const UserTable::Id user, const uint16_t zone) {
+	if (user >= userCapacity_ || zone == outside_ || zone >= zoneCapacity_)
+		return true;
+
+	std::atomic<uint16_t>& slot = users_[user];
+	uint16_t from               = slot.load(std::memory_order_relaxed);
+	do {
+		if (from == zone)
+			return false; // No exit since the last entry
+	} while (!slot.compare_exchange_weak(from, zone, std::memory_order_relaxed));
+
+	if (from != outside_)
+		counters_[from].value.fetch_sub(1, std::memory_order_relaxed);
+	counters_[zone].value.fetch_add(1, std::memory_order_relaxed);
+	markDirty();
+	return true;
+}
+
+void PresenceTable::leave(const UserTable::Id user, const uint16_t zone) {
+	if (user >= userCapacity_ || zone == outside_ || zone >= zoneCapacity_)
+		return;
+
+	uint16_t from = zone;
+	if (!users_[user].compare_exchange_strong(from, outside_, std::memory_order_relaxed))
+		return;
+	counters_[zone].value.fetch_sub(1, std::memory_order_relaxed);
+	markDirty();
+}
+
+uint16_t PresenceTable::forget(const UserTable::Id user) {
+	if (user >= userCapacity_)
+		return outside_;
+
+	const uint16_t from = users_[user].exchange(outside_, std::memory_order_relaxed);
+	if (from != outside_) {
+		counters_[from].value.fetch_sub(1, std::memory_order_relaxed);
+		markDirty();
+	}
+	return from;
+}
+
+std::string PresenceTable::dump(const UserTable& users, const AccessPolicy& policy) const {
+	std::string out;
+	users.forEach([&](const UserTable::Id id) {
+		const uint16_t zone = zoneOf(id);
+		if (zone != outside_)
+			out.append(users.name(id)).append(" ").append(policy.zoneName(zone)).append("\n");
+	});
+	return out;
+}
+
+bool PresenceTable::save(const std::string& path, const std::string& dump) {
+	try {
+		const std::string tmp = path + ".tmp";
+		{
+			std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+			file << dump;
+			if (!file)
+				return false;
+		}
+		std::filesystem::rename(tmp, path);
+	}
+	catch (const std::exception& e) {
+		DEBUG_OUT("Writing " + path + " failed: " + std::string(e.what()));
+		return false;
+	}
+	return true;
+}
+
+size_t PresenceTable::load(const std::string& path, const UserTable& users, const AccessPolicy& policy) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		return 0;
+
+	size_t restored = 0;
+	std::string line;
+	while (std::getline(in, line)) {
+		const size_t space = line.find(' ');
+		if (space == std::string::npos)
+			continue;
+		const UserTable::Id user = users.findByName(std::string_view(line).substr(0, space));
+		const uint16_t zone      = policy.findZone(std::string_view(line).substr(space + 1));
+		if (user == UserTable::none_ || zone == outside_)
+			continue; // Removed since, or the zone has no doors left
+		restored += enter(user, zone);
+	}
+	dirty_ = false;
+	return restored;
+}
@@ -1,6 +1,7 @@
 ﻿#include "ReaderHandler.hpp"
 
 #include "ogga/scopetimer.hpp"
+#include "logclock.hpp"
 
 #ifdef _WIN32
 #define _WINSOCK_DEPRECATED_NO_WARNINGS
@@ -17,57 +18,93 @@
 
 #include <iostream>
 #include <regex>
+#include <sstream>
+
+#if defined(DEBUG) && !defined(_WIN32)
+#include <sys/resource.h>
+#endif
 
 ///
 ReaderHandler::ReaderHandler(const int& clientPort, const int& cliPort,
 							 const std::string& cliName) : clientServer_(clientPort),
 														   cliServer_(cliPort),
+														   tailRetry_(cliServer_.getContext()),
+														   visitorTick_(cliServer_.getContext()),
+														   presenceFlush_(cliServer_.getContext()),
+														   doorSweep_(cliServer_.getContext()),
 														   cliReader_{cliName, nullptr} {
 	myIp();
 	////////////////////////////// Read config JSON //////////////////////////////
-	std::ifstream file("config.json");
-	nlohmann::json configJson;
-
-	if (!file.is_open() || file.peek() == std::ifstream::traits_type::eof()) {
-		DEBUG_OUT("config.json doesn't exist");
-		std::ofstream("config.json") << R"({"users":[],"doors":[]})";
-		DEBUG_OUT("Created empty config.json");
-	} else {
-		try {
-			file >> configJson;
-		}
-		catch (const nlohmann::json::parse_error& e) {
-			DEBUG_OUT("Invalid JSON in config.json" + std::string(e.what()));
-			configJson = {{"users", nlohmann::json::array()}, {"doors", nlohmann::json::array()}};
-
-			std::ofstream("config.json") << R"({"users":[],"doors":[]})";
-			DEBUG_OUT("Reset invalid config.json\n");
-		}
-	}
-
-	if (configJson.contains("doors"))
-		for (const auto& door : configJson["doors"]) {
-			if (door.contains("name") && door.contains("lvl") &&
-				door["name"].is_string() && door["lvl"].is_number_integer())
-				doors_[door["name"]] = door["lvl"];
-			else
-				DEBUG_OUT("Invalid door entry in config.json - skipping one.\n");
+	{
+#ifdef DEBUG
+		[[maybe_unused]] ogga::scopetimer loadTimer("Config load time", "ms");
+#endif
+		// config.bin is only trusted while config.json is unchanged, otherwise config.json is imported and the snapshot rebuilt.
+		std::vector<std::string> revoked;
+		std::string schedules;
+		std::string rules;
+		if (ConfigSnapshot::load("config.bin", "config.json", doors_, users_, revoked, logsConfig_, schedules, rules))
+			DEBUG_OUT("Loaded " + std::to_string(users_.size()) + " users and " + std::to_string(doors_.size()) + " doors from config.bin");
+		else
+			importConfig(revoked, schedules, rules);
+		revoked_.assign(std::move(revoked));
+		schedules_.load(schedules);
+		schedules_.bind(doors_);
+		policy_.load(rules);
+		{
+#ifdef DEBUG
+			[[maybe_unused]] ogga::scopetimer publishTimer("Rule publish time for " + std::to_string(policy_.size()) + " rules", "us");
+#endif
+			policy_.publish(users_, doors_);
 		}
 
-	if (configJson.contains("users"))
-		for (const auto& user : configJson["users"]) {
-			if (user.contains("name") && user.contains("uid") && user.contains("lvl") &&
-				user["name"].is_string() && user["uid"].is_string() && user["lvl"].is_number_integer()) {
-				const std::string name = user["name"];
-				const std::string uid  = user["uid"];
-				const int lvl          = user["lvl"];
+		// Card changes made since config.json was last written
+		const size_t replayed = journal_.replay([this](const std::string& line) { applyJournal(line); });
+		if (replayed)
+			DEBUG_OUT("Replayed " + std::to_string(replayed) + " entries from config.journal");
+		uidFilter_.build(users_);
+
+		// Visitor badges that expired while the server was down go on the first tick
+		visitors_.reset(std::time(nullptr));
+		users_.forEach([this](const UserTable::Id id) {
+			if (users_.expires(id))
+				visitors_.schedule(id, users_.expires(id));
+		});
 
-				usersByName_[name] = {uid, lvl};
-				usersByUid_[uid]   = {name, lvl};
-			} else
-				DEBUG_OUT("Invalid user entry in config.json - skipping one.\n");
-		}
-	file.close();
+		// Who was inside which zone when the server last saved it
+		presence_.resize(users_.idLimit(), policy_.zoneCount());
+		const size_t inside = presence_.load("presence.snapshot", users_, policy_);
+		if (inside)
+			DEBUG_OUT("Restored " + std::to_string(inside) + " users inside zones from presence.snapshot");
+	}
+#if defined(DEBUG) && !defined(_WIN32)
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	DEBUG_OUT("Peak RSS after config load: " + std::to_string(usage.ru_maxrss / 1024) + " MiB");
+#endif
+	const nlohmann::json logsJson = nlohmann::json::parse(logsConfig_, nullptr, false);
+
+	// Optional "logs" section. Missing keys keep the CsvLogger defaults.
+	CsvLogger::RotationPolicy policy;
+	CsvLogger::DurabilityPolicy durability;
+	if (logsJson.is_object()) {
+		const auto& logs   = logsJson;
+		policy.maxBytes    = logs.value("maxBytes", policy.maxBytes);
+		policy.maxAge      = std::chrono::hours(24 * logs.value("maxAgeDays", policy.maxAge.count() / 24));
+		policy.retention   = std::chrono::hours(24 * logs.value("retentionDays", policy.retention.count() / 24));
+		policy.maxSegments = logs.value("maxSegments", policy.maxSegments);
+		policy.compress    = logs.value("compress", policy.compress);
+
+		// "none", "group" or "record"
+		const std::string mode   = logs.value("durability", std::string("group"));
+		durability.mode          = mode == "none" ? CsvLogger::Durability::none
+								   : mode == "record" ? CsvLogger::Durability::record
+								   : CsvLogger::Durability::group;
+		durability.groupInterval = std::chrono::milliseconds(logs.value("groupCommitMs", durability.groupInterval.count()));
+		durability.groupRecords  = logs.value("groupCommitRecords", durability.groupRecords);
+	}
+	log_.setPolicy(policy);
+	log_.setDurability(durability);
 	////////////////////////////// Read config JSON //////////////////////////////
 
 	//////////////////////////////// Init Servers ////////////////////////////////
@@ -87,6 +124,11 @@ ReaderHandler::ReaderHandler(const int& clientPort, const int& cliPort,
 	});
 
 	cliServer_.onClientDisconnect([this](const CONNECTION_T& connection) {
+		{
+			const std::scoped_lock lock{tail_mtx};
+			std::erase_if(tailSubscribers_, [connection](const TailSubscriber& sub) { return sub.connection == connection; });
+			tailing_ = !tailSubscribers_.empty();
+		}
 		const std::scoped_lock lock{cli_mtx};
 		if (cliReader_.second == connection) {
 			cliReader_.second = nullptr;
@@ -95,6 +137,9 @@ ReaderHandler::ReaderHandler(const int& clientPort, const int& cliPort,
 	});
 
 	running_ = true;
+	if (visitors_.size())
+		scheduleVisitorTick();
+	schedulePresenceFlush();
 	DEBUG_OUT("Servers started and awaiting clients");
 	//////////////////////////////// Init Servers ////////////////////////////////
 #ifdef DEBUG
@@ -126,6 +171,7 @@ ReaderHandler::~ReaderHandler() {
 /// @returns void
 void ReaderHandler::stop() {
 	running_ = false;
+	flushPresence();
 	clientServer_.stop();
 	cliServer_.stop();
 	DEBUG_OUT("Servers Shutting Down");
@@ -206,6 +252,50 @@ void ReaderHandler::myIp() {
 	DEBUG_OUT(std::string_view(buf));
 }
 
+/// Streams config.json into the access tables and writes a fresh config.bin for the next start.\n
+/// Sets logsConfig_ to the "logs" object as JSON text, "{}" if there is none.
+/// @param revoked receives the revoked card UIDs.
+/// @param schedules receives the "schedules" object as JSON text.
+/// @returns void
+void ReaderHandler::importConfig(std::vector<std::string>& revoked, std::string& schedules, std::string& rules) {
+	switch (ConfigFile::load("config.json", doors_, users_, revoked, logsConfig_, schedules, rules)) {
+		case ConfigFile::Result::loaded:
+			break;
+		case ConfigFile::Result::missing:
+			DEBUG_OUT("config.json doesn't exist");
+			std::ofstream("config.json") << R"({"users":[],"doors":[]})";
+			DEBUG_OUT("Created empty config.json");
+			break;
+		case ConfigFile::Result::invalid:
+			std::ofstream("config.json") << R"({"users":[],"doors":[]})";
+			DEBUG_OUT("Reset invalid config.json\n");
+			break;
+	}
+
+	if (!ConfigSnapshot::save("config.bin", "config.json", doors_, users_, revoked, logsConfig_, schedules, rules))
+		DEBUG_OUT("Could not write config.bin");
+}
+
+/// Applies one config.journal entry to the tables. Entries are idempotent, replaying one that is already in config.json changes nothing.
+/// @param line "addCard <name> <uid>" or "revokeCard <uid>".
+/// @returns void
+void ReaderHandler::applyJournal(const std::string& line) {
+	std::istringstream in(line);
+	std::string op, first, second;
+	in >> op >> first >> second;
+
+	if (op == "addCard" && !second.empty()) {
+		const UserTable::Id id = users_.findByName(first);
+		if (id != UserTable::none_ && users_.addCard(id, second))
+			revoked_.restore(second);
+	} else if (op == "revokeCard" && !first.empty()) {
+		to_lower(first);
+		users_.removeCard(first);
+		revoked_.revoke(first);
+	} else
+		DEBUG_OUT("Invalid config.journal entry - skipping: " + line);
+}
+
 void ReaderHandler::onDeadConnection(CONNECTION_T dead) {
 	const std::scoped_lock lock{cli_mtx};
 	if (cliReader_.second == dead)
@@ -216,7 +306,7 @@ void ReaderHandler::onDeadConnection(CONNECTION_T dead) {
 /// Is automatically called via lambda callback in CTOR whenever a new TCP Connection is established on the clientServer_.<br>Recalls itself after each pass.
 /// @param connection ptr to the relative TcpConnection object. This is established and passed in the CTOR callback.
 /// @returns void
-void ReaderHandler::handleClient(CONNECTION_T connection) const {
+void ReaderHandler::handleClient(CONNECTION_T connection) {
 	connection->read<std::string>([this, connection](const std::string& pkg) {
 		const size_t seperator = pkg.find(':');
 		if (seperator == std::string::npos || seperator == 0 || seperator == pkg.size() - 1) {
@@ -226,6 +316,26 @@ void ReaderHandler::handleClient(CONNECTION_T connection) const {
 			return;
 		}
 
+		// Reed-switch events are "door:@open:<ms>" or "door:@closed:<ms>". Nothing is sent back, the client doesn't wait for it.
+		// "door:@sync:<version>" asks for the door's offline cache snapshot, "door:@audit:..." uploads a decision made from it.
+		// "door:@scans:<duplicates>:<limited>" reports the scans the client suppressed since it started.
+		if (pkg[seperator + 1] == '@') {
+			const std::string door  = pkg.substr(0, seperator);
+			const std::string event = pkg.substr(seperator + 2);
+			if (event.rfind("sync:", 0) == 0) {
+				const std::string snapshot = doorSnapshot(door, event.substr(5));
+				if (!snapshot.empty())
+					connection->write<std::string>(snapshot);
+			} else if (event.rfind("audit:", 0) == 0)
+				offlineDecision(door, event.substr(6));
+			else if (event.rfind("scans:", 0) == 0)
+				suppressedScans(door, event.substr(6));
+			else
+				doorEvent(door, event);
+			handleClient(connection);
+			return;
+		}
+
 		{
 			const std::string name = pkg.substr(0, seperator);
 			const std::string uid  = pkg.substr(seperator + 1);
@@ -239,21 +349,62 @@ void ReaderHandler::handleClient(CONNECTION_T connection) const {
 				return;
 			}
 
-			const auto user       = usersByUid_.find(uid);
-			const bool authorized = (user != usersByUid_.end() && user->second.second <= door->second);
+			// Revoked cards are denied before the user table is consulted. Other cards only pay for the Bloom filter.
+			const bool revoked         = revoked_.contains(uid);
+			// Foreign cards are mostly definite misses in the UID filter and never reach the user table
+			const bool candidate       = !revoked && uidFilter_.mightContain(uid);
+			const UserTable::Id user   = candidate ? users_.findByUid(uid) : UserTable::none_;
+			const bool known           = user != UserTable::none_;
+			if (candidate && !known)
+				uidFilter_.recordFalsePositive();
+			// Visitor badges are checked here too, so a badge never works past its expiry while waiting for the next tick
+			const bool expired         = known && users_.expires(user) && users_.expires(user) <= std::time(nullptr);
+			// Only doors with a schedule need the local time, which LogClock caches per second
+			bool inSchedule = true;
+			if (door->second.slot != ScheduleTable::always_) {
+				const LogClock::Local now = LogClock::local();
+				inSchedule                = schedules_.allows(door->second.slot, now.minuteOfWeek, now.day);
+			}
+			// A group rule for the door's zone overrides the level check, one matrix cell whatever the number of rules
+			const auto effect          = known ? policy_.decide(users_.group(user), door->second.zoneId) : AccessPolicy::Effect::none;
+			const bool levelOk         = effect == AccessPolicy::Effect::allow ||
+								 (effect == AccessPolicy::Effect::none && known && users_.lvl(user) <= door->second.lvl);
+			// Anti-passback: a user inside the zone is refused at its entry doors until they badge out through an exit door
+			const bool allowed         = known && !expired && levelOk && inSchedule;
+			bool passback              = false;
+			if (allowed && door->second.direction == ConfigSnapshot::Door::Direction::entry)
+				passback = !presence_.enter(user, door->second.zoneId);
+			else if (allowed && door->second.direction == ConfigSnapshot::Door::Direction::exit)
+				presence_.leave(user, door->second.zoneId);
+			const bool authorized      = allowed && !passback;
+			const std::string userName = known ? std::string(users_.name(user)) : "";
 			DEBUG_OUT(
-					  (user == usersByUid_.end())
+					  revoked
+					  ? "Revoked UID"
+					  : !known
 					  ? "Unknown UID"
-					  : ((authorized ? "Approved access to " + user->second.first
-							  : "Denied access to " + user->second.first) + '(' + std::to_string(user->second.second) + ')'
-						  + " at " + door->first + '(' + std::to_string(door->second) + ')')
+					  : ((authorized ? "Approved access to " + userName
+							  : "Denied access to " + userName) + '(' + std::to_string(users_.lvl(user)) + ')'
+						  + " at " + door->first + '(' + std::to_string(door->second.lvl) + ')'
+						  + (effect == AccessPolicy::Effect::none ? "" : std::string(" by ") + AccessPolicy::name(effect) + " rule")
+						  + (inSchedule ? "" : " outside its schedule") + (expired ? " with an expired badge" : "")
+						  + (passback ? " without leaving the zone first" : ""))
 					 );
 			connection->write<std::string>(authorized ? "approved" : "denied");
+			if (known)
+				stats_.record(door->first, userName, authorized ? AccessStats::approved_ : AccessStats::denied_);
+			else
+				stats_.record(door->first, "", revoked ? AccessStats::denied_ : AccessStats::unknown_);
+			events_.push(door->first, known ? userName : revoked ? "revoked" : "unknown", uid, authorized ? "approved" : "denied");
+			scheduleTailFlush();
+			// Approvals are drained while they flow, so the ring doesn't lap them before the opening they allow
+			if (authorized)
+				scheduleDoorFlush();
 			try {
-				if (user != usersByUid_.end())
-					log_.addLog(door->first, user->second.first, user->first, authorized ? "approved" : "denied");
+				if (known)
+					log_.addLog(door->first, userName, uid, authorized ? "approved" : "denied");
 				else
-					log_.addLog(door->first, "unknown", "unknown", authorized ? "approved" : "denied");
+					log_.addLog(door->first, revoked ? "revoked" : "unknown", revoked ? uid : "unknown", authorized ? "approved" : "denied");
 			}
 			catch (std::exception& e) {
 				DEBUG_OUT(e.what());
@@ -316,6 +467,10 @@ void ReaderHandler::handleCli(CONNECTION_T connection) {
 			const auto [name, _, lvl] = parseSyntax(pkg, newUser_);
 			if (checkSyntax(name))
 				newUser(connection, name, lvl);
+		} else if (pkg.rfind("newVisitor", 0) == 0) {
+			const auto [name, hours, lvl] = parseSyntax(pkg, newVisitor_);
+			if (checkSyntax(name))
+				newUser(connection, name, lvl, std::stoul(hours));
 		} else if (pkg.rfind("newDoor", 0) == 0) {
 			const auto [name, _, lvl] = parseSyntax(pkg, newDoor_);
 			if (checkSyntax(name))
@@ -354,6 +509,127 @@ void ReaderHandler::handleCli(CONNECTION_T connection) {
 				connection->writeFile(getDoorLog(name));
 				handleCli(connection);
 			}
+		} else if (pkg.rfind("getStats", 0) == 0) {
+			const auto [hours, _, __] = parseSyntax(pkg, statistics_);
+			if (checkSyntax(hours)) {
+				connection->write<std::string>(getStats(hours));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("addCard", 0) == 0) {
+			const auto [name, _, __] = parseSyntax(pkg, addCard_);
+			if (checkSyntax(name))
+				addCard(connection, name);
+		} else if (pkg.rfind("revokeCard", 0) == 0) {
+			const auto [uid, _, __] = parseSyntax(pkg, revokeCard_);
+			if (checkSyntax(uid))
+				revokeCard(connection, uid);
+		} else if (pkg.rfind("getCards", 0) == 0) {
+			const auto [name, _, __] = parseSyntax(pkg, getCards_);
+			if (checkSyntax(name)) {
+				connection->write<std::string>(getCards(name));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("addWindow", 0) == 0) {
+			const auto [name, window, _] = parseSyntax(pkg, addWindow_);
+			if (checkSyntax(name)) {
+				connection->write<std::string>(addWindow(name, window));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("addHoliday", 0) == 0) {
+			const auto [name, date, _] = parseSyntax(pkg, addHoliday_);
+			if (checkSyntax(name)) {
+				connection->write<std::string>(addHoliday(name, date));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("setSchedule", 0) == 0) {
+			const auto [door, schedule, _] = parseSyntax(pkg, setSchedule_);
+			if (checkSyntax(door)) {
+				connection->write<std::string>(setSchedule(door, schedule));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("rmSchedule", 0) == 0) {
+			const auto [name, _, __] = parseSyntax(pkg, rmSchedule_);
+			if (checkSyntax(name))
+				rmSchedule(connection, name);
+		} else if (pkg.rfind("setGroup", 0) == 0) {
+			const auto [name, group, _] = parseSyntax(pkg, setGroup_);
+			if (checkSyntax(name)) {
+				connection->write<std::string>(setGroup(name, group));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("setZone", 0) == 0) {
+			const auto [door, zone, _] = parseSyntax(pkg, setZone_);
+			if (checkSyntax(door)) {
+				connection->write<std::string>(setZone(door, zone));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("allow", 0) == 0 || pkg.rfind("deny", 0) == 0) {
+			const auto [group, zone, _] = parseSyntax(pkg, pkg[0] == 'a' ? allow_ : deny_);
+			if (checkSyntax(group)) {
+				connection->write<std::string>(addRule(pkg[0] == 'a' ? AccessPolicy::Effect::allow : AccessPolicy::Effect::deny, group, zone));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("rmRule", 0) == 0) {
+			const auto [group, zone, _] = parseSyntax(pkg, rmRule_);
+			if (checkSyntax(group)) {
+				connection->write<std::string>(rmRule(group, zone));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("explain", 0) == 0) {
+			const auto [name, door, _] = parseSyntax(pkg, explain_);
+			if (checkSyntax(name)) {
+				connection->write<std::string>(explain(name, door));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("setExpiry", 0) == 0) {
+			const auto [name, hours, _] = parseSyntax(pkg, setExpiry_);
+			if (checkSyntax(name)) {
+				connection->write<std::string>(setExpiry(name, hours));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("setDirection", 0) == 0) {
+			const auto [door, direction, _] = parseSyntax(pkg, setDirection_);
+			if (checkSyntax(door)) {
+				connection->write<std::string>(setDirection(door, direction));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("clearPresence", 0) == 0) {
+			const auto [name, _, __] = parseSyntax(pkg, clearPresence_);
+			if (checkSyntax(name)) {
+				connection->write<std::string>(clearPresence(name));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("getOccupancy", 0) == 0) {
+			const auto [zone, _, __] = parseSyntax(pkg, getOccupancy_);
+			if (checkSyntax(zone)) {
+				connection->write<std::string>(getOccupancy(zone));
+				handleCli(connection);
+			}
+		} else if (pkg.rfind("getOccupants", 0) == 0) {
+			const auto [zone, _, __] = parseSyntax(pkg, getOccupants_);
+			if (checkSyntax(zone)) {
+				connection->write<std::string>(getOccupants(zone));
+				handleCli(connection);
+			}
+		} else if (pkg == "getDoorAlerts") {
+			// Events not flushed yet would be missing, and this already runs where flushDoorEvents() does
+			flushDoorEvents();
+			connection->write<std::string>(getDoorAlerts());
+			handleCli(connection);
+		} else if (pkg == "getVisitors") {
+			connection->write<std::string>(getVisitors());
+			handleCli(connection);
+		} else if (pkg == "getRules") {
+			connection->write<std::string>(getRules());
+			handleCli(connection);
+		} else if (pkg == "getSchedules") {
+			connection->write<std::string>(getSchedules());
+			handleCli(connection);
+		} else if (pkg == "getMetrics") {
+			connection->write<std::string>(getMetrics());
+			handleCli(connection);
+		} else if (pkg == "tail") {
+			tail(connection);
 		} else if (pkg == "getConfig") {
 			connection->writeFile(getConfigPath());
 			handleCli(connection);
@@ -372,27 +648,383 @@ void ReaderHandler::handleCli(CONNECTION_T connection) {
 	});
 }
 
-/// Add new user function.
+/// Streams every decision to the CLI as it happens, until the CLI sends any line.\n
+/// The subscriber gets its own cursor into events_, so a slow terminal only loses events and never slows down handleClient.
+/// @param connection ptr to the relative TcpConnection object.
+void ReaderHandler::tail(CONNECTION_T connection) {
+	{
+		const std::scoped_lock lock{tail_mtx};
+		tailSubscribers_.push_back({connection, events_.head(), 0});
+		tailing_ = true;
+	}
+	connection->write<std::string>("Tailing decisions - send any line to stop");
+
+	connection->read<std::string>([this, connection](const std::string&) {
+		{
+			const std::scoped_lock lock{tail_mtx};
+			std::erase_if(tailSubscribers_, [connection](const TailSubscriber& sub) { return sub.connection == connection; });
+			tailing_ = !tailSubscribers_.empty();
+		}
+		connection->write<std::string>("Stopped tail");
+		handleCli(connection);
+	});
+}
+
+/// Called from the decision path. Costs one atomic load when nobody is tailing.
+void ReaderHandler::scheduleTailFlush() {
+	if (!tailing_.load(std::memory_order_relaxed) || flushScheduled_.exchange(true))
+		return;
+	boost::asio::post(cliServer_.getContext(), [this] { flushTail(); });
+}
+
+/// Sends every subscriber the events it hasn't seen yet, in one write per subscriber.\n
+/// Subscribers with a write still in flight are skipped and retried shortly. If the ring laps them meanwhile they get a gap notice.
+void ReaderHandler::flushTail() {
+	flushScheduled_ = false;
+
+	const std::scoped_lock lock{tail_mtx};
+	bool behind = false;
+	std::vector<EventRing::Event> batch;
+	for (auto& sub : tailSubscribers_) {
+		if (sub.connection->pendingWrites() > 0) {
+			behind = true;
+			continue;
+		}
+
+		batch.clear();
+		sub.dropped += events_.read(sub.cursor, batch, 256);
+		if (batch.empty() && sub.dropped == 0)
+			continue;
+
+		std::string out;
+		if (sub.dropped) {
+			out += "[gap] " + std::to_string(sub.dropped) + " events dropped\n";
+			sub.dropped = 0;
+		}
+		for (const auto& event : batch)
+			out += EventRing::format(event) + '\n';
+		out.pop_back();
+		sub.connection->write<std::string>(out);
+
+		if (sub.cursor < events_.head())
+			behind = true;
+	}
+
+	if (behind) {
+		tailRetry_.expires_after(std::chrono::milliseconds(50));
+		tailRetry_.async_wait([this](const boost::system::error_code& ec) {
+			if (!ec)
+				flushTail();
+		});
+	}
+}
+
+/// Arms the one-second tick of visitors_ unless it is armed already.\n
+/// Ticks stop while no visitor badge is pending and are armed again by whoever schedules the next one.
+void ReaderHandler::scheduleVisitorTick() {
+	if (visitorTicking_.exchange(true))
+		return;
+	visitorTick_.expires_after(std::chrono::seconds(1));
+	visitorTick_.async_wait([this](const boost::system::error_code& ec) {
+		if (ec) {
+			visitorTicking_ = false;
+			return;
+		}
+		expireVisitors();
+	});
+}
+
+/// Turns the visitor wheel to the current second and removes the users whose badge expired.\n
+/// Expired users leave through the same path as rmUser, batched into one config rewrite per tick.
+void ReaderHandler::expireVisitors() {
+	std::vector<std::string> expired;
+	bool pending;
+	{
+		const std::scoped_lock lock{rw_mtx};
+		visitors_.advance(std::time(nullptr), [this, &expired](const UserTable::Id id) {
+			expired.emplace_back(users_.name(id));
+			presence_.forget(id);
+			users_.remove(id);
+		});
+		if (!expired.empty()) {
+			uidFilter_.build(users_); // A Bloom filter can't forget the removed cards
+			if (!saveConfig())
+				DEBUG_OUT("Could not save config after expiring visitors");
+		}
+		pending = visitors_.size() != 0;
+	}
+#ifdef DEBUG
+	for (const auto& name : expired)
+		DEBUG_OUT("Visitor badge of " + name + " expired");
+#endif
+
+	visitorTicking_ = false;
+	if (pending)
+		scheduleVisitorTick();
+}
+
+/// Queues a reed-switch event for doorMonitor_ in events_, next to the approvals it is correlated with.\n
+/// Runs on the client io_context and never touches doorMonitor_ itself, flushDoorEvents() does that on the CLI io_context.
+/// @param event "open:<ms>" or "closed:<ms>", ms being the door client's clock.
+void ReaderHandler::doorEvent(const std::string& door, const std::string& event) {
+	const size_t seperator = event.find(':');
+	const std::string state = event.substr(0, seperator);
+	int64_t sourceMs        = 0;
+	if (seperator != std::string::npos) {
+		try {
+			sourceMs = std::stoll(event.substr(seperator + 1));
+		}
+		catch (const std::exception&) {}
+	}
+	if (state != "open" && state != "closed") {
+		DEBUG_OUT("Invalid door event from " + door + ": " + event);
+		return;
+	}
+	{
+		const std::shared_lock lock{rw_mtx};
+		if (!doors_.contains(door)) {
+			DEBUG_OUT("Door event from unknown door " + door);
+			return;
+		}
+	}
+	events_.push(door, "reed", "-", state, sourceMs);
+	scheduleTailFlush();
+	scheduleDoorFlush();
+}
+
+/// Cards approved at the door by level or rule right now, signed for the offline cache of its client.\n
+/// Doors with a schedule get an empty list, so they stay closed offline rather than open outside their hours.
+/// Anti-passback isn't part of it either, offline decisions don't move anyone between zones.
+/// @param have the version the client holds, "0" for none.
+/// @returns the "@sync:..." payload, empty if sync is disabled or the door is unknown.
+std::string ReaderHandler::doorSnapshot(const std::string& door, const std::string& have) const {
+	if (!doorSync_.enabled())
+		return "";
+
+	std::vector<std::string> entries;
+	{
+		const std::shared_lock lock{rw_mtx};
+		const auto found = doors_.find(door);
+		if (found == doors_.end()) {
+			DEBUG_OUT("Sync from unknown door " + door);
+			return "";
+		}
+		if (found->second.slot == ScheduleTable::always_) {
+			const auto now = std::time(nullptr);
+			users_.forEach([&](const UserTable::Id user) {
+				const uint32_t expires = users_.expires(user);
+				if (expires && expires <= now)
+					return;
+				// Same level and rule check as handleClient
+				const auto effect = policy_.decide(users_.group(user), found->second.zoneId);
+				if (effect == AccessPolicy::Effect::deny || (effect == AccessPolicy::Effect::none && users_.lvl(user) > found->second.lvl))
+					return;
+				users_.forEachCard(user, [&](const std::string_view uid) {
+					if (revoked_.contains(uid))
+						return;
+					std::string entry(uid);
+					if (expires)
+						entry += '=' + std::to_string(expires);
+					entries.push_back(std::move(entry));
+				});
+			});
+		}
+	}
+	std::sort(entries.begin(), entries.end());
+	return doorSync_.reply(door, std::move(entries), have);
+}
+
+/// A decision a door client made from its offline cache while the server was unreachable, uploaded once it reconnected.\n
+/// Logged as offline_approved or offline_denied together with the client's time of the decision. doorMonitor_ doesn't see it,
+/// the openings that went with it were never reported.
+/// @param audit "<uid>:<approved|denied>:<ms>".
+void ReaderHandler::offlineDecision(const std::string& door, const std::string& audit) {
+	const size_t first  = audit.find(':');
+	const size_t second = audit.find(':', first + 1);
+	if (first == std::string::npos || second == std::string::npos) {
+		DEBUG_OUT("Invalid offline decision from " + door + ": " + audit);
+		return;
+	}
+	const std::string uid     = audit.substr(0, first);
+	const std::string outcome = audit.substr(first + 1, second - first - 1);
+	int64_t sourceMs          = 0;
+	try {
+		sourceMs = std::stoll(audit.substr(second + 1));
+	}
+	catch (const std::exception&) {}
+	if (outcome != "approved" && outcome != "denied") {
+		DEBUG_OUT("Invalid offline decision from " + door + ": " + audit);
+		return;
+	}
+
+	std::string userName;
+	{
+		const std::shared_lock lock{rw_mtx};
+		if (!doors_.contains(door)) {
+			DEBUG_OUT("Offline decision from unknown door " + door);
+			return;
+		}
+		const UserTable::Id user = users_.findByUid(uid);
+		userName                 = user != UserTable::none_ ? std::string(users_.name(user)) : "unknown";
+	}
+
+	const std::string access = "offline_" + outcome;
+#ifdef DEBUG
+	const std::time_t seconds = sourceMs / 1000;
+	std::tm tm{};
+#ifdef _WIN32
+	localtime_s(&tm, &seconds);
+#else
+	localtime_r(&seconds, &tm);
+#endif
+	char stamp[32];
+	std::strftime(stamp, sizeof(stamp), "%d/%m/%Y %H:%M:%S", &tm);
+	DEBUG_OUT("Offline decision at " + door + ": " + access + " for " + userName + " at " + stamp);
+#endif
+	events_.push(door, userName, uid, access, sourceMs);
+	scheduleTailFlush();
+	try {
+		// Access stays one of the outcomes, the time the client decided goes in its own column
+		log_.addLog(door, userName, uid, access, sourceMs);
+	}
+	catch (std::exception& e) {
+		DEBUG_OUT(e.what());
+	}
+}
+
+/// Keeps the counts of scans a door client suppressed at its reader, for getMetrics. The client sends its totals, not increments.
+/// @param counts "<duplicates>:<limited>".
+void ReaderHandler::suppressedScans(const std::string& door, const std::string& counts) {
+	SuppressedScans scans{};
+	try {
+		size_t end;
+		scans.duplicates = std::stoull(counts, &end);
+		if (end >= counts.size() || counts[end] != ':')
+			throw std::invalid_argument("no limited count");
+		scans.limited = std::stoull(counts.substr(end + 1));
+	}
+	catch (const std::exception&) {
+		DEBUG_OUT("Invalid scan counts from " + door + ": " + counts);
+		return;
+	}
+	{
+		const std::shared_lock lock{rw_mtx};
+		if (!doors_.contains(door)) {
+			DEBUG_OUT("Scan counts from unknown door " + door);
+			return;
+		}
+	}
+	const std::scoped_lock lock{suppressed_mtx};
+	suppressed_[door] = scans;
+}
+
+void ReaderHandler::scheduleDoorFlush() {
+	if (doorFlushScheduled_.exchange(true))
+		return;
+	boost::asio::post(cliServer_.getContext(), [this] { flushDoorEvents(); });
+}
+
+/// Feeds doorMonitor_ the approvals and door events pushed to events_ since the last flush, in the order they arrived,
+/// and reports what it raised in the log, tail and DEBUG output.\n
+/// Approvals are only read here, each one costs the decision path a coalesced post. A door left open keeps a one-second sweep armed.
+void ReaderHandler::flushDoorEvents() {
+	doorFlushScheduled_ = false;
+
+	std::vector<EventRing::Event> batch;
+	do {
+		batch.clear();
+		// Approvals lapped by the ring anyway, e.g. while the CLI io_context was busy, must not turn their openings into alerts
+		if (events_.read(doorCursor_, batch, 256) > 0)
+			doorMonitor_.lost(batch.empty()
+							  ? std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count()
+							  : batch.front().timeMs);
+		for (const auto& event : batch) {
+			const std::string_view access = event.access;
+			if (access == "approved")
+				doorMonitor_.approved(event.door, event.timeMs);
+			else if (access == "open")
+				doorMonitor_.opened(event.door, event.timeMs, event.sourceMs);
+			else if (access == "closed")
+				doorMonitor_.closed(event.door, event.timeMs, event.sourceMs);
+		}
+	} while (batch.size() == 256);
+
+	doorMonitor_.sweep(std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count());
+
+	for (const auto& alert : doorMonitor_.takeRaised()) {
+		DEBUG_OUT("Door alert: " + DoorMonitor::format(alert));
+		events_.push(alert.door, "alert", "-", DoorMonitor::name(alert.kind));
+		try {
+			log_.addAlert(alert.door, DoorMonitor::name(alert.kind));
+		}
+		catch (std::exception& e) {
+			DEBUG_OUT(e.what());
+		}
+		scheduleTailFlush();
+	}
+
+	if (doorMonitor_.anyOpen() && !doorSweeping_) {
+		doorSweeping_ = true;
+		doorSweep_.expires_after(std::chrono::seconds(1));
+		doorSweep_.async_wait([this](const boost::system::error_code& ec) {
+			doorSweeping_ = false;
+			if (!ec)
+				flushDoorEvents();
+		});
+	}
+}
+
+/// Saves presence_ every few seconds, but only if scans changed it since the last save.
+void ReaderHandler::schedulePresenceFlush() {
+	presenceFlush_.expires_after(std::chrono::seconds(10));
+	presenceFlush_.async_wait([this](const boost::system::error_code& ec) {
+		if (ec)
+			return;
+		flushPresence();
+		schedulePresenceFlush();
+	});
+}
+
+/// Writes presence.snapshot if anyone entered or left a zone since the last write.\n
+/// Only the dump is taken under the shared rw_mtx, scans keep going while the file is written.
+void ReaderHandler::flushPresence() {
+	if (!presence_.takeDirty())
+		return;
+	std::string dump;
+	{
+		const std::shared_lock lock{rw_mtx};
+		dump = presence_.dump(users_, policy_);
+	}
+	if (!PresenceTable::save("presence.snapshot", dump))
+		DEBUG_OUT("Could not write presence.snapshot");
+}
+
+/// Add new user function. Also adds visitors, whose badge expires after a number of hours.
 /// @param connection ptr to the relative TcpConnection object.
 /// @param name string representation of the user to be added i.e. "john_doe".
 /// @param lvl uint8_t representation of the access level for the user to be added i.e. "1".
-void ReaderHandler::newUser(CONNECTION_T connection, const std::string& name, const uint8_t lvl) {
+/// @param hours how long the badge of a visitor works, 0 for a permanent user.
+void ReaderHandler::newUser(CONNECTION_T connection, const std::string& name, const uint8_t lvl, const uint32_t hours) {
 	connection->write<std::string>("Awaiting card read");
-	connection->read<std::string>([this, name, lvl, connection](const std::string& uid) {
-		const std::string confirmMsg("Are you sure you want to add user:\n"
+	connection->read<std::string>([this, name, lvl, hours, connection](const std::string& uid) {
+		const std::string confirmMsg("Are you sure you want to add " + std::string(hours ? "visitor" : "user") + ":\n"
 									 "UID: " + uid + "\n" +
 									 "Name: " + name + "\n" +
-									 "Access Level: " + std::to_string(lvl));
+									 "Access Level: " + std::to_string(lvl) +
+									 (hours ? "\nValid for: " + std::to_string(hours) + " hour(s)" : ""));
 		connection->write<std::string>(confirmMsg);
 
-		connection->read<std::string>([this, name, lvl, uid, connection](const std::string& status) {
+		connection->read<std::string>([this, name, lvl, hours, uid, connection](const std::string& status) {
 			if (status == "denied" || status != "approved") {
 				connection->write<std::string>("Did not add user");
 				handleCli(connection);
 				return;
 			}
 
-			if (addToConfig("users", name, lvl, uid))
+			// The badge is valid from the moment it is approved
+			const uint32_t expires = hours ? static_cast<uint32_t>(std::time(nullptr) + hours * 3600) : 0;
+			if (addToConfig("users", name, lvl, uid, expires))
 				connection->write<std::string>("User added successfully");
 			else
 				connection->write<std::string>("Failed to add user");
@@ -425,20 +1057,104 @@ void ReaderHandler::newDoor(CONNECTION_T connection, const std::string& name, co
 	});
 }
 
+/// Add card function. Works like newUser, but the card goes to an existing user.
+/// @param connection ptr to the relative TcpConnection object.
+/// @param name string representation of the user receiving the card i.e. "john_doe".
+void ReaderHandler::addCard(CONNECTION_T connection, const std::string& name) {
+	{
+		const std::shared_lock lock{rw_mtx};
+		if (users_.findByName(name) == UserTable::none_) {
+			connection->write<std::string>("User could not be found");
+			handleCli(connection);
+			return;
+		}
+	}
+	connection->write<std::string>("Awaiting card read");
+	connection->read<std::string>([this, name, connection](const std::string& uid) {
+		const std::string confirmMsg("Are you sure you want to add card:\n"
+									 "UID: " + uid + "\n" +
+									 "Name: " + name);
+		connection->write<std::string>(confirmMsg);
+
+		connection->read<std::string>([this, name, uid, connection](const std::string& status) {
+			if (status == "denied" || status != "approved") {
+				connection->write<std::string>("Did not add card");
+				handleCli(connection);
+				return;
+			}
+
+			if (addCardToConfig(name, uid))
+				connection->write<std::string>("Card added successfully");
+			else
+				connection->write<std::string>("Failed to add card");
+			handleCli(connection);
+		});
+	});
+}
+
+/// Revoke card function. The card is taken from its owner and denied at every door from then on.
+/// @param connection ptr to the relative TcpConnection object.
+/// @param typedUid UID of the lost or stolen card, in any case.
+void ReaderHandler::revokeCard(CONNECTION_T connection, const std::string& typedUid) {
+	/// Cards are stored as the readers send them, in lowercase hex
+	std::string uid = typedUid;
+	to_lower(uid);
+	if (revoked_.contains(uid)) {
+		connection->write<std::string>("Card is already revoked");
+		handleCli(connection);
+		return;
+	}
+	std::string owner = "none, no user holds this card";
+	{
+		const std::shared_lock lock{rw_mtx};
+		const UserTable::Id id = users_.findByUid(uid);
+		if (id != UserTable::none_)
+			owner = users_.name(id);
+	}
+	const std::string confirmMsg("Are you sure you want to revoke card:\n"
+								 "UID: " + uid + "\n"
+								 "Owner: " + owner);
+	connection->write<std::string>(confirmMsg);
+	connection->read<std::string>([this, uid, connection](const std::string& status) {
+		if (status == "denied" || status != "approved") {
+			connection->write<std::string>("Cancelled revoke operation");
+			handleCli(connection);
+			return;
+		}
+
+		if (revokeCardInConfig(uid))
+			connection->write<std::string>("Card revoked successfully");
+		else
+			connection->write<std::string>("Failed to revoke card");
+		handleCli(connection);
+	});
+}
+
 /// Remove user function.
 /// @param connection ptr to the relative TcpConnection object.
 /// @param name string representation of the user to be removed i.e. "john_doe".
 void ReaderHandler::rmUser(CONNECTION_T connection, const std::string& name) {
-	auto user = usersByName_.find(name);
-	if (user == usersByName_.end()) {
+	std::string uid;
+	int userLvl{};
+	UserTable::Id id;
+	{
+		const std::shared_lock lock{rw_mtx};
+		id = users_.findByName(name);
+		if (id != UserTable::none_) {
+			uid     = users_.uid(id);
+			userLvl = users_.lvl(id);
+		}
+	}
+	// A user whose last card was revoked has no UID, but can still be removed or renamed
+	if (id == UserTable::none_) {
 		connection->write<std::string>("User could not be found");
 		handleCli(connection);
 		return;
 	}
 	const std::string confirmMsg("Are you sure you want to remove user:\n"
-								 "UID: " + user->second.first + "\n"
+								 "UID: " + (uid.empty() ? "none" : uid) + "\n"
 								 "Name: " + name + "\n"
-								 "Access Level: " + std::to_string(user->second.second));
+								 "Access Level: " + std::to_string(userLvl));
 	connection->write<std::string>(confirmMsg);
 	connection->read<std::string>([this, name, connection](const std::string& status) {
 		if (status == "denied" || status != "approved") {
@@ -467,7 +1183,7 @@ void ReaderHandler::rmDoor(CONNECTION_T connection, const std::string& name) {
 	}
 	const std::string confirmMsg("Are you sure you want to remove door:\n"
 								 "Name: " + name + "\n" +
-								 "Access Level: " + std::to_string(door->second));
+								 "Access Level: " + std::to_string(door->second.lvl));
 	connection->write<std::string>(confirmMsg);
 	connection->read<std::string>([this, name, connection](const std::string& status) {
 		if (status == "denied" || status != "approved") {
@@ -476,8 +1192,13 @@ void ReaderHandler::rmDoor(CONNECTION_T connection, const std::string& name) {
 			return;
 		}
 
-		if (removeFromConfig("doors", name))
+		if (removeFromConfig("doors", name)) {
+			doorMonitor_.forget(name);
+			doorSync_.forget(name);
+			const std::scoped_lock lock{suppressed_mtx};
+			suppressed_.erase(name);
 			connection->write<std::string>("Door removed successfully");
+		}
 		else
 			connection->write<std::string>("Failed to remove door");
 		handleCli(connection);
@@ -486,31 +1207,41 @@ void ReaderHandler::rmDoor(CONNECTION_T connection, const std::string& name) {
 
 void ReaderHandler::mvUser(CONNECTION_T connection, const std::string& oldName, const std::string& newName,
 						   uint8_t lvl) {
-	auto user = usersByName_.find(oldName);
-	if (user == usersByName_.end()) {
+	std::string uid;
+	int userLvl{};
+	UserTable::Id id;
+	{
+		const std::shared_lock lock{rw_mtx};
+		id = users_.findByName(oldName);
+		if (id != UserTable::none_) {
+			uid     = users_.uid(id);
+			userLvl = users_.lvl(id);
+		}
+	}
+	// A user whose last card was revoked has no UID, but can still be removed or renamed
+	if (id == UserTable::none_) {
 		connection->write<std::string>("User could not be found");
 		handleCli(connection);
 		return;
 	}
 	if (lvl == 0)
-		lvl = user->second.second;
+		lvl = userLvl;
 
 	const std::string confirmMsg("Are you sure you want to edit user:\n"
-								 "UID: " + user->second.first + "\n"
+								 "UID: " + (uid.empty() ? "none" : uid) + "\n"
 								 "Name: " + oldName + " -> " + newName + "\n"
-								 "Access Level: " + std::to_string(user->second.second) + " -> " + std::to_string(lvl) +
+								 "Access Level: " + std::to_string(userLvl) + " -> " + std::to_string(lvl) +
 								 "\n"
 								);
-	std::string uid = user->second.first;
 	connection->write<std::string>(confirmMsg);
-	connection->read<std::string>([this, uid, oldName, newName, lvl, connection](const std::string& status) {
+	connection->read<std::string>([this, oldName, newName, lvl, connection](const std::string& status) {
 		if (status == "denied" || status != "approved") {
 			connection->write<std::string>("Cancelled edit operation");
 			handleCli(connection);
 			return;
 		}
 
-		if (removeFromConfig("users", oldName) && addToConfig("users", newName, lvl, uid))
+		if (editInConfig("users", oldName, newName, lvl))
 			connection->write<std::string>("User edited successfully");
 		else
 			connection->write<std::string>("Failed to edit user, data may be corrupted");
@@ -528,11 +1259,11 @@ void ReaderHandler::mvDoor(CONNECTION_T connection, const std::string& oldName,
 	}
 
 	if (lvl == 0)
-		lvl = door->second;
+		lvl = door->second.lvl;
 
 	const std::string confirmMsg("Are you sure you want to edit door:\n"
 								 "Name: " + oldName + " -> " + newName + "\n"
-								 "Access Level: " + std::to_string(door->second) + " -> " + std::to_string(lvl) + "\n"
+								 "Access Level: " + std::to_string(door->second.lvl) + " -> " + std::to_string(lvl) + "\n"
 								);
 	connection->write<std::string>(confirmMsg);
 	connection->read<std::string>([this, oldName, newName, lvl, connection](const std::string& status) {
@@ -542,8 +1273,15 @@ void ReaderHandler::mvDoor(CONNECTION_T connection, const std::string& oldName,
 			return;
 		}
 
-		if (removeFromConfig("doors", oldName) && addToConfig("doors", newName, lvl))
+		if (editInConfig("doors", oldName, newName, lvl)) {
+			if (newName != oldName) {
+				doorMonitor_.forget(oldName);
+				doorSync_.forget(oldName);
+				const std::scoped_lock lock{suppressed_mtx};
+				suppressed_.erase(oldName);
+			}
 			connection->write<std::string>("Door edited successfully");
+		}
 		else
 			connection->write<std::string>("Failed to edit door, data may be corrupted");
 		handleCli(connection);
@@ -562,13 +1300,385 @@ std::string ReaderHandler::getDoorLog(const std::string& name) {
 	return log_.getLogByDoor(name);
 }
 
-bool ReaderHandler::addToConfig(const std::string& type, const std::string& name, uint8_t lvl, const std::string& uid) {
+/// Adds an opening window to a schedule, creating the schedule if it doesn't exist yet.
+/// @param name schedule name.
+/// @param text window as "mon-fri 07:00-18:00".
+/// @returns reply for the CLI.
+std::string ReaderHandler::addWindow(const std::string& name, const std::string& text) {
+	ScheduleTable::Window window{};
+	if (!ScheduleTable::parseWindow(text, window))
+		return "Invalid window - use days and times like mon-fri 07:00-18:00";
+
+	const std::scoped_lock lock{rw_mtx};
+	if (!schedules_.addWindow(name, window))
+		return "Schedule already has that window";
+	schedules_.bind(doors_);
+	return saveConfig() ? "Window added successfully" : "Failed to save config";
+}
+
+/// Adds a holiday to a schedule. Doors of the schedule stay closed all day.
+/// @param name schedule name.
+/// @param text "24/12" for every year or "24/12/2026" for one date.
+/// @returns reply for the CLI.
+std::string ReaderHandler::addHoliday(const std::string& name, const std::string& text) {
+	ScheduleTable::Holiday holiday{};
+	if (!ScheduleTable::parseHoliday(text, holiday))
+		return "Invalid date - use dd/mm or dd/mm/yyyy";
+
+	const std::scoped_lock lock{rw_mtx};
+	if (!schedules_.contains(name))
+		return "Schedule could not be found";
+	if (!schedules_.addHoliday(name, holiday))
+		return "Schedule already has that holiday";
+	schedules_.bind(doors_);
+	return saveConfig() ? "Holiday added successfully" : "Failed to save config";
+}
+
+/// Puts a door on a schedule, or takes it off with "none".
+/// @returns reply for the CLI.
+std::string ReaderHandler::setSchedule(const std::string& door, const std::string& schedule) {
+	const std::scoped_lock lock{rw_mtx};
+	const auto entry = doors_.find(door);
+	if (entry == doors_.end())
+		return "Door could not be found";
+	if (schedule != "none" && !schedules_.contains(schedule))
+		return "Schedule could not be found";
+
+	entry->second.schedule = schedule == "none" ? "" : schedule;
+	schedules_.bind(doors_);
+	return saveConfig() ? "Schedule set successfully" : "Failed to save config";
+}
+
+/// Remove schedule function. Refused while doors still use the schedule, so no door is left closed by accident.
+/// @param connection ptr to the relative TcpConnection object.
+/// @param name schedule name.
+void ReaderHandler::rmSchedule(CONNECTION_T connection, const std::string& name) {
+	size_t doorCount = 0;
+	{
+		const std::shared_lock lock{rw_mtx};
+		if (!schedules_.contains(name)) {
+			connection->write<std::string>("Schedule could not be found");
+			handleCli(connection);
+			return;
+		}
+		for (const auto& [door, entry] : doors_)
+			doorCount += entry.schedule == name;
+	}
+	if (doorCount) {
+		connection->write<std::string>("Schedule is still used by " + std::to_string(doorCount) + " door(s)");
+		handleCli(connection);
+		return;
+	}
+
+	connection->write<std::string>("Are you sure you want to remove schedule:\n"
+								   "Name: " + name);
+	connection->read<std::string>([this, name, connection](const std::string& status) {
+		if (status == "denied" || status != "approved") {
+			connection->write<std::string>("Cancelled remove operation");
+			handleCli(connection);
+			return;
+		}
+
+		bool removed;
+		{
+			const std::scoped_lock lock{rw_mtx};
+			removed = schedules_.remove(name);
+			schedules_.bind(doors_);
+			removed = removed && saveConfig();
+		}
+		connection->write<std::string>(removed ? "Schedule removed successfully" : "Failed to remove schedule");
+		handleCli(connection);
+	});
+}
+
+/// Lists every schedule with its windows, holidays and doors.
+/// @returns formatted schedules.
+std::string ReaderHandler::getSchedules() const {
+	const std::shared_lock lock{rw_mtx};
+	return schedules_.describe(doors_);
+}
+
+/// Puts a user in a group, or takes them out of theirs with "none". The group is created on first use.
+/// @returns reply for the CLI.
+std::string ReaderHandler::setGroup(const std::string& name, const std::string& group) {
+	const std::scoped_lock lock{rw_mtx};
+	const UserTable::Id id = users_.findByName(name);
+	if (id == UserTable::none_)
+		return "User could not be found";
+
+	const UserTable::Group groupId = group == "none" ? UserTable::noGroup_ : users_.internGroup(group);
+	if (group != "none" && groupId == UserTable::noGroup_)
+		return "Too many groups";
+	users_.setGroup(id, groupId);
+	policy_.publish(users_, doors_);
+	return saveConfig() ? "Group set successfully" : "Failed to save config";
+}
+
+/// Puts a door in a zone, or takes it out of its zone with "none".
+/// @returns reply for the CLI.
+std::string ReaderHandler::setZone(const std::string& door, const std::string& zone) {
+	const std::scoped_lock lock{rw_mtx};
+	const auto entry = doors_.find(door);
+	if (entry == doors_.end())
+		return "Door could not be found";
+
+	entry->second.zone = zone == "none" ? "" : zone;
+	policy_.publish(users_, doors_);
+	presence_.resize(users_.idLimit(), policy_.zoneCount());
+	return saveConfig() ? "Zone set successfully" : "Failed to save config";
+}
+
+/// Adds an allow or deny rule. Groups and zones don't have to exist yet, the rule applies once they do.
+/// @param group group name or "*" for every user.
+/// @param zone zone name or "*" for every door.
+/// @returns reply for the CLI.
+std::string ReaderHandler::addRule(const AccessPolicy::Effect effect, const std::string& group, const std::string& zone) {
+	const std::scoped_lock lock{rw_mtx};
+	if (!policy_.add({effect, group, zone}))
+		return "Rule already exists";
+	policy_.publish(users_, doors_);
+	return saveConfig() ? "Rule added successfully" : "Failed to save config";
+}
+
+/// Removes the allow and deny rules between a group and a zone.
+/// @returns reply for the CLI.
+std::string ReaderHandler::rmRule(const std::string& group, const std::string& zone) {
+	const std::scoped_lock lock{rw_mtx};
+	const size_t removed = policy_.remove(group, zone);
+	if (!removed)
+		return "Rule could not be found";
+	policy_.publish(users_, doors_);
+	return saveConfig() ? "Removed " + std::to_string(removed) + " rule(s) successfully" : "Failed to save config";
+}
+
+/// Gives a user a badge that expires in a number of hours, or makes it permanent again with "none".\n
+/// Works on visitors and regular users alike, e.g. to extend a day pass.
+/// @returns reply for the CLI.
+std::string ReaderHandler::setExpiry(const std::string& name, const std::string& hours) {
+	const std::scoped_lock lock{rw_mtx};
+	const UserTable::Id id = users_.findByName(name);
+	if (id == UserTable::none_)
+		return "User could not be found";
+
+	if (hours == "none") {
+		users_.setExpires(id, 0);
+		visitors_.cancel(id);
+	} else {
+		const auto expires = static_cast<uint32_t>(std::time(nullptr) + std::stoul(hours) * 3600);
+		users_.setExpires(id, expires);
+		visitors_.schedule(id, expires);
+		scheduleVisitorTick();
+	}
+	return saveConfig() ? "Expiry set successfully" : "Failed to save config";
+}
+
+/// Lists the users with an expiring badge, soonest first.
+/// @returns formatted visitors.
+std::string ReaderHandler::getVisitors() const {
+	const std::shared_lock lock{rw_mtx};
+	auto visitors = visitors_.list();
+	if (visitors.empty())
+		return "No visitors";
+	std::ranges::sort(visitors, {}, [](const auto& visitor) { return visitor.second; });
+
+	std::string out = "Visitors:";
+	for (const auto& [id, expires] : visitors) {
+		const auto time = static_cast<std::time_t>(expires);
+		std::tm local{};
+#ifdef _WIN32
+		localtime_s(&local, &time);
+#else
+		localtime_r(&time, &local);
+#endif
+		char buf[32];
+		std::strftime(buf, sizeof(buf), "%d/%m/%Y %H:%M", &local);
+		out.append("\n  ").append(users_.name(id)).append(" until ").append(buf);
+	}
+	return out;
+}
+
+/// Makes a door an entry or exit door of its zone for anti-passback, or neither with "none".
+/// @returns reply for the CLI.
+std::string ReaderHandler::setDirection(const std::string& door, const std::string& direction) {
+	const std::scoped_lock lock{rw_mtx};
+	const auto entry = doors_.find(door);
+	if (entry == doors_.end())
+		return "Door could not be found";
+	if (direction != "none" && entry->second.zone.empty())
+		return "Door must be in a zone first";
+
+	entry->second.direction = direction == "in"    ? ConfigSnapshot::Door::Direction::entry
+							  : direction == "out" ? ConfigSnapshot::Door::Direction::exit
+							  : ConfigSnapshot::Door::Direction::none;
+	return saveConfig() ? "Direction set successfully" : "Failed to save config";
+}
+
+/// Puts a user outside every zone, e.g. after they left without badging out and are locked out by anti-passback.
+/// @returns reply for the CLI.
+std::string ReaderHandler::clearPresence(const std::string& name) {
+	const std::scoped_lock lock{rw_mtx};
+	const UserTable::Id id = users_.findByName(name);
+	if (id == UserTable::none_)
+		return "User could not be found";
+	const uint16_t zone = presence_.forget(id);
+	return zone == PresenceTable::outside_ ? "User is not inside any zone" : "Cleared " + name + " from zone " + policy_.zoneName(zone);
+}
+
+/// Users inside one zone, or inside every zone, read from the counters.
+/// @param zone zone name, empty for every zone.
+/// @returns formatted counts.
+std::string ReaderHandler::getOccupancy(const std::string& zone) const {
+	const std::shared_lock lock{rw_mtx};
+	if (!zone.empty()) {
+		const uint16_t id = policy_.findZone(zone);
+		if (id == PresenceTable::outside_)
+			return "Zone could not be found";
+		return zone + ": " + std::to_string(presence_.count(id)) + " inside";
+	}
+
+	if (policy_.zoneCount() == 1)
+		return "No zones";
+	std::string out = "Occupancy:";
+	for (uint16_t id = 1; id < policy_.zoneCount(); ++id)
+		out += "\n  " + policy_.zoneName(id) + ": " + std::to_string(presence_.count(id));
+	return out;
+}
+
+/// Names of the users inside a zone. Walks every user, unlike getOccupancy.
+/// @returns one name per line.
+std::string ReaderHandler::getOccupants(const std::string& zone) const {
+	const std::shared_lock lock{rw_mtx};
+	const uint16_t id = policy_.findZone(zone);
+	if (id == PresenceTable::outside_)
+		return "Zone could not be found";
+
+	std::string out = "Inside " + zone + " (" + std::to_string(presence_.count(id)) + "):";
+	users_.forEach([&](const UserTable::Id user) {
+		if (presence_.zoneOf(user) == id)
+			out.append("\n  ").append(users_.name(user));
+	});
+	return out;
+}
+
+/// Door states, opening and alert counts, and the most recent alerts from doorMonitor_.
+/// @returns formatted report.
+std::string ReaderHandler::getDoorAlerts() const {
+	return doorMonitor_.describe();
+}
+
+/// Lists every rule in the order they were added.
+/// @returns formatted rules.
+std::string ReaderHandler::getRules() const {
+	const std::shared_lock lock{rw_mtx};
+	return policy_.describe();
+}
+
+/// Walks through the decision handleClient would make right now for a user at a door.
+/// @param name snake_case user name.
+/// @param door door name.
+/// @returns every input of the decision and its outcome.
+std::string ReaderHandler::explain(const std::string& name, const std::string& door) const {
+	const std::shared_lock lock{rw_mtx};
+	const UserTable::Id id = users_.findByName(name);
+	if (id == UserTable::none_)
+		return "User could not be found";
+	const auto entry = doors_.find(door);
+	if (entry == doors_.end())
+		return "Door could not be found";
+
+	const std::string& group = users_.groupName(users_.group(id));
+	const auto& [lvl, schedule, zone, direction, slot, zoneId] = entry->second;
+	std::string out = name + " at " + door + ":\n"
+					  "  user: level " + std::to_string(users_.lvl(id)) + ", group " + (group.empty() ? "none" : group) + "\n"
+					  "  door: level " + std::to_string(lvl) + ", zone " + (zone.empty() ? "none" : zone) + "\n";
+	out += policy_.explain(group, zone) + '\n';
+
+	// Same inputs as handleClient, so the answer matches the next scan
+	const auto effect  = policy_.decide(users_.group(id), zoneId);
+	const bool levelOk = effect == AccessPolicy::Effect::allow || (effect == AccessPolicy::Effect::none && users_.lvl(id) <= lvl);
+	if (effect == AccessPolicy::Effect::none)
+		out += std::string("  level check: ") + (levelOk ? "passed" : "failed") + '\n';
+	bool inSchedule = true;
+	if (slot != ScheduleTable::always_) {
+		const LogClock::Local now = LogClock::local();
+		inSchedule                = schedules_.allows(slot, now.minuteOfWeek, now.day);
+	}
+	out += "  schedule: " + (schedule.empty() ? std::string("none") : schedule + (inSchedule ? ", open now" : ", closed now")) + '\n';
+	const bool hasCard = !users_.uid(id).empty();
+	if (!hasCard)
+		out += "  user has no cards\n";
+	const bool expired = users_.expires(id) && users_.expires(id) <= std::time(nullptr);
+	if (users_.expires(id)) {
+		const auto time = static_cast<std::time_t>(users_.expires(id));
+		std::tm local{};
+#ifdef _WIN32
+		localtime_s(&local, &time);
+#else
+		localtime_r(&time, &local);
+#endif
+		char buf[32];
+		std::strftime(buf, sizeof(buf), "%d/%m/%Y %H:%M", &local);
+		out += std::string("  badge: ") + (expired ? "expired " : "expires ") + buf + '\n';
+	}
+	const uint16_t inside = presence_.zoneOf(id);
+	const bool passback   = direction == ConfigSnapshot::Door::Direction::entry && inside == zoneId;
+	if (direction != ConfigSnapshot::Door::Direction::none)
+		out += std::string("  presence: ") + (direction == ConfigSnapshot::Door::Direction::entry ? "entry" : "exit") + " door, user is "
+			   + (inside == PresenceTable::outside_ ? "outside every zone" : "inside " + policy_.zoneName(inside))
+			   + (passback ? " - anti-passback" : "") + '\n';
+	out += std::string("  result: ") + (hasCard && !expired && levelOk && inSchedule && !passback ? "approved" : "denied");
+	return out;
+}
+
+/// Lists the cards of a user.
+/// @param name snake_case user name.
+/// @returns one UID per line, or an error line if the user doesn't exist.
+std::string ReaderHandler::getCards(const std::string& name) const {
+	const std::shared_lock lock{rw_mtx};
+	const UserTable::Id id = users_.findByName(name);
+	if (id == UserTable::none_)
+		return "User could not be found";
+
+	std::string out = "Cards of " + name + ":";
+	users_.forEachCard(id, [&out](const std::string_view uid) { out.append("\n  ").append(uid); });
+	return out;
+}
+
+/// Access statistics merged from the in-memory counters. No csv-files are read.
+/// @param hours window in hours, empty for lifetime totals.
+/// @returns formatted approved/denied/unknown counts per door and per user.
+std::string ReaderHandler::getStats(const std::string& hours) const {
+	return AccessStats::format(stats_.merge(hours.empty() ? 0 : std::stoul(hours)));
+}
+
+/// Runtime metrics that aren't access statistics: audit log commit latency and batch sizes, how many scans the UID filter answered,
+/// and how many scans the door clients suppressed before sending them.
+/// @returns formatted metrics.
+std::string ReaderHandler::getMetrics() const {
+	UidFilter::Metrics filter;
+	{
+		const std::shared_lock lock{rw_mtx};
+		filter = uidFilter_.metrics();
+	}
+	std::string readers = "Suppressed at the readers:";
+	{
+		const std::scoped_lock lock{suppressed_mtx};
+		if (suppressed_.empty())
+			readers += " none reported";
+		for (const auto& [door, scans] : suppressed_)
+			readers += "\n  " + door + ": " + std::to_string(scans.duplicates) + " duplicates, " + std::to_string(scans.limited) + " rate limited";
+	}
+	return CsvLogger::format(log_.metrics(), log_.durability()) + '\n' + UidFilter::format(filter) + '\n' + readers;
+}
+
+/// @param expires Unix time a visitor badge stops working, 0 for a permanent user.
+bool ReaderHandler::addToConfig(const std::string& type, const std::string& name, uint8_t lvl, const std::string& uid, const uint32_t expires) {
 	// Assert type is correct. Cannot use compile-time asserts on string comparisons, maybe use const char* instead in the future.
 	if (type != "doors" && type != "users") {
 		DEBUG_OUT("Type must be either 'doors' or 'users'");
 		return false;
 	}
-	if (type == "users" && usersByUid_.contains(uid)) {
+	if (type == "users" && users_.findByUid(uid) != UserTable::none_) {
 		DEBUG_OUT("UID already exists");
 		return false;
 	}
@@ -578,10 +1688,10 @@ bool ReaderHandler::addToConfig(const std::string& type, const std::string& name
 		return false;
 	}
 #ifdef DEBUG
-	if (type == "users" && !usersByUid_.contains(uid)) {
+	if (type == "users" && users_.findByUid(uid) == UserTable::none_) {
 		{
 			ogga::scopetimer("Lookup time for users in memory: ", "ns");
-			usersByUid_.find(uid);
+			users_.findByUid(uid);
 		}
 	}
 	if (type == "doors" && !doors_.contains(name)) {
@@ -599,42 +1709,25 @@ bool ReaderHandler::addToConfig(const std::string& type, const std::string& name
 	// Lock before editing any runtime memory/config.json
 	const std::scoped_lock lock{rw_mtx};
 
-	// config.json error syntax checks
-	nlohmann::json configJson;
-	assertConfig(configJson);
-
-	if (!configJson.contains(type))
-		configJson[type] = nlohmann::json::array();
-
-	nlohmann::json addition;
-
 	if (type == "users") {
-		usersByName_[addedName] = {addedUid, lvl};
-		usersByUid_[addedUid]   = {addedName, lvl};
-		addition                = {
-			{"name", addedName},
-			{"uid", addedUid},
-			{"lvl", lvl}
-		};
-	} else {
-		doors_[addedName] = lvl;
-		addition          = {
-			{"name", addedName},
-			{"lvl", lvl}
-		};
-	}
-
-	configJson[type].push_back(addition);
-
-	// Save changes to config.json. Using temporary file and rename for safer patch appliance.
-	{
-		std::ofstream out{"config_tmp.json"};
-		out << configJson.dump(4);
-		out.close();
-	}
-	std::filesystem::rename("config_tmp.json", "config.json");
-
-	return true;
+		const UserTable::Id id = users_.add(addedName, addedUid, lvl);
+		if (id == UserTable::none_) {
+			DEBUG_OUT("User name or UID already exists");
+			return false;
+		}
+		if (expires) {
+			users_.setExpires(id, expires);
+			visitors_.schedule(id, expires);
+			scheduleVisitorTick();
+		}
+		presence_.resize(users_.idLimit(), policy_.zoneCount());
+		revoked_.restore(addedUid); // A recovered card handed out again
+		if (!uidFilter_.insert(addedUid))
+			uidFilter_.build(users_);
+	} else
+		doors_[addedName] = {.lvl = lvl};
+
+	return saveConfig();
 }
 
 bool ReaderHandler::removeFromConfig(const std::string& type, const std::string& name) {
@@ -649,52 +1742,94 @@ bool ReaderHandler::removeFromConfig(const std::string& type, const std::string&
 	const std::scoped_lock lock{rw_mtx};
 	// Remove from memory
 	if (type == "users") {
-		const auto& user = usersByName_.find(name);
-		usersByUid_.erase(user->second.first); // remove by uid
-		usersByName_.erase(user);
+		const UserTable::Id id = users_.findByName(name);
+		if (!users_.remove(id))
+			return false;
+		// The ID goes to the next new user
+		visitors_.cancel(id);
+		presence_.forget(id);
+		uidFilter_.build(users_); // A Bloom filter can't forget the removed cards
+	} else if (!doors_.erase(name))
+		return false;
+
+	return saveConfig();
+}
+
+/// Renames and/or relevels a user or door in place. The UID and ID of a user are kept.
+/// @param lvl new access level.
+/// @returns false if oldName doesn't exist or newName is taken.
+bool ReaderHandler::editInConfig(const std::string& type, const std::string& oldName, const std::string& newName, const uint8_t lvl) {
+	const std::scoped_lock lock{rw_mtx};
+	if (type == "users") {
+		const UserTable::Id id = users_.findByName(oldName);
+		if (id == UserTable::none_ || !users_.rename(id, newName))
+			return false;
+		users_.setLevel(id, lvl);
 	} else if (type == "doors") {
-		const auto& door = doors_.find(name);
-		doors_.erase(door);
-	}
+		if (newName != oldName && doors_.contains(newName))
+			return false;
+		auto door = doors_.extract(oldName);
+		if (door.empty())
+			return false;
+		door.key()        = newName;
+		door.mapped().lvl = lvl; // The schedule stays with the door
+		doors_.insert(std::move(door));
+	} else
+		return false;
 
-	// config.json error syntax checks
-	nlohmann::json configJson;
-	assertConfig(configJson);
+	return saveConfig();
+}
 
-	// Rewrite related config.json segment
-	if (configJson.contains(type)) {
-		auto& revisedJson = configJson[type];
-		for (auto it = revisedJson.begin(); it != revisedJson.end(); ++it) {
-			if (it->contains("name") && (*it)["name"] == name) {
-				revisedJson.erase(it);
-				break;
-			}
-		}
+/// Rewrites config.json from the in-memory tables, then refreshes config.bin.\n
+/// Caller must hold rw_mtx.
+/// @returns false if config.json could not be written.
+bool ReaderHandler::saveConfig() const {
+	const std::vector<std::string> revoked = revoked_.list();
+	const std::string schedules            = schedules_.json();
+	const std::string rules                = policy_.json();
+	if (!ConfigFile::save("config.json", doors_, users_, revoked, logsConfig_, schedules, rules)) {
+		DEBUG_OUT("Could not write config.json");
+		return false;
 	}
+	// config.json now holds everything the journal did
+	journal_.clear();
+	if (!ConfigSnapshot::save("config.bin", "config.json", doors_, users_, revoked, logsConfig_, schedules, rules))
+		DEBUG_OUT("Could not write config.bin, next start imports config.json");
+	return true;
+}
 
-	// Save changes to config.json. Using temporary file and rename for safer patch appliance.
-	{
-		std::ofstream out{"config_tmp.json"};
-		out << configJson.dump(4);
-		out.close();
-	}
-	std::filesystem::rename("config_tmp.json", "config.json");
+/// Gives an existing user another card. Journaled, config.json is not rewritten.
+/// @returns false if the user doesn't exist, the card belongs to someone or the journal could not be written.
+bool ReaderHandler::addCardToConfig(const std::string& name, const std::string& uid) {
+	std::string addedUid = uid;
+	to_snake_case(addedUid);
 
+	const std::scoped_lock lock{rw_mtx};
+	const UserTable::Id id = users_.findByName(name);
+	if (id == UserTable::none_ || users_.findByUid(addedUid) != UserTable::none_)
+		return false;
+	// Disk first, so memory never holds a card a restart would lose
+	if (!journal_.append("addCard " + name + " " + addedUid))
+		return false;
+
+	users_.addCard(id, addedUid);
+	revoked_.restore(addedUid);
+	if (!uidFilter_.insert(addedUid))
+		uidFilter_.build(users_);
 	return true;
 }
 
-void ReaderHandler::assertConfig(nlohmann::json& configJson) {
-	try {
-		std::ifstream in("config.json");
-		if (in && in.peek() != std::ifstream::traits_type::eof())
-			in >> configJson;
-		else
-			configJson = {{"users", nlohmann::json::array()}, {"doors", nlohmann::json::array()}};
-	}
-	catch (const nlohmann::json::parse_error& e) {
-		DEBUG_OUT("Invalid JSON @ config.json, attempting clean overwrite - " + std::string(e.what()));
-		configJson = {{"users", nlohmann::json::array()}, {"doors", nlohmann::json::array()}};
-	}
+/// Revokes a card, taking it from its owner. Journaled, config.json is not rewritten.
+/// @returns false if the card is already revoked or the journal could not be written.
+bool ReaderHandler::revokeCardInConfig(const std::string& uid) {
+	const std::scoped_lock lock{rw_mtx};
+	if (revoked_.contains(uid) || !journal_.append("revokeCard " + uid))
+		return false;
+
+	if (users_.removeCard(uid) != UserTable::none_)
+		uidFilter_.build(users_);
+	revoked_.revoke(uid);
+	return true;
 }
 
 ReaderHandler::CmdArgs ReaderHandler::parseSyntax(const std::string& data, Command type) {
@@ -761,6 +1896,113 @@ ReaderHandler::CmdArgs ReaderHandler::parseSyntax(const std::string& data, Comma
 			if (!std::regex_match(data, match, doorLogSyntax))
 				return error;
 			break;
+		case addCard_:
+			static const std::regex addCardSyntax(R"(^addCard\s+([A-Za-z0-9_]+)$)");
+			if (!std::regex_match(data, match, addCardSyntax))
+				return error;
+			break;
+		case revokeCard_:
+			static const std::regex revokeCardSyntax(R"(^revokeCard\s+([A-Za-z0-9_]+)$)");
+			if (!std::regex_match(data, match, revokeCardSyntax))
+				return error;
+			// A UID, not a name. revokeCard lowercases it, to_snake_case would put underscores between its hex digits.
+			return CmdArgs{match[1].str(), "-1", lvl};
+		case getCards_:
+			static const std::regex getCardsSyntax(R"(^getCards\s+([A-Za-z0-9_]+)$)");
+			if (!std::regex_match(data, match, getCardsSyntax))
+				return error;
+			break;
+		case addWindow_:
+			static const std::regex addWindowSyntax(
+				R"(^addWindow\s+([A-Za-z0-9_]+)\s+((?:daily|[a-z]{3}(?:-[a-z]{3})?)\s+[0-9]{2}:[0-9]{2}-[0-9]{2}:[0-9]{2})$)");
+			if (!std::regex_match(data, match, addWindowSyntax))
+				return error;
+			break;
+		case addHoliday_:
+			static const std::regex addHolidaySyntax(R"(^addHoliday\s+([A-Za-z0-9_]+)\s+([0-9]{2}/[0-9]{2}(?:/[0-9]{4})?)$)");
+			if (!std::regex_match(data, match, addHolidaySyntax))
+				return error;
+			break;
+		case setSchedule_:
+			static const std::regex setScheduleSyntax(R"(^setSchedule\s+([A-Za-z0-9_]+)\s+([A-Za-z0-9_]+)$)");
+			if (!std::regex_match(data, match, setScheduleSyntax))
+				return error;
+			break;
+		case rmSchedule_:
+			static const std::regex rmScheduleSyntax(R"(^rmSchedule\s+([A-Za-z0-9_]+)$)");
+			if (!std::regex_match(data, match, rmScheduleSyntax))
+				return error;
+			break;
+		case setGroup_:
+			static const std::regex setGroupSyntax(R"(^setGroup\s+([A-Za-z0-9_]+)\s+([A-Za-z0-9_]+)$)");
+			if (!std::regex_match(data, match, setGroupSyntax))
+				return error;
+			break;
+		case setZone_:
+			static const std::regex setZoneSyntax(R"(^setZone\s+([A-Za-z0-9_]+)\s+([A-Za-z0-9_]+)$)");
+			if (!std::regex_match(data, match, setZoneSyntax))
+				return error;
+			break;
+		case allow_:
+			static const std::regex allowSyntax(R"(^allow\s+([A-Za-z0-9_]+|\*)\s+([A-Za-z0-9_]+|\*)$)");
+			if (!std::regex_match(data, match, allowSyntax))
+				return error;
+			break;
+		case deny_:
+			static const std::regex denySyntax(R"(^deny\s+([A-Za-z0-9_]+|\*)\s+([A-Za-z0-9_]+|\*)$)");
+			if (!std::regex_match(data, match, denySyntax))
+				return error;
+			break;
+		case rmRule_:
+			static const std::regex rmRuleSyntax(R"(^rmRule\s+([A-Za-z0-9_]+|\*)\s+([A-Za-z0-9_]+|\*)$)");
+			if (!std::regex_match(data, match, rmRuleSyntax))
+				return error;
+			break;
+		case explain_:
+			static const std::regex explainSyntax(R"(^explain\s+([A-Za-z0-9_]+)\s+([A-Za-z0-9_]+)$)");
+			if (!std::regex_match(data, match, explainSyntax))
+				return error;
+			break;
+		case newVisitor_:
+			static const std::regex newVisitorSyntax(R"(^newVisitor\s+([A-Za-z0-9_]+)\s+([0-9]+)\s+([1-9][0-9]{0,3})$)");
+			if (!std::regex_match(data, match, newVisitorSyntax))
+				return error;
+			{
+				// Level comes before the hours on the command line, unlike the name pair the other commands return
+				std::string name = match[1].str();
+				to_snake_case(name);
+				return CmdArgs{name, match[3].str(), static_cast<uint8_t>(std::stoul(match[2].str()))};
+			}
+		case setExpiry_:
+			static const std::regex setExpirySyntax(R"(^setExpiry\s+([A-Za-z0-9_]+)\s+([1-9][0-9]{0,3}|none)$)");
+			if (!std::regex_match(data, match, setExpirySyntax))
+				return error;
+			break;
+		case setDirection_:
+			static const std::regex setDirectionSyntax(R"(^setDirection\s+([A-Za-z0-9_]+)\s+(in|out|none)$)");
+			if (!std::regex_match(data, match, setDirectionSyntax))
+				return error;
+			break;
+		case clearPresence_:
+			static const std::regex clearPresenceSyntax(R"(^clearPresence\s+([A-Za-z0-9_]+)$)");
+			if (!std::regex_match(data, match, clearPresenceSyntax))
+				return error;
+			break;
+		case getOccupancy_:
+			static const std::regex getOccupancySyntax(R"(^getOccupancy(?:\s+([A-Za-z0-9_]+))?$)");
+			if (!std::regex_match(data, match, getOccupancySyntax))
+				return error;
+			break;
+		case getOccupants_:
+			static const std::regex getOccupantsSyntax(R"(^getOccupants\s+([A-Za-z0-9_]+)$)");
+			if (!std::regex_match(data, match, getOccupantsSyntax))
+				return error;
+			break;
+		case statistics_:
+			static const std::regex statsSyntax(R"(^getStats(?:\s+([0-9]{1,3}))?$)");
+			if (!std::regex_match(data, match, statsSyntax))
+				return error;
+			break;
 
 		default:
 			return error;
@@ -827,3 +2069,11 @@ void ReaderHandler::to_snake_case(Args&... args) {
 	};
 	(convertOne(args), ...);
 }
+
+/// Lowercases a card UID in place. Unlike to_snake_case it never inserts underscores, so hex digits stay as they are.
+/// @param uid UID as typed on the CLI or read from config.journal.
+/// @returns void
+void ReaderHandler::to_lower(std::string& uid) {
+	for (char& c : uid)
+		c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
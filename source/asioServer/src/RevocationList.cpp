@@ -0,0 +1,91 @@
+#include "RevocationList.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+namespace {
+	constexpr int probes = 4;
+}
+
+RevocationList::RevocationList() : snapshot_(std::make_shared<const Snapshot>(std::vector<std::string>{})) {}
+
+RevocationList::Snapshot::Snapshot(std::vector<std::string> sorted) : uids(std::move(sorted)),
+																	  bloom(std::bit_ceil(std::max<size_t>(uids.size() * 8, 512)) / 64) {
+	const uint64_t mask = bloom.size() * 64 - 1;
+	for (const auto& uid : uids) {
+		// Double hashing, h1 + i * h2 gives the probe positions from one 64-bit hash
+		const uint64_t hash = hashOf(uid);
+		const uint64_t h2   = (hash >> 32) | 1;
+		for (int i = 0; i < probes; ++i) {
+			const uint64_t bit = (hash + i * h2) & mask;
+			bloom[bit / 64] |= uint64_t{1} << (bit % 64);
+		}
+	}
+}
+
+bool RevocationList::Snapshot::mightContain(const uint64_t hash) const {
+	const uint64_t mask = bloom.size() * 64 - 1;
+	const uint64_t h2   = (hash >> 32) | 1;
+	for (int i = 0; i < probes; ++i) {
+		const uint64_t bit = (hash + i * h2) & mask;
+		if (!(bloom[bit / 64] & (uint64_t{1} << (bit % 64))))
+			return false;
+	}
+	return true;
+}
+
+uint64_t RevocationList::hashOf(const std::string_view uid) {
+	return std::hash<std::string_view>{}(uid);
+}
+
+bool RevocationList::contains(const std::string_view uid) const {
+	const auto snapshot = snapshot_.load(std::memory_order_acquire);
+	if (snapshot->uids.empty() || !snapshot->mightContain(hashOf(uid)))
+		return false;
+	return std::ranges::binary_search(snapshot->uids, uid, {}, [](const std::string& entry) { return std::string_view(entry); });
+}
+
+bool RevocationList::revoke(const std::string_view uid) {
+	const auto current = snapshot_.load(std::memory_order_acquire);
+	const auto it      = std::ranges::lower_bound(current->uids, uid, {}, [](const std::string& entry) { return std::string_view(entry); });
+	if (it != current->uids.end() && *it == uid)
+		return false;
+
+	std::vector<std::string> uids;
+	uids.reserve(current->uids.size() + 1);
+	uids.insert(uids.end(), current->uids.begin(), it);
+	uids.emplace_back(uid);
+	uids.insert(uids.end(), it, current->uids.end());
+	snapshot_.store(std::make_shared<const Snapshot>(std::move(uids)), std::memory_order_release);
+	return true;
+}
+
+bool RevocationList::restore(const std::string_view uid) {
+	const auto current = snapshot_.load(std::memory_order_acquire);
+	const auto it      = std::ranges::lower_bound(current->uids, uid, {}, [](const std::string& entry) { return std::string_view(entry); });
+	if (it == current->uids.end() || *it != uid)
+		return false;
+
+	std::vector<std::string> uids;
+	uids.reserve(current->uids.size() - 1);
+	uids.insert(uids.end(), current->uids.begin(), it);
+	uids.insert(uids.end(), it + 1, current->uids.end());
+	snapshot_.store(std::make_shared<const Snapshot>(std::move(uids)), std::memory_order_release);
+	return true;
+}
+
+void RevocationList::assign(std::vector<std::string> uids) {
+	std::ranges::sort(uids);
+	const auto [first, last] = std::ranges::unique(uids);
+	uids.erase(first, last);
+	snapshot_.store(std::make_shared<const Snapshot>(std::move(uids)), std::memory_order_release);
+}
+
+std::vector<std::string> RevocationList::list() const {
+	return snapshot_.load(std::memory_order_acquire)->uids;
+}
+
+size_t RevocationList::size() const {
+	return snapshot_.load(std::memory_order_acquire)->uids.size();
+}
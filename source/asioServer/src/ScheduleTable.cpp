@@ -0,0 +1,250 @@
+#include "ScheduleTable.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <regex>
+
+#include "json.hpp"
+#include "TcpConnection.hpp" // DEBUG_OUT
+
+namespace {
+	constexpr const char* dayNames[7] = {"mon", "tue", "wed", "thu", "fri", "sat", "sun"};
+
+	int dayIndex(const std::string& name) {
+		for (int i = 0; i < 7; ++i)
+			if (name == dayNames[i])
+				return i;
+		return -1;
+	}
+
+	std::string clock(const int minutes) {
+		char buf[16];
+		std::snprintf(buf, sizeof(buf), "%02d:%02d", minutes / 60, minutes % 60);
+		return buf;
+	}
+}
+
+bool ScheduleTable::parseWindow(const std::string& text, Window& window) {
+	static const std::regex syntax(R"(^(daily|[a-z]{3})(?:-([a-z]{3}))?\s+([0-9]{2}):([0-9]{2})-([0-9]{2}):([0-9]{2})$)");
+	std::smatch match;
+	if (!std::regex_match(text, match, syntax))
+		return false;
+
+	if (match[1] == "daily") {
+		if (match[2].matched)
+			return false;
+		window.days = 0x7f;
+	} else {
+		const int first = dayIndex(match[1]);
+		const int last  = match[2].matched ? dayIndex(match[2]) : first;
+		if (first < 0 || last < 0)
+			return false;
+		// "fri-mon" wraps over the weekend
+		window.days = 0;
+		for (int day = first;; day = (day + 1) % 7) {
+			window.days |= 1 << day;
+			if (day == last)
+				break;
+		}
+	}
+
+	const int from = std::stoi(match[3]) * 60 + std::stoi(match[4]);
+	const int to   = std::stoi(match[5]) * 60 + std::stoi(match[6]);
+	if (std::stoi(match[4]) > 59 || std::stoi(match[6]) > 59 || from >= 24 * 60 || to > 24 * 60 || from == to)
+		return false;
+	window.from = static_cast<uint16_t>(from);
+	window.to   = static_cast<uint16_t>(to);
+	return true;
+}
+
+bool ScheduleTable::parseHoliday(const std::string& text, Holiday& holiday) {
+	static const std::regex syntax(R"(^([0-9]{2})/([0-9]{2})(?:/([0-9]{4}))?$)");
+	std::smatch match;
+	if (!std::regex_match(text, match, syntax))
+		return false;
+
+	holiday.day   = static_cast<uint8_t>(std::stoi(match[1]));
+	holiday.month = static_cast<uint8_t>(std::stoi(match[2]));
+	holiday.year  = match[3].matched ? static_cast<uint16_t>(std::stoi(match[3])) : 0;
+
+	// 29/02 is a valid yearly holiday, it only falls on leap years
+	const std::chrono::year year{holiday.year ? holiday.year : 2000};
+	return (year / holiday.month / holiday.day).ok() && (!holiday.year || (holiday.year >= 2000 && holiday.year <= 2099));
+}
+
+std::string ScheduleTable::format(const Window& window) {
+	std::string days;
+	if (window.days == 0x7f)
+		days = "daily";
+	else {
+		// Find the first day of the run, which for a run wrapping over sunday isn't monday
+		int first = 0;
+		while (!(window.days >> first & 1) || (window.days >> ((first + 6) % 7) & 1))
+			++first;
+		int last = first;
+		while (window.days >> ((last + 1) % 7) & 1)
+			last = (last + 1) % 7;
+		days = dayNames[first];
+		if (last != first)
+			days += std::string("-") + dayNames[last];
+	}
+	return days + ' ' + clock(window.from) + '-' + clock(window.to);
+}
+
+std::string ScheduleTable::format(const Holiday& holiday) {
+	char buf[16];
+	if (holiday.year)
+		std::snprintf(buf, sizeof(buf), "%02d/%02d/%04d", holiday.day, holiday.month, holiday.year);
+	else
+		std::snprintf(buf, sizeof(buf), "%02d/%02d", holiday.day, holiday.month);
+	return buf;
+}
+
+void ScheduleTable::load(const std::string& json) {
+	schedules_.clear();
+	const nlohmann::json parsed = nlohmann::json::parse(json, nullptr, false);
+	if (!parsed.is_object())
+		return;
+
+	for (const auto& [name, entry] : parsed.items()) {
+		if (!entry.is_object()) {
+			DEBUG_OUT("Invalid schedule " + name + " in config.json - skipping it.\n");
+			continue;
+		}
+		Schedule& schedule = schedules_[name];
+		for (const auto& text : entry.value("windows", nlohmann::json::array())) {
+			Window window{};
+			if (text.is_string() && parseWindow(text.get<std::string>(), window))
+				schedule.windows.push_back(window);
+			else
+				DEBUG_OUT("Invalid window in schedule " + name + " - skipping one.\n");
+		}
+		for (const auto& text : entry.value("holidays", nlohmann::json::array())) {
+			Holiday holiday{};
+			if (text.is_string() && parseHoliday(text.get<std::string>(), holiday))
+				schedule.holidays.push_back(holiday);
+			else
+				DEBUG_OUT("Invalid holiday in schedule " + name + " - skipping one.\n");
+		}
+	}
+}
+
+std::string ScheduleTable::json() const {
+	nlohmann::json out = nlohmann::json::object();
+	for (const auto& [name, schedule] : schedules_) {
+		nlohmann::json& entry = out[name];
+		entry["windows"]      = nlohmann::json::array();
+		for (const auto& window : schedule.windows)
+			entry["windows"].push_back(format(window));
+		if (!schedule.holidays.empty())
+			for (const auto& holiday : schedule.holidays)
+				entry["holidays"].push_back(format(holiday));
+	}
+	return out.dump();
+}
+
+bool ScheduleTable::addWindow(const std::string& name, const Window& window) {
+	auto& windows = schedules_[name].windows;
+	if (std::ranges::find(windows, window) != windows.end())
+		return false;
+	windows.push_back(window);
+	return true;
+}
+
+bool ScheduleTable::addHoliday(const std::string& name, const Holiday& holiday) {
+	const auto schedule = schedules_.find(name);
+	if (schedule == schedules_.end() || std::ranges::find(schedule->second.holidays, holiday) != schedule->second.holidays.end())
+		return false;
+	schedule->second.holidays.push_back(holiday);
+	return true;
+}
+
+bool ScheduleTable::remove(const std::string& name) {
+	return schedules_.erase(name) != 0;
+}
+
+std::string ScheduleTable::describe(const ConfigSnapshot::Doors& doors) const {
+	if (schedules_.empty())
+		return "No schedules - every door is open at any time";
+
+	std::string out = "Schedules:";
+	for (const auto& [name, schedule] : schedules_) {
+		out += "\n  " + name + "\n    windows:";
+		for (size_t i = 0; i < schedule.windows.size(); ++i)
+			out += (i ? ", " : " ") + format(schedule.windows[i]);
+		out += "\n    holidays:";
+		for (size_t i = 0; i < schedule.holidays.size(); ++i)
+			out += (i ? ", " : " ") + format(schedule.holidays[i]);
+
+		std::vector<std::string> members;
+		for (const auto& [door, entry] : doors)
+			if (entry.schedule == name)
+				members.push_back(door);
+		std::ranges::sort(members);
+		out += "\n    doors:";
+		for (size_t i = 0; i < members.size(); ++i)
+			out += (i ? ", " : " ") + members[i];
+	}
+	return out;
+}
+
+void ScheduleTable::bind(ConfigSnapshot::Doors& doors) {
+	compiled_.clear();
+	compiled_.reserve(schedules_.size());
+	for (const auto& [name, schedule] : schedules_)
+		compiled_.push_back(compile(schedule));
+
+	for (auto& [name, door] : doors) {
+		if (door.schedule.empty()) {
+			door.slot = always_;
+			continue;
+		}
+		const auto schedule = schedules_.find(door.schedule);
+		if (schedule == schedules_.end()) {
+			// Fail closed, a typo in config.json must not open a door around the clock
+			DEBUG_OUT("Door " + name + " names unknown schedule " + door.schedule + " - it stays closed.\n");
+			door.slot = never_;
+			continue;
+		}
+		door.slot = static_cast<uint32_t>(std::distance(schedules_.begin(), schedule));
+	}
+}
+
+ScheduleTable::Compiled ScheduleTable::compile(const Schedule& schedule) {
+	constexpr int week = 7 * 24 * 60;
+
+	Compiled compiled;
+	for (const auto& window : schedule.windows) {
+		const int length = window.to > window.from ? window.to - window.from : window.to + 24 * 60 - window.from;
+		for (int day = 0; day < 7; ++day) {
+			if (!(window.days >> day & 1))
+				continue;
+			const int start = day * 24 * 60 + window.from;
+			for (int minute = start; minute < start + length; ++minute)
+				compiled.week.set(minute % week); // Sunday night windows continue into monday
+		}
+	}
+
+	if (schedule.holidays.empty())
+		return compiled;
+
+	compiled.closedDays.assign((dayCount_ + 63) / 64, 0);
+	auto close = [&compiled](const std::chrono::year_month_day date) {
+		if (!date.ok())
+			return; // 29/02 outside leap years
+		const auto offset = static_cast<uint32_t>(std::chrono::sys_days{date}.time_since_epoch().count() - firstDay_);
+		if (offset < dayCount_)
+			compiled.closedDays[offset / 64] |= uint64_t{1} << (offset % 64);
+	};
+	for (const auto& holiday : schedule.holidays) {
+		const auto month = std::chrono::month{holiday.month};
+		const auto day   = std::chrono::day{holiday.day};
+		if (holiday.year)
+			close(std::chrono::year{holiday.year} / month / day);
+		else
+			for (int year = 2000; year <= 2099; ++year)
+				close(std::chrono::year{year} / month / day);
+	}
+	return compiled;
+}
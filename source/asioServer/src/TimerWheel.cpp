@@ -0,0 +1,64 @@
+#include "TimerWheel.hpp"
+
+void TimerWheel::reset(const int64_t now) {
+	for (auto& slot : wheel_)
+		slot.clear();
+	timers_.clear();
+	levelSizes_ = {};
+	current_    = now;
+}
+
+void TimerWheel::schedule(const uint32_t id, const int64_t when) {
+	cancel(id);
+	// A deadline that passed already fires on the next tick
+	Slot pending{{id, std::max(when, current_ + 1)}};
+	timers_[id].timer = pending.begin();
+	place(pending, pending.begin());
+}
+
+bool TimerWheel::cancel(const uint32_t id) {
+	const auto handle = timers_.find(id);
+	if (handle == timers_.end())
+		return false;
+	wheel_[handle->second.slot].erase(handle->second.timer);
+	--levelSizes_[handle->second.slot / slots_];
+	timers_.erase(handle);
+	return true;
+}
+
+int64_t TimerWheel::deadline(const uint32_t id) const {
+	const auto handle = timers_.find(id);
+	return handle == timers_.end() ? 0 : handle->second.timer->when;
+}
+
+std::vector<std::pair<uint32_t, int64_t>> TimerWheel::list() const {
+	std::vector<std::pair<uint32_t, int64_t>> out;
+	out.reserve(timers_.size());
+	for (const auto& [id, handle] : timers_)
+		out.emplace_back(id, handle.timer->when);
+	return out;
+}
+
+void TimerWheel::place(Slot& from, const Slot::iterator timer) {
+	// Level n holds deadlines in the same block of 64^(n+1) seconds as now, so its slot comes around before the block ends
+	int slot = overflow_;
+	for (int level = 0; level < levels_; ++level) {
+		const int shift = bits_ * (level + 1);
+		if (timer->when >> shift == current_ >> shift) {
+			slot = level * slots_ + static_cast<int>(timer->when >> (shift - bits_) & (slots_ - 1));
+			break;
+		}
+	}
+	Slot& to = wheel_[slot];
+	to.splice(to.end(), from, timer);
+	timers_[timer->id].slot = static_cast<uint16_t>(slot);
+	++levelSizes_[slot / slots_];
+}
+
+void TimerWheel::cascade(const int level) {
+	Slot moving;
+	moving.splice(moving.end(), level == levels_ ? wheel_[overflow_] : wheel_[level * slots_ + (current_ >> bits_ * level & (slots_ - 1))]);
+	levelSizes_[level] -= moving.size();
+	while (!moving.empty())
+		place(moving, moving.begin());
+}
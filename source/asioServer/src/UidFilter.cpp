@@ -0,0 +1,77 @@
+#include "UidFilter.hpp"
+#include "UserTable.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+	// Odd multipliers that spread the low 32 hash bits over one bit per word, as in Parquet's split block Bloom filter
+	constexpr uint32_t salts[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+								   0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+	uint64_t hashOf(const std::string_view uid) {
+		return std::hash<std::string_view>{}(uid);
+	}
+}
+
+void UidFilter::build(const UserTable& users) {
+	const size_t cards = users.cardCount();
+	capacity_          = std::max<size_t>(cards + cards / 4, 1024);
+	keys_              = 0;
+	blocks_.assign((capacity_ * bitsPerKey_ + 511) / 512, Block{});
+
+	users.forEach([&](const UserTable::Id id) {
+		users.forEachCard(id, [&](const std::string_view uid) {
+			set(hashOf(uid));
+			++keys_;
+		});
+	});
+}
+
+bool UidFilter::insert(const std::string_view uid) {
+	if (blocks_.empty() || keys_ >= capacity_)
+		return false;
+	set(hashOf(uid));
+	++keys_;
+	return true;
+}
+
+bool UidFilter::mightContain(const std::string_view uid) const {
+	const bool maybe = !blocks_.empty() && test(hashOf(uid));
+	(maybe ? passed_ : rejected_).fetch_add(1, std::memory_order_relaxed);
+	return maybe;
+}
+
+/// Upper hash bits pick the block without a division, the lower bits pick the bits inside it.
+size_t UidFilter::blockOf(const uint64_t hash) const {
+	return static_cast<size_t>(((hash >> 32) * blocks_.size()) >> 32);
+}
+
+void UidFilter::set(const uint64_t hash) {
+	Block& block = blocks_[blockOf(hash)];
+	for (int i = 0; i < 8; ++i)
+		block.words[i] |= uint64_t{1} << ((static_cast<uint32_t>(hash) * salts[i]) >> 26);
+}
+
+bool UidFilter::test(const uint64_t hash) const {
+	const Block& block = blocks_[blockOf(hash)];
+	for (int i = 0; i < 8; ++i)
+		if (!(block.words[i] & (uint64_t{1} << ((static_cast<uint32_t>(hash) * salts[i]) >> 26))))
+			return false;
+	return true;
+}
+
+UidFilter::Metrics UidFilter::metrics() const {
+	return {passed_.load(std::memory_order_relaxed), rejected_.load(std::memory_order_relaxed),
+			falsePositives_.load(std::memory_order_relaxed), keys_, blocks_.size() * sizeof(Block)};
+}
+
+std::string UidFilter::format(const Metrics& metrics) {
+	std::string out = "UID filter: " + std::to_string(metrics.keys) + " cards in " + std::to_string(metrics.bytes / 1024) + " KiB";
+	out += "\n  passed: " + std::to_string(metrics.passed);
+	out += "\n  rejected: " + std::to_string(metrics.rejected);
+	if (const uint64_t total = metrics.passed + metrics.rejected)
+		out += "\n  rejected share: " + std::to_string(metrics.rejected * 100 / total) + "%";
+	out += "\n  false positives: " + std::to_string(metrics.falsePositives);
+	return out;
+}
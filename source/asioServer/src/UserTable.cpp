@@ -0,0 +1,265 @@
+#include "UserTable.hpp"
+
+#include <bit>
+#include <functional>
+
+namespace {
+	size_t hashOf(const std::string_view str) {
+		return std::hash<std::string_view>{}(str);
+	}
+}
+
+std::string_view UserTable::name(const Id id) const {
+	return {pool_.data() + users_[id].nameOffset, users_[id].nameLength};
+}
+
+std::string_view UserTable::uid(const Id id) const {
+	const Id card = users_[id].firstCard;
+	return card == none_ ? std::string_view{} : cardUid(card);
+}
+
+std::string_view UserTable::cardUid(const Id card) const {
+	return {pool_.data() + cards_[card].uidOffset, cards_[card].uidLength};
+}
+
+UserTable::Id UserTable::findByName(const std::string_view name) const {
+	return find(nameIndex_, name, false);
+}
+
+UserTable::Id UserTable::findByUid(const std::string_view uid) const {
+	const Id card = findCard(uid);
+	return card == none_ ? none_ : cards_[card].owner;
+}
+
+UserTable::Id UserTable::findCard(const std::string_view uid) const {
+	return find(cardIndex_, uid, true);
+}
+
+UserTable::Id UserTable::add(const std::string_view name, const std::string_view uid, const int lvl) {
+	if (name.empty() || findByName(name) != none_ || (!uid.empty() && findCard(uid) != none_))
+		return none_;
+
+	Id id;
+	if (!freeUsers_.empty()) {
+		id = freeUsers_.back();
+		freeUsers_.pop_back();
+	} else {
+		id = static_cast<Id>(users_.size());
+		users_.emplace_back();
+	}
+
+	User& user      = users_[id];
+	user.nameOffset = intern(name);
+	user.nameLength = static_cast<uint32_t>(name.size());
+	user.firstCard  = none_;
+	user.lvl        = static_cast<int16_t>(lvl);
+	user.group      = noGroup_;
+	user.expires    = 0;
+	insert(nameIndex_, id, false);
+
+	if (!uid.empty())
+		addCard(id, uid);
+	return id;
+}
+
+bool UserTable::remove(const Id id) {
+	if (id >= users_.size() || users_[id].nameLength == 0)
+		return false;
+
+	while (users_[id].firstCard != none_)
+		unlinkCard(users_[id].firstCard);
+
+	erase(nameIndex_, id, false);
+	wasted_ += users_[id].nameLength;
+	users_[id] = {};
+	freeUsers_.push_back(id);
+
+	compact();
+	return true;
+}
+
+bool UserTable::rename(const Id id, const std::string_view newName) {
+	if (newName == name(id))
+		return true;
+	if (newName.empty() || findByName(newName) != none_)
+		return false;
+
+	erase(nameIndex_, id, false);
+	wasted_ += users_[id].nameLength;
+	users_[id].nameOffset = intern(newName);
+	users_[id].nameLength = static_cast<uint32_t>(newName.size());
+	insert(nameIndex_, id, false);
+
+	compact();
+	return true;
+}
+
+bool UserTable::addCard(const Id id, const std::string_view uid) {
+	if (uid.empty() || findCard(uid) != none_)
+		return false;
+
+	Id card;
+	if (!freeCards_.empty()) {
+		card = freeCards_.back();
+		freeCards_.pop_back();
+	} else {
+		card = static_cast<Id>(cards_.size());
+		cards_.emplace_back();
+	}
+	cards_[card] = {intern(uid), static_cast<uint32_t>(uid.size()), id, none_};
+
+	// Append so uid() keeps returning the oldest card
+	Id* link = &users_[id].firstCard;
+	while (*link != none_)
+		link = &cards_[*link].next;
+	*link = card;
+
+	insert(cardIndex_, card, true);
+	return true;
+}
+
+UserTable::Id UserTable::removeCard(const std::string_view uid) {
+	const Id card = findCard(uid);
+	if (card == none_)
+		return none_;
+
+	const Id owner = cards_[card].owner;
+	unlinkCard(card);
+	compact();
+	return owner;
+}
+
+void UserTable::unlinkCard(const Id card) {
+	Id* link = &users_[cards_[card].owner].firstCard;
+	while (*link != card)
+		link = &cards_[*link].next;
+	*link = cards_[card].next;
+
+	erase(cardIndex_, card, true);
+	wasted_ += cards_[card].uidLength;
+	cards_[card] = {};
+	freeCards_.push_back(card);
+}
+
+void UserTable::reserve(const size_t users, const size_t cards) {
+	users_.reserve(users);
+	cards_.reserve(cards);
+	pool_.reserve((users + cards) * 8);
+	if (users * 2 > nameIndex_.slots.size())
+		grow(nameIndex_, users * 2, false);
+	if (cards * 2 > cardIndex_.slots.size())
+		grow(cardIndex_, cards * 2, true);
+}
+
+void UserTable::clear() {
+	pool_.clear();
+	users_.clear();
+	cards_.clear();
+	freeUsers_.clear();
+	freeCards_.clear();
+	nameIndex_ = {};
+	cardIndex_ = {};
+	groups_    = {""};
+	wasted_    = 0;
+	groupIds_.clear();
+}
+
+UserTable::Group UserTable::internGroup(const std::string_view name) {
+	const Group group = findGroup(name);
+	if (group != noGroup_ || name.empty() || groups_.size() > UINT16_MAX)
+		return group;
+	groups_.emplace_back(name);
+	return groupIds_[groups_.back()] = static_cast<Group>(groups_.size() - 1);
+}
+
+UserTable::Group UserTable::findGroup(const std::string_view name) const {
+	const auto group = groupIds_.find(std::string(name));
+	return group == groupIds_.end() ? noGroup_ : group->second;
+}
+
+std::string_view UserTable::key(const Id id, const bool card) const {
+	return card ? cardUid(id) : name(id);
+}
+
+UserTable::Id UserTable::find(const Index& index, const std::string_view key, const bool card) const {
+	if (index.slots.empty())
+		return none_;
+	const size_t mask = index.slots.size() - 1;
+	for (size_t slot = hashOf(key) & mask;; slot = (slot + 1) & mask) {
+		const Id id = index.slots[slot];
+		if (id == none_ || this->key(id, card) == key)
+			return id;
+	}
+}
+
+void UserTable::insert(Index& index, const Id id, const bool card) {
+	// Keep the load factor at or below 1/2 so probe sequences stay short
+	if ((index.count + 1) * 2 > index.slots.size())
+		grow(index, std::max<size_t>(16, index.slots.size() * 2), card);
+
+	const size_t mask = index.slots.size() - 1;
+	size_t slot       = hashOf(key(id, card)) & mask;
+	while (index.slots[slot] != none_)
+		slot = (slot + 1) & mask;
+	index.slots[slot] = id;
+	++index.count;
+}
+
+/// Removes id from the index, must be called while its key is still in the record.
+void UserTable::erase(Index& index, const Id id, const bool card) {
+	const size_t mask = index.slots.size() - 1;
+	size_t hole       = hashOf(key(id, card)) & mask;
+	while (index.slots[hole] != id)
+		hole = (hole + 1) & mask;
+
+	// Shift later entries of the same probe run back into the hole
+	for (size_t next = (hole + 1) & mask; index.slots[next] != none_; next = (next + 1) & mask) {
+		const size_t home  = hashOf(key(index.slots[next], card)) & mask;
+		const bool between = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+		if (between)
+			continue;
+		index.slots[hole] = index.slots[next];
+		hole              = next;
+	}
+	index.slots[hole] = none_;
+	--index.count;
+}
+
+void UserTable::grow(Index& index, const size_t capacity, const bool card) {
+	std::vector<Id> old = std::move(index.slots);
+	index.slots.assign(std::bit_ceil(capacity), none_);
+	index.count = 0;
+	for (const Id id : old)
+		if (id != none_)
+			insert(index, id, card);
+}
+
+uint32_t UserTable::intern(const std::string_view str) {
+	const auto offset = static_cast<uint32_t>(pool_.size());
+	pool_.insert(pool_.end(), str.begin(), str.end());
+	return offset;
+}
+
+/// Copies the live strings into a fresh pool once more than half of the pool is garbage.\n
+/// IDs and hashes don't change, so the indexes stay valid.
+void UserTable::compact() {
+	if (wasted_ < 64 * 1024 || wasted_ * 2 < pool_.size())
+		return;
+
+	std::vector<char> fresh;
+	fresh.reserve(pool_.size() - wasted_);
+	auto move = [&](uint32_t& offset, const uint32_t length) {
+		const auto moved = static_cast<uint32_t>(fresh.size());
+		fresh.insert(fresh.end(), pool_.begin() + offset, pool_.begin() + offset + length);
+		offset = moved;
+	};
+	for (User& user : users_)
+		if (user.nameLength)
+			move(user.nameOffset, user.nameLength);
+	for (Card& card : cards_)
+		if (card.uidLength)
+			move(card.uidOffset, card.uidLength);
+
+	pool_   = std::move(fresh);
+	wasted_ = 0;
+}
@@ -4,6 +4,7 @@
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 #include <cstring>
 #include <limits>
 #include <thread>
@@ -64,78 +65,42 @@ void cli::send_data(const std::string &msg) {
 }
 
 bool cli::recieve_data() {
-    auto read_line = [&](char *buf, size_t bufsize) -> bool {
-        size_t total = 0;
-        ssize_t n = 0;
-
-        memset(buf, 0, bufsize);
-
-        while (total < bufsize - 1) {
-            n = read(sockfd, buf + total, 1);
-
-            if (n < 0) {
-                perror("ERROR reading from socket");
-                return false;
-            }
-
-            if (n == 0) {
-                std::cerr << "Server closed connection\n";
-                return false;
-            }
-
-            if (buf[total] == '\n' || buf[total] == '\r')
-                break;
-
-            total += n;
-        }
+    auto read_line = [&]() -> bool {
+        std::string line;
+        if (!reader.readLine(sockfd, line))
+            return false;
 
-        buf[total] = '\0';
+        // Skip past the "type:string%%%" header
+        reply = LineReader::payload(line);
+        std::cout << reply << std::endl;
         return true;
     };
 
     // -----------------------
     // 1) Read first required line (blocking)
     // -----------------------
-    if (!read_line(buffer_receive, sizeof(buffer_receive)))
+    if (!read_line())
         return false;
 
-    // Process delimiter
-    char *delimiter = strstr(buffer_receive, "%%%");
-    if (delimiter) {
-        char *payload = delimiter + 3;
-        size_t payload_len = strlen(payload);
-        memmove(buffer_receive, payload, payload_len + 1);
-    }
-
-    std::cout << buffer_receive << std::endl;
-
     // -----------------------
-    // 2) Drain all queued bytes (non-blocking)
+    // 2) Drain the rest of a multi-line reply, buffered first, then whatever is queued on the socket
     // -----------------------
+    bool more = false;
     while (true) {
-        int available = 0;
-
-        // Check how many bytes are currently queued in the socket buffer
-        if (ioctl(sockfd, FIONREAD, &available) < 0)
-            break;
-
-        if (available <= 0)
-            break; // nothing more queued
-
-        // Read additional line
-        if (!read_line(buffer_receive, sizeof(buffer_receive)))
-            return false;
-
-        // Process delimiter again
-        char *delimiter2 = strstr(buffer_receive, "%%%");
-        if (delimiter2) {
-            char *payload = delimiter2 + 3;
-            size_t payload_len = strlen(payload);
-            memmove(buffer_receive, payload, payload_len + 1);
+        if (!reader.buffered()) {
+            // A long reply may still be on its way, give it 200 ms each time the buffer runs dry
+            if (more)
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            // Check how many bytes are currently queued in the socket buffer
+            int available = 0;
+            if (ioctl(sockfd, FIONREAD, &available) < 0 || available <= 0)
+                break; // nothing more queued
         }
 
-        std::cout << buffer_receive << std::endl;
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if (!read_line())
+            return false;
+        more = true;
     }
 
     return true;
@@ -147,12 +112,12 @@ bool cli::admin_identification() {
         if (!recieve_data())
             return false;
 
-        if (strcmp(buffer_receive, "Another Admin is connected") == 0) {
+        if (reply == "Another Admin is connected") {
             return false;
         }
 
-        if (strcmp(buffer_receive, "Input CLI Identification") == 0 ||
-            strcmp(buffer_receive, "Incorrect CLI Identification") == 0) {
+        if (reply == "Input CLI Identification" ||
+            reply == "Incorrect CLI Identification") {
             std::cout << "> ";
             std::cin >> cli_identification;
 
@@ -162,7 +127,7 @@ bool cli::admin_identification() {
             continue;
         }
 
-        if (strcmp(buffer_receive, "CLI is ready") == 0) {
+        if (reply == "CLI is ready") {
             std::cout << "Admin identification accepted." << std::endl;
             return true;
         }
@@ -192,7 +157,7 @@ void cli::run() {
         if (input.rfind("newDoor", 0) == 0)
             handle_newDoor(input);
 
-        else if (input.rfind("newUser", 0) == 0)
+        else if (input.rfind("newUser", 0) == 0 || input.rfind("newVisitor", 0) == 0)
             handle_newUser(input);
 
         else if (input.rfind("rmDoor", 0) == 0)
@@ -201,9 +166,39 @@ void cli::run() {
         else if (input.rfind("rmUser", 0) == 0)
             handle_rmUser(input);
 
+        else if (input.rfind("addCard", 0) == 0)
+            handle_addCard(input);
+
+        else if (input.rfind("revokeCard", 0) == 0)
+            handle_revokeCard(input);
+
+        else if (input.rfind("rmSchedule", 0) == 0)
+            handle_rmSchedule(input);
+
         else if (input.rfind("getSystemLog", 0) == 0 ||
                  input.rfind("getUserLog", 0) == 0 ||
-                 input.rfind("getDoorLog", 0) == 0)
+                 input.rfind("getDoorLog", 0) == 0 ||
+                 input.rfind("getStats", 0) == 0 ||
+                 input.rfind("getCards", 0) == 0 ||
+                 input.rfind("addWindow", 0) == 0 ||
+                 input.rfind("addHoliday", 0) == 0 ||
+                 input.rfind("setSchedule", 0) == 0 ||
+                 input == "getSchedules" ||
+                 input.rfind("setGroup", 0) == 0 ||
+                 input.rfind("setZone", 0) == 0 ||
+                 input.rfind("allow", 0) == 0 ||
+                 input.rfind("deny", 0) == 0 ||
+                 input.rfind("rmRule", 0) == 0 ||
+                 input.rfind("explain", 0) == 0 ||
+                 input == "getRules" ||
+                 input.rfind("setExpiry", 0) == 0 ||
+                 input == "getVisitors" ||
+                 input.rfind("setDirection", 0) == 0 ||
+                 input.rfind("clearPresence", 0) == 0 ||
+                 input.rfind("getOccupancy", 0) == 0 ||
+                 input.rfind("getOccupants", 0) == 0 ||
+                 input == "getDoorAlerts" ||
+                 input == "getMetrics")
             handle_log(input);
         
         else if (input.rfind("mvUser", 0) == 0)
@@ -212,6 +207,9 @@ void cli::run() {
         else if (input.rfind("mvDoor", 0) == 0)
             handle_mvDoor(input);
 
+        else if (input == "tail")
+            handle_tail(input);
+
         else if (input == "exit")
             handle_exit(input);
 
@@ -235,8 +233,31 @@ void cli::printCommands() const {
             << "  Commands :\n"
             << "  newDoor <Door name> <accessLevel>   - Add door\n"
             << "  newUser <Username> <accessLevel>    - Add user (includes NFC-scan)\n"
+            << "  newVisitor <Username> <lvl> <hours> - Add user whose badge expires (includes NFC-scan)\n"
+            << "  setExpiry <Username> <hours>        - Expire a badge in hours from now ('none' makes it permanent)\n"
+            << "  getVisitors                         - List badges that expire, soonest first\n"
             << "  rmDoor <Door name>                  - Delete door\n"
             << "  rmUser <Username>                   - Delete user\n"
+            << "  addCard <Username>                  - Give user another card (includes NFC-scan)\n"
+            << "  revokeCard <UID>                    - Block a lost card at every door\n"
+            << "  getCards <Username>                 - List the cards of a user\n"
+            << "  addWindow <Schedule> <days> <time>  - Open doors of a schedule, e.g. mon-fri 07:00-18:00\n"
+            << "  addHoliday <Schedule> <date>        - Keep doors closed all day, dd/mm or dd/mm/yyyy\n"
+            << "  setSchedule <Door name> <Schedule>  - Put a door on a schedule ('none' removes it)\n"
+            << "  rmSchedule <Schedule>               - Delete an unused schedule\n"
+            << "  getSchedules                        - List schedules, holidays and their doors\n"
+            << "  setGroup <Username> <Group>         - Put a user in a group ('none' removes it)\n"
+            << "  setZone <Door name> <Zone>          - Put a door in a zone ('none' removes it)\n"
+            << "  allow <Group|*> <Zone|*>            - Let a group in a zone whatever the levels\n"
+            << "  deny <Group|*> <Zone|*>             - Keep a group out of a zone, wins over allow\n"
+            << "  rmRule <Group|*> <Zone|*>           - Delete the rules between a group and a zone\n"
+            << "  getRules                            - List group/zone rules\n"
+            << "  explain <Username> <Door name>      - Show why a user would be let in or not\n"
+            << "  setDirection <Door name> <in|out>   - Entry or exit door for anti-passback ('none' for neither)\n"
+            << "  clearPresence <Username>            - Put a user outside every zone\n"
+            << "  getOccupancy [Zone]                 - Count users inside a zone, or every zone\n"
+            << "  getOccupants <Zone>                 - List users inside a zone\n"
+            << "  getDoorAlerts                       - Door states and held-open, tailgating and forced alerts\n"
             << "  mvDoor <Door name> <accessLevel>    - Edit existing door\n"
             << "  mvUser <Username> <accessLevel>     - Edit existing user\n"
             << "  exit                                - Exit and kill CLI connection \n"
@@ -244,6 +265,9 @@ void cli::printCommands() const {
             << "  getSystemLog <'date'>               - Get date-specific system log\n"
             << "  getUserLog <Username>               - Get user-specific log\n"
             << "  getDoorLog <Door name>              - Get door-specific log\n"
+            << "  getStats <hours>                    - Approved/denied/unknown per door and user (no hours = lifetime)\n"
+            << "  getMetrics                          - Audit log commit latency, batch sizes and UID filter counters\n"
+            << "  tail                                - Stream scans live, press Enter to stop\n"
             << "  help                                - Print command overview\n"
             << "\n";
 
@@ -257,7 +281,7 @@ void cli::handle_newDoor(const std::string &cmd) {
         return;
 
 
-    if (strcmp(buffer_receive, "Operation failed - Incorrect CLI syntax") == 0) {
+    if (reply == "Operation failed - Incorrect CLI syntax") {
         return;
     }
 
@@ -277,7 +301,7 @@ void cli::handle_newUser(const std::string &cmd) {
     if (!recieve_data())
         return;
 
-    if (strcmp(buffer_receive, "Operation failed - Incorrect CLI syntax") == 0) {
+    if (reply == "Operation failed - Incorrect CLI syntax") {
         return;
 
 
@@ -314,6 +338,47 @@ void cli::handle_newUser(const std::string &cmd) {
         return;
 }
 
+void cli::handle_addCard(const std::string &cmd) {
+    send_data(cmd);
+
+    if (!recieve_data())
+        return;
+
+    if (reply == "Operation failed - Incorrect CLI syntax" ||
+        reply == "User could not be found") {
+        return;
+    }
+
+    rfid_reader = std::make_unique<PN532Reader>();
+
+    if (!rfid_reader->init_pn532()) {
+        std::cerr << "Failed to initialize PN532" << std::endl;
+    }
+
+    std::string uid;
+    bool scanned = false;
+    while (!scanned) { //blocking loop.
+        if (rfid_reader->waitForScan()) {
+            scanned = true;
+            uid = rfid_reader->getStringUID();
+        }
+    }
+
+    send_data(uid);
+
+    if (!recieve_data())
+        return;
+
+    std::string confirmation;
+    std::cout << "<approved/denied> ";
+    std::cin >> confirmation;
+
+    send_data(confirmation);
+
+    if (!recieve_data())
+        return;
+}
+
 void cli::handle_rmDoor(const std::string &cmd) {
     send_data(cmd);
 
@@ -321,8 +386,8 @@ void cli::handle_rmDoor(const std::string &cmd) {
         return;
 
 
-    if (strcmp(buffer_receive, "Operation failed - Incorrect CLI syntax") == 0 ||
-        strcmp(buffer_receive, "Door could not be found") == 0) {
+    if (reply == "Operation failed - Incorrect CLI syntax" ||
+        reply == "Door could not be found") {
         return;
     }
 
@@ -343,8 +408,8 @@ void cli::handle_rmUser(const std::string &cmd) {
         return;
 
 
-    if (strcmp(buffer_receive, "Operation failed - Incorrect CLI syntax") == 0 ||
-        strcmp(buffer_receive, "User could not be found") == 0) 
+    if (reply == "Operation failed - Incorrect CLI syntax" ||
+        reply == "User could not be found") 
     {
         return;
     }
@@ -359,6 +424,49 @@ void cli::handle_rmUser(const std::string &cmd) {
         return;
 }
 
+void cli::handle_revokeCard(const std::string &cmd) {
+    send_data(cmd);
+
+    if (!recieve_data())
+        return;
+
+    if (reply == "Operation failed - Incorrect CLI syntax" ||
+        reply == "Card is already revoked") {
+        return;
+    }
+
+    std::string confirmation;
+    std::cout << "<approved/denied> ";
+    std::cin >> confirmation;
+
+    send_data(confirmation);
+
+    if (!recieve_data())
+        return;
+}
+
+void cli::handle_rmSchedule(const std::string &cmd) {
+    send_data(cmd);
+
+    if (!recieve_data())
+        return;
+
+    if (reply == "Operation failed - Incorrect CLI syntax" ||
+        reply == "Schedule could not be found" ||
+        reply.rfind("Schedule is still used", 0) == 0) {
+        return;
+    }
+
+    std::string confirmation;
+    std::cout << "<approved/denied> ";
+    std::cin >> confirmation;
+
+    send_data(confirmation);
+
+    if (!recieve_data())
+        return;
+}
+
 void cli::handle_exit(const std::string &cmd) {
     send_data(cmd);
 
@@ -393,8 +501,8 @@ void cli::handle_mvUser(const std::string &cmd) {
         return;
 
 
-    if (strcmp(buffer_receive, "Operation failed - Incorrect CLI syntax") == 0 ||
-        strcmp(buffer_receive, "User could not be found") == 0) {
+    if (reply == "Operation failed - Incorrect CLI syntax" ||
+        reply == "User could not be found") {
         return;
     }
 
@@ -416,8 +524,8 @@ void cli::handle_mvDoor(const std::string &cmd) {
         return;
 
 
-    if (strcmp(buffer_receive, "Operation failed - Incorrect CLI syntax") == 0 ||
-        strcmp(buffer_receive, "Door could not be found") == 0) {
+    if (reply == "Operation failed - Incorrect CLI syntax" ||
+        reply == "Door could not be found") {
         return;
     }
 
@@ -438,3 +546,41 @@ void cli::handle_log( const std::string &cmd)
     if (!recieve_data())
         return;
 }
+
+void cli::handle_tail(const std::string &cmd)
+{
+    send_data(cmd);
+
+    if (!recieve_data())
+        return;
+
+    // Print events as they arrive until the admin presses Enter.
+    pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {sockfd, POLLIN, 0}};
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            perror("poll");
+            return;
+        }
+
+        if (fds[1].revents & (POLLIN | POLLHUP)) {
+            if (!recieve_data()) {
+                connection = false;
+                return;
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            std::string line;
+            std::getline(std::cin, line);
+            break;
+        }
+    }
+
+    send_data("stop");
+
+    // Late events may still arrive ahead of the confirmation.
+    do {
+        if (!recieve_data())
+            return;
+    } while (reply != "Stopped tail");
+}
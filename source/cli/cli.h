@@ -4,6 +4,7 @@
 #include <string>
 #include <regex>
 #include "pn532_wrapper.h"
+#include "LineReader.h"
 
 class cli
 {
@@ -19,7 +20,8 @@ private:
     const char *server_ip;
     bool connection = false;
 
-    char buffer_receive[4096];
+    LineReader reader;
+    std::string reply; // Payload of the last line received
 
     std::unique_ptr<PN532Reader> rfid_reader;
 
@@ -32,11 +34,15 @@ private:
     void handle_newUser(const std::string &);
     void handle_rmDoor(const std::string &);
     void handle_rmUser(const std::string &);
+    void handle_addCard(const std::string &);
+    void handle_revokeCard(const std::string &);
+    void handle_rmSchedule(const std::string &);
     void handle_exit(const std::string &);
     void handle_shutdown(const std::string &);
     void handle_mvUser(const std::string &);
     void handle_mvDoor(const std::string &);
     void handle_log(const std::string &);
+    void handle_tail(const std::string &);
 
     void printCommands() const;
 };
\ No newline at end of file
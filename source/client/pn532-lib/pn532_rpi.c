@@ -282,6 +282,18 @@ void PN532_UART_Init(PN532* pn532) {
  * I2C
  **************************************************************************/
 int PN532_I2C_ReadData(uint8_t* data, uint16_t count) {
+    return PN532_I2C_ReadDataOn(fd, data, count);
+}
+
+int PN532_I2C_WriteData(uint8_t *data, uint16_t count) {
+    return PN532_I2C_WriteDataOn(fd, data, count);
+}
+
+bool PN532_I2C_WaitReady(uint32_t timeout) {
+    return PN532_I2C_WaitReadyOn(fd, timeout);
+}
+
+int PN532_I2C_ReadDataOn(int fd, uint8_t* data, uint16_t count) {
     uint8_t status[] = {0x00};
     uint8_t frame[count + 1];
     read(fd, status, sizeof(status));
@@ -295,22 +307,26 @@ int PN532_I2C_ReadData(uint8_t* data, uint16_t count) {
     return PN532_STATUS_OK;
 }
 
-int PN532_I2C_WriteData(uint8_t *data, uint16_t count) {
+int PN532_I2C_WriteDataOn(int fd, uint8_t *data, uint16_t count) {
     write(fd, data, count);
     return PN532_STATUS_OK;
 }
 
-bool PN532_I2C_WaitReady(uint32_t timeout) {
+bool PN532_I2C_WaitReadyOn(int fd, uint32_t timeout) {
     uint8_t status[] = {0x00};
     struct timespec timenow;
     struct timespec timestart;
+    // ACKs and most replies are ready within a few ms, a card may take the whole timeout:
+    // wait 1, 2 and 4 ms between the first checks, then 5 ms as before.
+    uint32_t interval = 1;
     clock_gettime(CLOCK_MONOTONIC, &timestart);
     while (1) {
         read(fd, status, sizeof(status));
         if (status[0] == _I2C_READY) {
             return true;
         } else {
-            delay(5);
+            delay(interval);
+            interval = interval * 2 > 5 ? 5 : interval * 2;
         }
         clock_gettime(CLOCK_MONOTONIC, &timenow);
         if ((timenow.tv_sec - timestart.tv_sec) * 1000 + \
@@ -322,6 +338,22 @@ bool PN532_I2C_WaitReady(uint32_t timeout) {
     return false;
 }
 
+int PN532_I2C_Open(int bus) {
+    char devname[20];
+    snprintf(devname, 19, "/dev/i2c-%d", bus);
+    int bus_fd = open(devname, O_RDWR);
+    if (bus_fd < 0) {
+        fprintf(stderr, "Unable to open i2c device: %s\n", strerror(errno));
+        return -1;
+    }
+    if (ioctl(bus_fd, I2C_SLAVE, _I2C_ADDRESS) < 0) {
+        fprintf(stderr, "Unable to open i2c device: %s\n", strerror(errno));
+        close(bus_fd);
+        return -1;
+    }
+    return bus_fd;
+}
+
 int PN532_I2C_Wakeup(void) {
     digitalWrite(_REQ_PIN, HIGH);
     delay(100);
@@ -340,15 +372,8 @@ void PN532_I2C_Init(PN532* pn532) {
     pn532->wait_ready = PN532_I2C_WaitReady;
     pn532->wakeup = PN532_I2C_Wakeup;
     pn532->log = PN532_Log;
-    char devname[20];
-    snprintf(devname, 19, "/dev/i2c-%d", _I2C_CHANNEL);
-    fd = open(devname, O_RDWR);
+    fd = PN532_I2C_Open(_I2C_CHANNEL);
     if (fd < 0) {
-        fprintf(stderr, "Unable to open i2c device: %s\n", strerror(errno));
-        return;
-    }
-    if (ioctl(fd, I2C_SLAVE, _I2C_ADDRESS) < 0) {
-        fprintf(stderr, "Unable to open i2c device: %s\n", strerror(errno));
         return;
     }
     if (wiringPiSetupGpio() < 0) {  // using Broadcom GPIO pin mapping
@@ -50,4 +50,10 @@ int PN532_I2C_WriteData(uint8_t *data, uint16_t count);
 bool PN532_I2C_WaitReady(uint32_t timeout);
 int PN532_I2C_Wakeup(void);
 
+// Further readers on other I2C buses, they share the reset and wakeup pins of the first one
+int PN532_I2C_Open(int bus);
+int PN532_I2C_ReadDataOn(int fd, uint8_t* data, uint16_t count);
+int PN532_I2C_WriteDataOn(int fd, uint8_t *data, uint16_t count);
+bool PN532_I2C_WaitReadyOn(int fd, uint32_t timeout);
+
 #endif  /* PN532_RPI */
@@ -0,0 +1,74 @@
+#include "Actuator.h"
+#include "Hal.h"
+
+Actuator::Actuator() : thread(&Actuator::worker, this)
+{
+}
+
+Actuator::~Actuator()
+{
+    {
+        const std::lock_guard lock(mtx);
+        running = false;
+    }
+    cv.notify_one();
+    thread.join();
+}
+
+void Actuator::write(int pin, bool level)
+{
+    play({{pin, level, std::chrono::milliseconds(0)}});
+}
+
+void Actuator::play(const std::vector<Step> &steps)
+{
+    const Clock::time_point now = Clock::now();
+    {
+        const std::lock_guard lock(mtx);
+        for (const Step &step : steps)
+        {
+            generations[step.pin] = next_seq; // Any step queued before this one is stale now
+        }
+        for (const Step &step : steps)
+        {
+            queue.push({now + step.at, next_seq++, generations[step.pin], step.pin, step.level});
+        }
+    }
+    cv.notify_one();
+}
+
+std::vector<Actuator::Step> Actuator::pulses(int pin, int times, std::chrono::milliseconds on, std::chrono::milliseconds off)
+{
+    std::vector<Step> steps;
+    steps.reserve(2 * times);
+    for (int i = 0; i < times; i++)
+    {
+        steps.push_back({pin, true, i * (on + off)});
+        steps.push_back({pin, false, i * (on + off) + on});
+    }
+    return steps;
+}
+
+void Actuator::worker()
+{
+    std::unique_lock lock(mtx);
+    while (running)
+    {
+        if (queue.empty())
+        {
+            cv.wait(lock);
+            continue;
+        }
+        const Due due = queue.top();
+        if (Clock::now() < due.when)
+        {
+            cv.wait_until(lock, due.when); // Woken early when a step is queued, which may be due sooner
+            continue;
+        }
+        queue.pop();
+        if (generations[due.pin] == due.generation)
+        {
+            hal::gpio().write(due.pin, due.level);
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Drives the output pins of the LEDs and the buzzer from one worker thread with a timer queue,
+// so feedback never sleeps on the caller's thread or starts a thread of its own.
+// A pattern is a list of pin writes at offsets from now. Writing a pin, or playing a pattern on it,
+// drops the steps still pending for that pin, so a new pattern replaces one that is running.
+class Actuator
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Step
+    {
+        int pin;
+        bool level;
+        std::chrono::milliseconds at; // From the moment the pattern is played
+    };
+
+    Actuator();
+    ~Actuator();
+    Actuator(const Actuator &) = delete;
+    Actuator &operator=(const Actuator &) = delete;
+
+    void write(int pin, bool level);
+    void play(const std::vector<Step> &steps);
+
+    // Pin high for on, then low for off, times times
+    static std::vector<Step> pulses(int pin, int times, std::chrono::milliseconds on, std::chrono::milliseconds off);
+
+private:
+    struct Due
+    {
+        Clock::time_point when;
+        uint64_t seq;        // Keeps steps due at the same time in the order they were queued
+        uint64_t generation; // Of the pin when queued, stale once the pin is written again
+        int pin;
+        bool level;
+        bool operator>(const Due &other) const { return when != other.when ? when > other.when : seq > other.seq; }
+    };
+
+    void worker();
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool running = true;
+    uint64_t next_seq = 0;
+    std::unordered_map<int, uint64_t> generations;
+    std::priority_queue<Due, std::vector<Due>, std::greater<>> queue;
+    std::thread thread; // Last, so it starts after the rest is constructed
+};
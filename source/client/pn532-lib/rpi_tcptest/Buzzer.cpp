@@ -1,29 +1,17 @@
 #include "Buzzer.h"
-#include <wiringPi.h>
-#include <thread>
+#include "Hal.h"
 
-Buzzer::Buzzer(int physPin) : pin(physPin)
+Buzzer::Buzzer(Actuator &actuator, int physPin) : actuator(actuator), pin(physPin)
 {
-    pinMode(pin, OUTPUT);
+    hal::gpio().setup(pin, Gpio::Mode::Output);
 }
 
 void Buzzer::beep(int durationMs)
 {
-    std::thread([this, durationMs]()
-                {
-        digitalWrite(pin, HIGH);
-        std::this_thread::sleep_for(std::chrono::milliseconds(durationMs));
-        digitalWrite(pin, LOW); })
-        .detach();
+    actuator.play(Actuator::pulses(pin, 1, std::chrono::milliseconds(durationMs), std::chrono::milliseconds(0)));
 }
 
 void Buzzer::beepPattern(int repeats)
 {
-    std::thread([this, repeats]()
-                {
-        for (int i = 0; i < repeats; i++) {
-            beep(200);
-            std::this_thread::sleep_for(std::chrono::milliseconds(200));
-        } })
-        .detach();
+    actuator.play(Actuator::pulses(pin, repeats, std::chrono::milliseconds(200), std::chrono::milliseconds(200)));
 }
@@ -1,13 +1,15 @@
 #pragma once
+#include "Actuator.h"
 
+// Beeps are queued on the Actuator and return at once
 class Buzzer
 {
 private:
+    Actuator &actuator;
     int pin;
 
 public:
-    Buzzer() = default;
-    Buzzer(int physPin);
+    Buzzer(Actuator &actuator, int physPin);
     void beep(int durationMs);
     void beepPattern(int repeats);
 };
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "CardPoller.h"
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <chrono>
+#include <stdexcept>
+
+CardPoller::CardPoller(PN532Reader &reader) : reader(reader)
+{
+    event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd < 0)
+    {
+        throw std::runtime_error("Could not create eventfd");
+    }
+}
+
+CardPoller::~CardPoller()
+{
+    stop();
+    close(event_fd);
+}
+
+void CardPoller::start()
+{
+    if (running.exchange(true))
+    {
+        return;
+    }
+    thread = std::thread(&CardPoller::worker, this);
+}
+
+// Waits for the poll in progress, up to the PN532 timeout.
+void CardPoller::stop()
+{
+    running = false;
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+std::vector<std::string> CardPoller::take()
+{
+    uint64_t count;
+    while (read(event_fd, &count, sizeof(count)) > 0)
+    {
+    }
+
+    std::vector<std::string> out;
+    const std::lock_guard lock(mtx);
+    out.swap(scans);
+    return out;
+}
+
+void CardPoller::worker()
+{
+    std::string present; // Card on the reader at the last poll, empty if none
+    while (running)
+    {
+        if (!reader.waitForScan())
+        {
+            present.clear(); // Polled again at once, waitForScan() paces itself
+            continue;
+        }
+
+        std::string uid = reader.getStringUID();
+        if (uid == present)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200)); // Card left on the reader
+            continue;
+        }
+        present = uid;
+
+        {
+            const std::lock_guard lock(mtx);
+            scans.push_back(std::move(uid));
+        }
+        const uint64_t one = 1;
+        write(event_fd, &one, sizeof(one));
+    }
+}
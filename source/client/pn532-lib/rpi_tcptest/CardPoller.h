@@ -0,0 +1,34 @@
+#pragma once
+#include "pn532_wrapper.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Polls a PN532Reader on its own thread, so the blocking I2C transfers never stall the client's event loop.
+// Each card is reported once when it is presented, not on every poll while it stays on the reader.
+// fd() is an eventfd that becomes readable when cards are waiting in take().
+class CardPoller
+{
+public:
+    explicit CardPoller(PN532Reader &reader);
+    ~CardPoller();
+
+    void start();
+    void stop();
+
+    int fd() const { return event_fd; }
+    // UIDs presented since the last call, oldest first. Clears fd().
+    std::vector<std::string> take();
+
+private:
+    void worker();
+
+    PN532Reader &reader;
+    int event_fd;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::mutex mtx;
+    std::vector<std::string> scans;
+};
@@ -0,0 +1,208 @@
+#include "Door.h"
+#include <sys/epoll.h>
+#include <stdio.h>
+#include <thread>
+
+Door::Door(std::string name, const Pins &pins, EventLoop &loop, Actuator &actuator, const std::string &key)
+    : doorname(std::move(name)), loop(loop), buzzer(actuator, pins.buzzer), Led_Green(actuator, pins.green),
+      Led_Yellow(actuator, pins.yellow), Led_Red(actuator, pins.red), RS(pins.reed, REED_DEBOUNCE),
+      offline(doorname, key, doorname + ".cache")
+{
+    rfid_reader = std::make_unique<PN532Reader>(pins.bus);
+    if (!rfid_reader->init_pn532())
+    {
+        std::cerr << "Failed to initialize PN532 of " << doorname << std::endl;
+    }
+    poller = std::make_unique<CardPoller>(*rfid_reader);
+
+    door_open_reported = RS.isDoorOpen();
+}
+
+void Door::start(std::function<void()> scans, std::function<void(bool open)> changed)
+{
+    // Initial LED states.
+    show_door_state();
+
+    poller->start();
+    loop.watch(poller->fd(), EPOLLIN, [scans = std::move(scans)](uint32_t) { scans(); });
+    RS.watch(loop, [this, changed = std::move(changed)](bool open)
+    {
+        door_open_reported = open;
+        changed(open);
+        on_door(open);
+    });
+}
+
+std::vector<std::string> Door::take()
+{
+    std::vector<std::string> uids = poller->take();
+    std::erase_if(uids, [this](const std::string &uid)
+    {
+        if (scan_filter.accept(uid))
+        {
+            return false;
+        }
+        std::cerr << "Suppressed scan of " << uid << " at " << doorname << std::endl;
+        return true;
+    });
+    return uids;
+}
+
+void Door::feedback(const std::string &reply)
+{
+    if (reply == "approved")
+    {
+        std::cerr << "GODKENDT!! velkommen :)) (" << doorname << ")" << std::endl;
+
+        // Another approval while the door is open restarts its held-open time
+        loop.cancel(door_timer);
+        loop.cancel(alarm_timer);
+        alarm_timer = 0;
+        if (door_open_reported)
+        {
+            door_cycle = DoorCycle::OPEN;
+            door_timer = loop.after(std::chrono::seconds(10), [this] { start_alarm(); });
+        }
+        else
+        {
+            // waiting for the user to open the door
+            door_cycle = DoorCycle::UNLOCKED;
+            door_timer = loop.after(std::chrono::seconds(10), [this]
+            {
+                std::cout << doorname << " not opened inside 10 seconds. locking again" << std::endl;
+                lock();
+            });
+        }
+        show_door_state();
+    }
+    else if (reply == "denied")
+    {
+        std::cerr << "AFVIST!! øv bøv, slem slem slem :(( (" << doorname << ")" << std::endl;
+        blink(Led_Red, 6, 250); // blink i 3 sekunder.
+    }
+    else
+    {
+        std::cerr << "Unknown response: '" << reply << "'" << std::endl;
+        blink(Led_Yellow, 3, 300);
+    }
+}
+
+// Drives the door cycle from the reed switch
+void Door::on_door(bool open)
+{
+    if (open && door_cycle == DoorCycle::UNLOCKED)
+    {
+        std::cout << doorname << " open" << std::endl;
+        // Waiting for the user to close the door
+        door_cycle = DoorCycle::OPEN;
+        loop.cancel(door_timer);
+        door_timer = loop.after(std::chrono::seconds(10), [this] { start_alarm(); }); // 120 seconds / 2 min.
+    }
+    else if (!open && (door_cycle == DoorCycle::OPEN || door_cycle == DoorCycle::ALARM))
+    {
+        lock();
+    }
+}
+
+void Door::lock()
+{
+    loop.cancel(door_timer);
+    loop.cancel(alarm_timer);
+    door_timer = 0;
+    alarm_timer = 0;
+    door_cycle = DoorCycle::LOCKED;
+    show_door_state();
+}
+
+void Door::start_alarm()
+{
+    std::cout << doorname << " not closed inside 10 seconds" << std::endl;
+    door_timer = 0;
+    door_cycle = DoorCycle::ALARM;
+    show_door_state();
+    buzzer.beep(1000); // beeps one second and sleeps one second
+    alarm_timer = loop.every(std::chrono::seconds(2), [this] { buzzer.beep(1000); });
+}
+
+// LEDs for the door cycle: yellow while locked, green while it may be opened, red while held open.
+// Left alone while a blink is running, it calls this when it ends.
+void Door::show_door_state()
+{
+    if (blink_timer)
+    {
+        return;
+    }
+    Led_Yellow.off();
+    Led_Green.off();
+    Led_Red.off();
+    switch (door_cycle)
+    {
+    case DoorCycle::LOCKED:
+        Led_Yellow.on();
+        break;
+    case DoorCycle::UNLOCKED:
+    case DoorCycle::OPEN:
+        Led_Green.on();
+        break;
+    case DoorCycle::ALARM:
+        Led_Red.on();
+        break;
+    }
+}
+
+// Blinks led on the actuator, with the other LEDs off, then shows the door state again. Replaces a blink still running.
+void Door::blink(Led &led, int times, int delayMs)
+{
+    loop.cancel(blink_timer);
+    Led_Green.off();
+    Led_Yellow.off();
+    Led_Red.off();
+    led.blink(times, delayMs);
+    blink_timer = loop.after(std::chrono::milliseconds(2 * times * delayMs), [this]
+    {
+        blink_timer = 0;
+        show_door_state();
+    });
+}
+
+void Door::show_error()
+{
+    blink(Led_Red, 2, 200);
+}
+
+void Door::initLeds()
+{
+    std::cerr << "=== INITLEDS() START ===" << std::endl;
+    for (int i = 0; i < 2; i++)
+    {
+        printf("Cycle %d/2\n", i + 1);
+
+        printf("GREEN ON\n");
+        Led_Green.on();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        printf("GREEN OFF\n");
+        Led_Green.off();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+        printf("YELLOW ON\n");
+        Led_Yellow.on();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        printf("YELLOW OFF\n");
+        Led_Yellow.off();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+        printf("RED ON\n");
+        Led_Red.on();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        printf("RED OFF\n");
+        Led_Red.off();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+        printf("BUZZER ON\n");
+        buzzer.beep(1000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+        printf("REED SWITCH OPEN: %d\n", RS.isDoorOpen());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    }
+}
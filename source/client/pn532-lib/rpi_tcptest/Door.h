@@ -0,0 +1,93 @@
+#pragma once
+#include "pn532_wrapper.h"
+#include "Actuator.h"
+#include "Buzzer.h"
+#include "Led.h"
+#include "ReedSwitch.h"
+#include "EventLoop.h"
+#include "CardPoller.h"
+#include "OfflineCache.h"
+#include "ScanFilter.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One reader with its LEDs, buzzer and reed switch, and the door cycle they show. A client drives one or more of them,
+// each polled on its own thread and I2C bus, and does the talking to the server for all of them.
+class Door
+{
+public:
+    // Physical pins, and the I2C bus of the reader
+    struct Pins
+    {
+        int bus;
+        int buzzer;
+        int green;
+        int yellow;
+        int red;
+        int reed;
+    };
+
+    Door(std::string name, const Pins &pins, EventLoop &loop, Actuator &actuator, const std::string &key);
+    Door(const Door &) = delete;
+    Door &operator=(const Door &) = delete;
+
+    const std::string &name() const { return doorname; }
+    bool ready() const { return rfid_reader->isInitialized(); }
+    OfflineCache &cache() { return offline; }
+    const ScanFilter::Counts &suppressed() const { return scan_filter.counts(); }
+
+    // Starts polling the reader and watching the reed switch. scans is called on the loop when cards are waiting in take(),
+    // changed whenever the door opens or closes, before the door cycle moves on.
+    void start(std::function<void()> scans, std::function<void(bool open)> changed);
+    // Cards presented since the last call, oldest first, without those scan_filter suppresses
+    std::vector<std::string> take();
+
+    // Shows the server's answer to a scan, or an offline decision, and unlocks the door if it is "approved"
+    void feedback(const std::string &reply);
+    void show_error();
+    void initLeds();
+
+private:
+    // Where the door is in its cycle after an approval. Runs on timers, so scans are taken at any point of it.
+    enum class DoorCycle
+    {
+        LOCKED,
+        UNLOCKED, // Approved, waiting for the door to open
+        OPEN,
+        ALARM,    // Open for too long
+    };
+
+    // Reed switch edges this soon after a reported change are contact bounce
+    static constexpr std::chrono::milliseconds REED_DEBOUNCE{20};
+    // The same card again this soon is not sent, and the reader sends at most SCAN_BURST scans at once, then one per SCAN_REFILL
+    static constexpr std::chrono::milliseconds DUPLICATE_WINDOW{3000};
+    static constexpr int SCAN_BURST = 3;
+    static constexpr std::chrono::milliseconds SCAN_REFILL{1000};
+
+    std::string doorname;
+    EventLoop &loop;
+    Buzzer buzzer;
+    Led Led_Green;
+    Led Led_Yellow;
+    Led Led_Red;
+    ReedSwitch RS;
+    std::unique_ptr<PN532Reader> rfid_reader;
+    std::unique_ptr<CardPoller> poller; // After rfid_reader, so it stops polling before the reader goes
+    OfflineCache offline;               // Decides while the server is unreachable
+    ScanFilter scan_filter{DUPLICATE_WINDOW, SCAN_BURST, SCAN_REFILL};
+    bool door_open_reported = false;
+
+    DoorCycle door_cycle = DoorCycle::LOCKED;
+    EventLoop::TimerId door_timer = 0;  // Relocks an unopened door, or raises the alarm for an open one
+    EventLoop::TimerId alarm_timer = 0; // Repeats the alarm beep
+    EventLoop::TimerId blink_timer = 0; // Ends the blink running on the actuator
+
+    void on_door(bool open);
+    void lock();
+    void start_alarm();
+    void show_door_state();
+    void blink(Led &led, int times, int delayMs);
+};
@@ -0,0 +1,173 @@
+#include "EventLoop.h"
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <stdexcept>
+
+EventLoop::EventLoop()
+{
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epoll_fd < 0 || timer_fd < 0)
+    {
+        throw std::runtime_error("Could not create epoll or timerfd");
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = timer_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event);
+}
+
+EventLoop::~EventLoop()
+{
+    close(timer_fd);
+    close(epoll_fd);
+}
+
+void EventLoop::watch(int fd, uint32_t events, FdCallback callback)
+{
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    const int op = fds.contains(fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(epoll_fd, op, fd, &event) < 0)
+    {
+        perror("epoll_ctl");
+        return;
+    }
+    fds[fd] = std::move(callback);
+}
+
+void EventLoop::unwatch(int fd)
+{
+    if (fds.erase(fd))
+    {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+EventLoop::TimerId EventLoop::after(std::chrono::milliseconds delay, Callback callback)
+{
+    return schedule(delay, std::chrono::milliseconds(0), std::move(callback));
+}
+
+EventLoop::TimerId EventLoop::every(std::chrono::milliseconds period, Callback callback)
+{
+    return schedule(period, period, std::move(callback));
+}
+
+EventLoop::TimerId EventLoop::schedule(std::chrono::milliseconds delay, std::chrono::milliseconds period, Callback callback)
+{
+    const TimerId id = next_id++;
+    timers.emplace(id, Timer{std::move(callback), period});
+    queue.push({Clock::now() + delay, id});
+    arm();
+    return id;
+}
+
+void EventLoop::cancel(TimerId id)
+{
+    if (timers.erase(id))
+    {
+        arm();
+    }
+}
+
+void EventLoop::arm()
+{
+    while (!queue.empty() && !timers.contains(queue.top().id))
+    {
+        queue.pop();
+    }
+
+    itimerspec spec{};
+    if (!queue.empty())
+    {
+        const auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(queue.top().when - Clock::now()).count();
+        // A zero it_value disarms the timerfd, so timers that are due already fire after 1 ns
+        const long long ns = delay > 0 ? delay : 1;
+        spec.it_value.tv_sec = ns / 1'000'000'000;
+        spec.it_value.tv_nsec = ns % 1'000'000'000;
+    }
+    timerfd_settime(timer_fd, 0, &spec, nullptr);
+}
+
+void EventLoop::runTimers()
+{
+    uint64_t expirations;
+    while (read(timer_fd, &expirations, sizeof(expirations)) > 0)
+    {
+    }
+
+    // Only timers due now, ones scheduled by the callbacks below wait for the next pass
+    const auto now = Clock::now();
+    std::vector<TimerId> due;
+    while (!queue.empty() && queue.top().when <= now)
+    {
+        due.push_back(queue.top().id);
+        queue.pop();
+    }
+
+    for (const TimerId id : due)
+    {
+        const auto timer = timers.find(id);
+        if (timer == timers.end())
+        {
+            continue; // Cancelled, possibly by an earlier callback of this batch
+        }
+
+        // Copy, the callback may cancel its own timer
+        const Callback callback = timer->second.callback;
+        if (timer->second.period.count() > 0)
+        {
+            queue.push({now + timer->second.period, id});
+        }
+        else
+        {
+            timers.erase(timer);
+        }
+        callback();
+    }
+    arm();
+}
+
+void EventLoop::run()
+{
+    running = true;
+    epoll_event events[16];
+    while (running)
+    {
+        const int n = epoll_wait(epoll_fd, events, 16, -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("epoll_wait");
+            return;
+        }
+
+        for (int i = 0; i < n && running; i++)
+        {
+            const int fd = events[i].data.fd;
+            if (fd == timer_fd)
+            {
+                runTimers();
+                continue;
+            }
+
+            // Copy, the callback may unwatch its own fd. Skip fds an earlier callback unwatched.
+            const auto watched = fds.find(fd);
+            if (watched == fds.end())
+            {
+                continue;
+            }
+            const FdCallback callback = watched->second;
+            callback(events[i].events);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+// Single-threaded event loop of the door client, built on epoll with one timerfd for all timers.
+// File descriptors call back when they are ready, timers when they are due. Callbacks run on the thread in run()
+// and may watch, unwatch, schedule and cancel anything, including themselves.
+class EventLoop
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+    using FdCallback = std::function<void(uint32_t events)>;
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    // events are EPOLLIN, EPOLLOUT etc. Level-triggered, watching a fd again replaces its callback.
+    void watch(int fd, uint32_t events, FdCallback callback);
+    void unwatch(int fd);
+
+    TimerId after(std::chrono::milliseconds delay, Callback callback);
+    TimerId every(std::chrono::milliseconds period, Callback callback);
+    // Ignores timers that fired already. Cancelling 0 does nothing, so it can stand for "no timer".
+    void cancel(TimerId id);
+
+    // Runs callbacks until stop() is called from one of them.
+    void run();
+    void stop() { running = false; }
+
+private:
+    struct Timer
+    {
+        Callback callback;
+        std::chrono::milliseconds period; // 0 for one-shot timers
+    };
+    struct Due
+    {
+        Clock::time_point when;
+        TimerId id;
+        bool operator>(const Due &other) const { return when > other.when; }
+    };
+
+    TimerId schedule(std::chrono::milliseconds delay, std::chrono::milliseconds period, Callback callback);
+    // Points the timerfd at the earliest timer, disarms it if there is none.
+    void arm();
+    void runTimers();
+
+    int epoll_fd;
+    int timer_fd;
+    bool running = false;
+    TimerId next_id = 1;
+    std::unordered_map<int, FdCallback> fds;
+    std::unordered_map<TimerId, Timer> timers;
+    std::priority_queue<Due, std::vector<Due>, std::greater<>> queue; // Cancelled timers stay until they come up
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <functional>
+
+extern "C"
+{
+#include "pn532.h"
+}
+
+// GPIO pins of the door client, in physical (BOARD) numbering.
+class Gpio
+{
+public:
+    enum class Mode
+    {
+        Input,
+        Output
+    };
+    enum class Pull
+    {
+        Off,
+        Down,
+        Up
+    };
+
+    virtual ~Gpio() = default;
+    virtual void setup(int pin, Mode mode, Pull pull = Pull::Off) = 0;
+    virtual void write(int pin, bool high) = 0;
+    virtual bool read(int pin) = 0;
+    // Calls changed on a backend thread whenever the input may have changed level, spurious calls included.
+    // Keep it short, e.g. wake an event loop that reads the pin. Returns false if the backend can't, poll the pin then.
+    virtual bool watch(int pin, std::function<void()> changed) = 0;
+    // No more calls for pin once this returns
+    virtual void unwatch(int pin) = 0;
+};
+
+// Hardware layer of the door client. The build picks one backend:
+// HalWiringPi.cpp drives the Raspberry Pi through wiringPi and /dev/i2c,
+// HalSimulated.cpp (cmake -DSIMULATED=ON) plays a script of cards and door movements on any Linux box, see there.
+namespace hal
+{
+    // Call once before anything else touches the hardware. Returns false if it could not be set up.
+    bool init();
+    Gpio &gpio();
+    // Points the transport functions of a PN532 handle at the reader on an I2C bus, like PN532_I2C_Init.
+    // Returns false if the bus can't be opened, or there are more readers than MAX_READERS.
+    bool initPn532(PN532 *pn532, int bus = 1);
+    constexpr int MAX_READERS = 4;
+}
@@ -0,0 +1,489 @@
+#include "Hal.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Simulated hardware, so the real door client runs on any Linux box, e.g. against a test server or many at once for load tests.
+// It plays the script in the file named by $SIM_SCRIPT, one event per line, at ms since start (or since the last repeat):
+//   500   card 6a13ba66   a card is put on the reader, 4 or 7 byte UID in hex. "card 6a13ba66 3" for the reader on I2C bus 3.
+//   1500  remove          the card is taken off again, "remove 3" on bus 3
+//   2000  open            the door opens, i.e. the reed switch input goes high. "open 35" for that pin only.
+//                         Lines a few ms apart play a bouncing contact, e.g. open, close, open at 2000, 2001, 2003.
+//   5000  close           the door closes
+//   0     i2c 2           each I2C transfer of the PN532 takes 2 ms from now on, 1 ms by default
+//   8000  repeat          start over
+// '#' starts a comment. Without a script no card ever shows up and the door stays closed.
+// The PN532 is simulated behind its transport functions, so the pn532 library and PN532Reader run unchanged.
+// Each I2C bus has its own reader, scripts without a bus use bus 1.
+// Output pin changes are printed to stderr, to follow the LEDs and the buzzer.
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Step
+    {
+        std::chrono::milliseconds at;
+        std::string event;
+        std::vector<uint8_t> uid; // card
+        int value = -1;           // i2c latency, open/close pin (-1 for all), card/remove bus
+    };
+
+    // Shared by the script thread, the GPIO calls and the PN532 transport
+    std::mutex mtx;
+    std::condition_variable changed;
+    bool stopping = false;
+    const Clock::time_point started = Clock::now();
+
+    std::map<int, bool> outputs;
+    std::map<int, bool> inputs; // Pins opened or closed by number
+    bool doorOpen = false;      // All other inputs
+    std::chrono::milliseconds i2cLatency{1};
+    std::map<int, std::function<void()>> watchers; // Input pins watched for edges
+
+    // PN532 command in progress: written, then its ACK and its response are read
+    enum class Stage
+    {
+        Idle,
+        Ack,
+        Response
+    };
+    struct Reader
+    {
+        std::vector<uint8_t> card; // UID on the reader, empty if none
+        Stage stage = Stage::Idle;
+        uint8_t command = 0;
+    };
+    std::map<int, Reader> readers; // By I2C bus
+
+    long long elapsedMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - started).count();
+    }
+
+    class SimulatedGpio : public Gpio
+    {
+    public:
+        void setup(int pin, Mode mode, Pull) override
+        {
+            const std::lock_guard lock(mtx);
+            if (mode == Mode::Output)
+            {
+                outputs.try_emplace(pin, false);
+            }
+        }
+
+        void write(int pin, bool high) override
+        {
+            const std::lock_guard lock(mtx);
+            const auto [level, added] = outputs.try_emplace(pin, high);
+            if (added || level->second != high)
+            {
+                level->second = high;
+                std::cerr << "[sim " << elapsedMs() << " ms] pin " << pin << (high ? " high" : " low") << std::endl;
+            }
+        }
+
+        bool read(int pin) override
+        {
+            const std::lock_guard lock(mtx);
+            const auto level = inputs.find(pin);
+            return level != inputs.end() ? level->second : doorOpen;
+        }
+
+        bool watch(int pin, std::function<void()> changed) override
+        {
+            const std::lock_guard lock(mtx);
+            watchers[pin] = std::move(changed);
+            return true;
+        }
+
+        void unwatch(int pin) override
+        {
+            const std::lock_guard lock(mtx);
+            watchers.erase(pin);
+        }
+    };
+
+    void apply(const Step &step)
+    {
+        if (step.event == "card")
+        {
+            readers[step.value].card = step.uid;
+        }
+        else if (step.event == "remove")
+        {
+            readers[step.value].card.clear();
+        }
+        else if (step.event == "open" || step.event == "close")
+        {
+            const bool open = step.event == "open";
+            if (step.value < 0)
+            {
+                doorOpen = open;
+                inputs.clear();
+            }
+            else
+            {
+                inputs[step.value] = open;
+            }
+            // Called under mtx, so like on the edge thread of the real backend they must not block
+            for (const auto &[pin, changed] : watchers)
+            {
+                if (step.value < 0 || step.value == pin)
+                {
+                    changed();
+                }
+            }
+        }
+        else if (step.event == "i2c")
+        {
+            i2cLatency = std::chrono::milliseconds(step.value);
+        }
+        changed.notify_all();
+    }
+
+    bool parse(std::istream &in, std::vector<Step> &steps)
+    {
+        std::string text;
+        for (int number = 1; std::getline(in, text); number++)
+        {
+            text = text.substr(0, text.find('#'));
+            std::istringstream line(text);
+            long long at;
+            Step step;
+            if (!(line >> at))
+            {
+                if (text.find_first_not_of(" \t\r") == std::string::npos)
+                {
+                    continue; // Blank or comment
+                }
+                std::cerr << "SIM_SCRIPT line " << number << ": expected a time in ms" << std::endl;
+                return false;
+            }
+            step.at = std::chrono::milliseconds(at);
+            line >> step.event;
+
+            bool valid = at >= 0;
+            if (step.event == "card")
+            {
+                std::string hex;
+                line >> hex;
+                valid = valid && (hex.size() == 8 || hex.size() == 14) && hex.find_first_not_of("0123456789abcdefABCDEF") == std::string::npos;
+                for (size_t i = 0; valid && i < hex.size(); i += 2)
+                {
+                    step.uid.push_back(static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+                }
+                if (!(line >> step.value))
+                {
+                    step.value = 1;
+                }
+            }
+            else if (step.event == "i2c")
+            {
+                valid = valid && line >> step.value && step.value >= 0;
+            }
+            else if (step.event == "open" || step.event == "close")
+            {
+                if (!(line >> step.value))
+                {
+                    step.value = -1;
+                }
+            }
+            else if (step.event == "repeat")
+            {
+                valid = valid && at > 0;
+            }
+            else
+            {
+                valid = step.event == "remove" && valid;
+                if (!(line >> step.value))
+                {
+                    step.value = 1;
+                }
+            }
+
+            if (!valid)
+            {
+                std::cerr << "SIM_SCRIPT line " << number << ": invalid event \"" << text << "\"" << std::endl;
+                return false;
+            }
+            steps.push_back(std::move(step));
+        }
+        std::stable_sort(steps.begin(), steps.end(), [](const Step &a, const Step &b)
+                         { return a.at < b.at; });
+        return true;
+    }
+
+    // Plays the script on its own thread until the client exits
+    class Player
+    {
+    public:
+        void start(std::vector<Step> script)
+        {
+            steps = std::move(script);
+            if (!steps.empty())
+            {
+                thread = std::thread(&Player::play, this);
+            }
+        }
+
+        ~Player()
+        {
+            {
+                const std::lock_guard lock(mtx);
+                stopping = true;
+            }
+            changed.notify_all();
+            if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
+
+    private:
+        void play()
+        {
+            Clock::time_point base = started;
+            std::unique_lock lock(mtx);
+            for (size_t i = 0; i < steps.size();)
+            {
+                if (changed.wait_until(lock, base + steps[i].at, []
+                                       { return stopping; }))
+                {
+                    return;
+                }
+                if (steps[i].event == "repeat")
+                {
+                    base += steps[i].at;
+                    i = 0;
+                    continue;
+                }
+                apply(steps[i++]);
+            }
+        }
+
+        std::vector<Step> steps;
+        std::thread thread;
+    };
+    Player player;
+
+    /**************************************************************************
+     * PN532 transport, stands in for PN532_I2C_*
+     **************************************************************************/
+    const uint8_t ACK[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+
+    // 00 00 FF LEN LCS data DCS 00
+    std::vector<uint8_t> frame(const std::vector<uint8_t> &data)
+    {
+        std::vector<uint8_t> out = {0x00, 0x00, 0xFF, static_cast<uint8_t>(data.size()), static_cast<uint8_t>(-data.size())};
+        uint8_t sum = 0;
+        for (const uint8_t byte : data)
+        {
+            out.push_back(byte);
+            sum += byte;
+        }
+        out.push_back(static_cast<uint8_t>(-sum));
+        out.push_back(0x00);
+        return out;
+    }
+
+    std::vector<uint8_t> respond(const Reader &reader)
+    {
+        const std::vector<uint8_t> &card = reader.card;
+        std::vector<uint8_t> data = {PN532_PN532TOHOST, static_cast<uint8_t>(reader.command + 1)};
+        switch (reader.command)
+        {
+        case PN532_COMMAND_GETFIRMWAREVERSION:
+            data.insert(data.end(), {0x32, 0x01, 0x06, 0x07}); // PN532 v1.6
+            break;
+        case PN532_COMMAND_SAMCONFIGURATION:
+            break;
+        case PN532_COMMAND_INLISTPASSIVETARGET:
+            // One target: Tg, SENS_RES, SEL_RES, NFCID length, NFCID
+            data.insert(data.end(), {0x01, 0x01, 0x00, 0x04, 0x08, static_cast<uint8_t>(card.size())});
+            data.insert(data.end(), card.begin(), card.end());
+            break;
+        case PN532_COMMAND_INAUTOPOLL:
+            // One target of type 0x10 (MIFARE) with the same target data
+            data.insert(data.end(), {0x01, 0x10, static_cast<uint8_t>(5 + card.size()), 0x01, 0x00, 0x04, 0x08, static_cast<uint8_t>(card.size())});
+            data.insert(data.end(), card.begin(), card.end());
+            break;
+        default:
+            data.push_back(0x00); // Status OK
+            break;
+        }
+        return frame(data);
+    }
+
+    void transfer()
+    {
+        std::chrono::milliseconds latency;
+        {
+            const std::lock_guard lock(mtx);
+            latency = i2cLatency;
+        }
+        std::this_thread::sleep_for(latency);
+    }
+
+    int simReset(void)
+    {
+        return PN532_STATUS_OK;
+    }
+
+    int simWakeup(void)
+    {
+        return PN532_STATUS_OK;
+    }
+
+    void simLog(const char *log)
+    {
+        std::cerr << "PN532: " << log << std::endl;
+    }
+
+    int simWriteData(int bus, uint8_t *data, uint16_t count)
+    {
+        transfer();
+        const std::lock_guard lock(mtx);
+        Reader &reader = readers[bus];
+        if (count == sizeof(ACK) && std::equal(data, data + count, ACK))
+        {
+            reader.stage = Stage::Idle; // The host aborts the command in progress
+            return PN532_STATUS_OK;
+        }
+        if (count < 8 || data[5] != PN532_HOSTTOPN532)
+        {
+            reader.stage = Stage::Idle;
+            return PN532_STATUS_ERROR;
+        }
+        reader.command = data[6];
+        reader.stage = Stage::Ack;
+        return PN532_STATUS_OK;
+    }
+
+    bool simWaitReady(int bus, uint32_t timeout)
+    {
+        transfer();
+        std::unique_lock lock(mtx);
+        Reader &reader = readers[bus];
+        if (reader.stage == Stage::Response && (reader.command == PN532_COMMAND_INLISTPASSIVETARGET || reader.command == PN532_COMMAND_INAUTOPOLL))
+        {
+            // Like the real reader, only answers once a card is in the field
+            changed.wait_for(lock, std::chrono::milliseconds(timeout), [&]
+                             { return !reader.card.empty() || stopping; });
+            return !reader.card.empty();
+        }
+        return reader.stage != Stage::Idle;
+    }
+
+    int simReadData(int bus, uint8_t *data, uint16_t count)
+    {
+        transfer();
+        const std::lock_guard lock(mtx);
+        Reader &reader = readers[bus];
+        std::vector<uint8_t> out;
+        if (reader.stage == Stage::Ack)
+        {
+            out.assign(std::begin(ACK), std::end(ACK));
+            reader.stage = Stage::Response;
+        }
+        else if (reader.stage == Stage::Response)
+        {
+            out = respond(reader);
+            reader.stage = Stage::Idle;
+        }
+        else
+        {
+            return PN532_STATUS_ERROR;
+        }
+
+        std::fill(data, data + count, 0x00);
+        std::copy_n(out.begin(), std::min<size_t>(count, out.size()), data);
+        return PN532_STATUS_OK;
+    }
+
+    // PN532 handles take plain functions, so each reader gets a slot with its own set of them, bound to its bus
+    std::array<int, hal::MAX_READERS> slotBuses;
+    int slotsUsed = 0;
+
+    template <int Slot>
+    int slotReadData(uint8_t *data, uint16_t count)
+    {
+        return simReadData(slotBuses[Slot], data, count);
+    }
+
+    template <int Slot>
+    int slotWriteData(uint8_t *data, uint16_t count)
+    {
+        return simWriteData(slotBuses[Slot], data, count);
+    }
+
+    template <int Slot>
+    bool slotWaitReady(uint32_t timeout)
+    {
+        return simWaitReady(slotBuses[Slot], timeout);
+    }
+
+    template <int Slot>
+    void initSlot(PN532 *pn532)
+    {
+        pn532->reset = simReset;
+        pn532->read_data = slotReadData<Slot>;
+        pn532->write_data = slotWriteData<Slot>;
+        pn532->wait_ready = slotWaitReady<Slot>;
+        pn532->wakeup = simWakeup;
+        pn532->log = simLog;
+    }
+}
+
+bool hal::init()
+{
+    std::vector<Step> steps;
+    const char *path = std::getenv("SIM_SCRIPT");
+    if (path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cerr << "Could not open SIM_SCRIPT " << path << std::endl;
+            return false;
+        }
+        if (!parse(file, steps))
+        {
+            return false;
+        }
+    }
+    std::cerr << "Simulated hardware, " << (path ? path : "no script") << std::endl;
+    player.start(std::move(steps));
+    return true;
+}
+
+Gpio &hal::gpio()
+{
+    static SimulatedGpio gpio;
+    return gpio;
+}
+
+bool hal::initPn532(PN532 *pn532, int bus)
+{
+    if (slotsUsed == static_cast<int>(slotBuses.size()))
+    {
+        return false;
+    }
+    const int slot = slotsUsed++;
+    slotBuses[slot] = bus;
+    static constexpr void (*inits[])(PN532 *) = {initSlot<0>, initSlot<1>, initSlot<2>, initSlot<3>};
+    static_assert(std::size(inits) == std::tuple_size_v<decltype(slotBuses)>);
+    inits[slot](pn532);
+    return true;
+}
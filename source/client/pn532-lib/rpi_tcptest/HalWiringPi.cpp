@@ -0,0 +1,151 @@
+#include "Hal.h"
+#include <wiringPi.h>
+#include <array>
+#include <map>
+#include <mutex>
+#include <set>
+
+extern "C"
+{
+#include "pn532_rpi.h"
+}
+
+namespace
+{
+    // wiringPiISR takes no context, so one handler serves every watched pin and wakes all of them
+    std::mutex watchMtx;
+    std::map<int, std::function<void()>> watchers;
+    std::set<int> interrupts; // Pins with the handler registered, wiringPi can't remove it again
+
+    void onEdge()
+    {
+        const std::lock_guard lock(watchMtx);
+        for (const auto &[pin, changed] : watchers)
+        {
+            changed();
+        }
+    }
+
+    // PN532 handles take plain functions, so every further reader gets a slot with its own set of them.
+    // Bus 1 is the reader PN532_I2C_Init sets up, with the reset and wakeup pins; the others skip both.
+    std::array<int, hal::MAX_READERS - 1> busFds;
+    int busesOpen = 0;
+
+    template <int Slot>
+    int slotReadData(uint8_t *data, uint16_t count)
+    {
+        return PN532_I2C_ReadDataOn(busFds[Slot], data, count);
+    }
+
+    template <int Slot>
+    int slotWriteData(uint8_t *data, uint16_t count)
+    {
+        return PN532_I2C_WriteDataOn(busFds[Slot], data, count);
+    }
+
+    template <int Slot>
+    bool slotWaitReady(uint32_t timeout)
+    {
+        return PN532_I2C_WaitReadyOn(busFds[Slot], timeout);
+    }
+
+    int slotNothing(void)
+    {
+        return PN532_STATUS_OK;
+    }
+
+    template <int Slot>
+    void initSlot(PN532 *pn532)
+    {
+        pn532->reset = slotNothing;
+        pn532->read_data = slotReadData<Slot>;
+        pn532->write_data = slotWriteData<Slot>;
+        pn532->wait_ready = slotWaitReady<Slot>;
+        pn532->wakeup = slotNothing;
+        pn532->log = PN532_Log;
+    }
+
+    class WiringPiGpio : public Gpio
+    {
+    public:
+        void setup(int pin, Mode mode, Pull pull) override
+        {
+            pinMode(pin, mode == Mode::Output ? OUTPUT : INPUT);
+            if (mode == Mode::Input)
+            {
+                pullUpDnControl(pin, pull == Pull::Down ? PUD_DOWN : pull == Pull::Up ? PUD_UP : PUD_OFF);
+            }
+        }
+
+        void write(int pin, bool high) override
+        {
+            digitalWrite(pin, high ? HIGH : LOW);
+        }
+
+        bool read(int pin) override
+        {
+            return digitalRead(pin) == HIGH;
+        }
+
+        bool watch(int pin, std::function<void()> changed) override
+        {
+            {
+                const std::lock_guard lock(watchMtx);
+                watchers[pin] = std::move(changed);
+                if (interrupts.contains(pin))
+                {
+                    return true;
+                }
+            }
+            if (wiringPiISR(pin, INT_EDGE_BOTH, &onEdge) < 0)
+            {
+                unwatch(pin);
+                return false;
+            }
+            const std::lock_guard lock(watchMtx);
+            interrupts.insert(pin);
+            return true;
+        }
+
+        void unwatch(int pin) override
+        {
+            const std::lock_guard lock(watchMtx);
+            watchers.erase(pin);
+        }
+    };
+}
+
+bool hal::init()
+{
+    return wiringPiSetupPhys() != -1;
+}
+
+Gpio &hal::gpio()
+{
+    static WiringPiGpio gpio;
+    return gpio;
+}
+
+bool hal::initPn532(PN532 *pn532, int bus)
+{
+    if (bus == 1)
+    {
+        PN532_I2C_Init(pn532);
+        return true;
+    }
+    if (busesOpen == static_cast<int>(busFds.size()))
+    {
+        return false;
+    }
+    const int fd = PN532_I2C_Open(bus);
+    if (fd < 0)
+    {
+        return false;
+    }
+    const int slot = busesOpen++;
+    busFds[slot] = fd;
+    static constexpr void (*inits[])(PN532 *) = {initSlot<0>, initSlot<1>, initSlot<2>};
+    static_assert(std::size(inits) == std::tuple_size_v<decltype(busFds)>);
+    inits[slot](pn532);
+    return true;
+}
@@ -1,26 +1,22 @@
 #include "Led.h"
-#include <wiringPi.h>
-#include <thread>
+#include "Hal.h"
 
-Led::Led(int physPin) : pin(physPin)
+Led::Led(Actuator &actuator, int physPin) : actuator(actuator), pin(physPin)
 {
-    pinMode(pin, OUTPUT);
+    hal::gpio().setup(pin, Gpio::Mode::Output);
 }
 
 void Led::on()
 {
-    digitalWrite(pin, HIGH);
+    actuator.write(pin, true);
 }
 
 void Led::off()
 {
-    digitalWrite(pin, LOW);
+    actuator.write(pin, false);
 }
 
-void Led::blink(int delayMs)
+void Led::blink(int times, int delayMs)
 {
-    on();
-    std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
-    off();
-    std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+    actuator.play(Actuator::pulses(pin, times, std::chrono::milliseconds(delayMs), std::chrono::milliseconds(delayMs)));
 }
\ No newline at end of file
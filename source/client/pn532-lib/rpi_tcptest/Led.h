@@ -1,14 +1,17 @@
 #pragma once
+#include "Actuator.h"
 
+// Writes go through the Actuator, so they never block the caller
 class Led
 {
 private:
+    Actuator &actuator;
     int pin;
 
 public:
-    Led() = default;
-    Led(int physPin);
+    Led(Actuator &actuator, int physPin);
     void on();
     void off();
-    void blink(int delayMs);
+    // Starts blinking times times and returns at once. on() or off() stops it.
+    void blink(int times, int delayMs);
 };
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "OfflineCache.h"
+#include "DoorSnapshot.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+
+OfflineCache::OfflineCache(std::string doorname, std::string key, std::string path) : door(std::move(doorname)), key(std::move(key)), path(std::move(path))
+{
+    if (enabled())
+    {
+        load();
+    }
+}
+
+bool OfflineCache::apply(std::string_view payload)
+{
+    snapshot::Message message;
+    if (!enabled() || !snapshot::decode(payload, key, message) || message.door != door)
+    {
+        std::cerr << "Ignoring snapshot with a bad signature or for another door" << std::endl;
+        return false;
+    }
+    if (message.time < stamp)
+    {
+        std::cerr << "Ignoring snapshot older than the one held" << std::endl;
+        return false;
+    }
+    if (message.base != "0" && message.base != current)
+    {
+        std::cerr << "Ignoring delta against version " << message.base << ", holding " << current << std::endl;
+        current = "0";
+        return false;
+    }
+
+    stamp = message.time;
+    if (message.base == message.version && message.entries.empty())
+    {
+        return true; // Up to date
+    }
+    if (!apply(message.entries, message.base != "0") || current != message.version)
+    {
+        std::cerr << "Snapshot did not end up at version " << message.version << ", asking for a full one" << std::endl;
+        cards.clear();
+        current = "0";
+        return false;
+    }
+    std::cerr << "Offline cache at version " << current << " with " << cards.size() << " cards" << std::endl;
+    save();
+    return true;
+}
+
+// entries as sent: a full list, or "-uid" and "+entry" items against the cards held
+bool OfflineCache::apply(std::string_view entries, bool delta)
+{
+    if (!delta)
+    {
+        cards.clear();
+    }
+
+    std::vector<std::string_view> added;
+    while (!entries.empty())
+    {
+        const size_t comma = entries.find(',');
+        std::string_view item = entries.substr(0, comma);
+        entries.remove_prefix(comma == std::string_view::npos ? entries.size() : comma + 1);
+        if (!delta)
+        {
+            added.push_back(item);
+        }
+        else if (item.size() > 1 && item[0] == '-')
+        {
+            cards.erase(std::string(item.substr(1))); // Removals first, a changed expiry is sent as both
+        }
+        else if (item.size() > 1 && item[0] == '+')
+        {
+            added.push_back(item.substr(1));
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    for (const std::string_view item : added)
+    {
+        const size_t equals = item.find('=');
+        uint32_t expires = 0;
+        if (equals != std::string_view::npos)
+        {
+            // A torn or edited list fails here, and the caller asks for a full snapshot
+            const std::string_view digits = item.substr(equals + 1);
+            const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), expires);
+            if (error != std::errc() || end != digits.data() + digits.size())
+            {
+                return false;
+            }
+        }
+        cards[std::string(item.substr(0, equals))] = expires;
+    }
+
+    // The version covers the whole list, so a delta applied to the wrong base shows here
+    std::vector<std::string> sorted;
+    sorted.reserve(cards.size());
+    for (const auto &[uid, expires] : cards)
+    {
+        sorted.push_back(expires ? uid + '=' + std::to_string(expires) : uid);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    current = snapshot::version(sorted);
+    return true;
+}
+
+bool OfflineCache::allows(const std::string &uid, int64_t now) const
+{
+    const auto card = cards.find(uid);
+    return card != cards.end() && (card->second == 0 || now < card->second);
+}
+
+// "<version> <time>", then one "uid" or "uid=expires" per line
+void OfflineCache::load()
+{
+    std::ifstream file(path);
+    std::string version;
+    int64_t time;
+    if (!(file >> version >> time))
+    {
+        return;
+    }
+
+    std::string entries;
+    std::string entry;
+    while (file >> entry)
+    {
+        entries += entries.empty() ? entry : ',' + entry;
+    }
+    if (apply(entries, false) && current == version)
+    {
+        stamp = time;
+        std::cerr << "Loaded offline cache version " << current << " with " << cards.size() << " cards" << std::endl;
+    }
+    else
+    {
+        std::cerr << "Ignoring the damaged offline cache in " << path << ", asking for a full one" << std::endl;
+        cards.clear();
+        current = "0";
+    }
+}
+
+void OfflineCache::save() const
+{
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        file << current << ' ' << stamp << '\n';
+        for (const auto &[uid, expires] : cards)
+        {
+            file << uid;
+            if (expires)
+            {
+                file << '=' << expires;
+            }
+            file << '\n';
+        }
+        file.flush();
+        if (!file)
+        {
+            std::cerr << "Could not save the offline cache to " << temp << std::endl;
+            return;
+        }
+    }
+    // On disk before the rename, so a power cut leaves the old cache or the new one, never a truncated file
+    const int fd = open(temp.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || fsync(fd) != 0)
+    {
+        std::cerr << "Could not sync the offline cache to " << temp << std::endl;
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return;
+    }
+    close(fd);
+    std::rename(temp.c_str(), path.c_str());
+}
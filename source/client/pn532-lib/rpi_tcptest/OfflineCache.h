@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Cards allowed at this door, kept in sync with signed snapshots from the server (common/DoorSnapshot.h),
+// so the door still decides while the server is unreachable. A decision is one hash lookup.
+// The cache is saved to path after every change and loaded on start, so it survives a restart during an outage.
+// Needs the server's door.key, without one it stays empty and never allows anything.
+class OfflineCache
+{
+public:
+    OfflineCache(std::string doorname, std::string key, std::string path);
+
+    bool enabled() const { return !key.empty(); }
+    // Version held, "0" before the first snapshot.
+    const std::string &version() const { return current; }
+    size_t size() const { return cards.size(); }
+
+    // Applies a "@sync:..." payload from the server. Returns false if it isn't for this door, isn't signed with the key,
+    // is older than the snapshot held, or doesn't end up at the version it names. The cache then asks for a full snapshot next time.
+    bool apply(std::string_view payload);
+
+    bool allows(const std::string &uid, int64_t now) const;
+
+private:
+    bool apply(std::string_view entries, bool delta);
+    void load();
+    void save() const;
+
+    std::string door;
+    std::string key;
+    std::string path;
+    std::string current = "0";
+    int64_t stamp = 0;                              // Server time of the snapshot held
+    std::unordered_map<std::string, uint32_t> cards; // UID to Unix time it expires, 0 for never
+};
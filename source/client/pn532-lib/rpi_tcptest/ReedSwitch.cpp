@@ -1,26 +1,98 @@
 #include "ReedSwitch.h"
-#include <wiringPi.h>
+#include "Hal.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <iostream>
+#include <stdexcept>
 
 // physPin = *physical pin number* (BOARD numbering)
-ReedSwitch::ReedSwitch(int physPin)
+ReedSwitch::ReedSwitch(int physPin, std::chrono::milliseconds debounce) : pin(physPin), debounce(debounce)
 {
-    pin = physPin;
-    pinMode(pin, INPUT);
-    pullUpDnControl(pin, PUD_DOWN); // enable pulldown
+    hal::gpio().setup(pin, Gpio::Mode::Input, Gpio::Pull::Down); // enable pulldown
+    event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd < 0)
+    {
+        throw std::runtime_error("Could not create eventfd");
+    }
+}
+
+ReedSwitch::~ReedSwitch()
+{
+    hal::gpio().unwatch(pin);
+    if (loop)
+    {
+        loop->unwatch(event_fd);
+        loop->cancel(settle_timer);
+        loop->cancel(poll_timer);
+    }
+    close(event_fd);
 }
 
 // returns true, when magnet is present!
 bool ReedSwitch::magnetPresent() const
 {
-    return digitalRead(pin) == LOW;
+    return !hal::gpio().read(pin);
 }
 
 bool ReedSwitch::isDoorOpen() const
 {
-    return magnetPresent(); // magnet present -> door open.
+    return !magnetPresent(); // magnet away from the frame -> door open.
 }
 
 bool ReedSwitch::isDoorClosed() const
 {
-    return !magnetPresent(); // magnet not present -> door not open.
+    return magnetPresent(); // magnet at the frame -> door closed.
+}
+
+void ReedSwitch::watch(EventLoop &loop, std::function<void(bool open)> changed)
+{
+    this->loop = &loop;
+    this->changed = std::move(changed);
+    reported_open = isDoorOpen();
+    loop.watch(event_fd, EPOLLIN, [this](uint32_t) { on_edge(); });
+
+    const int fd = event_fd;
+    const bool edges = hal::gpio().watch(pin, [fd]
+    {
+        const uint64_t one = 1;
+        write(fd, &one, sizeof(one));
+    });
+    if (!edges)
+    {
+        std::cerr << "No edge events for the reed switch, reading it every 50 ms" << std::endl;
+        poll_timer = loop.every(std::chrono::milliseconds(50), [this]
+        {
+            if (!settle_timer && isDoorOpen() != reported_open)
+            {
+                on_edge();
+            }
+        });
+    }
+}
+
+void ReedSwitch::on_edge()
+{
+    uint64_t count;
+    while (read(event_fd, &count, sizeof(count)) > 0)
+    {
+    }
+    // Every edge starts the wait over, so the level is only read once the contact stopped bouncing
+    loop->cancel(settle_timer);
+    settle_timer = loop->after(debounce, [this]
+    {
+        settle_timer = 0;
+        settle();
+    });
 }
+
+// Reports the level if it changed
+void ReedSwitch::settle()
+{
+    const bool open = isDoorOpen();
+    if (open != reported_open)
+    {
+        reported_open = open;
+        changed(open);
+    }
+}
\ No newline at end of file
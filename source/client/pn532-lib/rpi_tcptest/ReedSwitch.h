@@ -1,14 +1,36 @@
 #pragma once
+#include "EventLoop.h"
+#include <chrono>
+#include <functional>
 
 class ReedSwitch
 {
 private:
     int pin;
+    std::chrono::milliseconds debounce;
+    int event_fd = -1; // Written on the backend's edge thread, read on the loop
+    EventLoop *loop = nullptr;
+    std::function<void(bool open)> changed;
+    bool reported_open = false;
+    EventLoop::TimerId settle_timer = 0; // Runs from the last edge until the level is read
+    EventLoop::TimerId poll_timer = 0;   // Only if the backend has no edge events
+
+    void on_edge();
+    void settle();
 
 public:
-    ReedSwitch() = default;
-    ReedSwitch(int physPin);
+    // A change is reported once the pin kept its level for debounce, shorter pulses are contact bounce or noise
+    ReedSwitch(int physPin, std::chrono::milliseconds debounce = std::chrono::milliseconds(20));
+    ~ReedSwitch();
+    ReedSwitch(const ReedSwitch &) = delete;
+    ReedSwitch &operator=(const ReedSwitch &) = delete;
+
     bool magnetPresent() const;
     bool isDoorOpen() const;
     bool isDoorClosed() const;
+
+    // Calls changed on loop whenever the door opens or closes, starting from the state it is in now.
+    // Edge-triggered through the GPIO backend, so a change is reported debounce after the last edge.
+    // Falls back to reading the pin every 50 ms if the backend can't watch it.
+    void watch(EventLoop &loop, std::function<void(bool open)> changed);
 };
\ No newline at end of file
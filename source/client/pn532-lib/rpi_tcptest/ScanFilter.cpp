@@ -0,0 +1,34 @@
+#include "ScanFilter.h"
+#include <algorithm>
+
+ScanFilter::ScanFilter(std::chrono::milliseconds window, int burst, std::chrono::milliseconds refill)
+    : window(window), burst(burst), refill(refill), tokens(burst), refilled(Clock::now())
+{
+}
+
+bool ScanFilter::accept(const std::string &uid, Clock::time_point now)
+{
+    const auto last = recent.find(uid);
+    if (last != recent.end() && now - last->second < window)
+    {
+        suppressed.duplicates++;
+        return false;
+    }
+
+    tokens = std::min<double>(burst, tokens + std::chrono::duration<double>(now - refilled) / refill);
+    refilled = now;
+    if (tokens < 1)
+    {
+        suppressed.limited++;
+        return false;
+    }
+    tokens -= 1;
+
+    recent[uid] = now;
+    if (recent.size() >= prune_at)
+    {
+        std::erase_if(recent, [&](const auto &entry) { return now - entry.second >= window; });
+        prune_at = std::max<size_t>(64, 2 * recent.size()); // Pruning stays amortised O(1) per scan
+    }
+    return true;
+}
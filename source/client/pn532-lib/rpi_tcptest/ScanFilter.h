@@ -0,0 +1,36 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Drops scans at the reader before they reach the server: the same card again within window of its last
+// accepted scan, and any scan once the reader's token bucket is empty (burst scans at once, then one per refill).
+class ScanFilter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Counts
+    {
+        uint64_t duplicates = 0;
+        uint64_t limited = 0;
+        bool operator==(const Counts &) const = default;
+    };
+
+    ScanFilter(std::chrono::milliseconds window, int burst, std::chrono::milliseconds refill);
+
+    // False if the scan is suppressed, counted in counts()
+    bool accept(const std::string &uid, Clock::time_point now = Clock::now());
+    const Counts &counts() const { return suppressed; }
+
+private:
+    std::chrono::milliseconds window;
+    int burst;
+    std::chrono::milliseconds refill;
+    double tokens;
+    Clock::time_point refilled;
+    std::unordered_map<std::string, Clock::time_point> recent; // UID to its last accepted scan, pruned as it grows
+    size_t prune_at = 64;
+    Counts suppressed;
+};
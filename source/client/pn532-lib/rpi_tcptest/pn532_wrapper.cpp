@@ -1,7 +1,17 @@
 #include "pn532_wrapper.h"
+#include "Hal.h"
+#include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <thread>
 
-PN532Reader::PN532Reader() {
+namespace
+{
+    // Also what the host sends to abort a command
+    const uint8_t ACK_FRAME[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
+}
+
+PN532Reader::PN532Reader(int bus) : bus(bus) {
     memset(&pn532, 0, sizeof(pn532)); 
 }
 
@@ -9,7 +19,12 @@ bool PN532Reader::init_pn532()
 {
     uint8_t buff_firmware[255];
     // PN532_SPI_Init(&pn532);
-    PN532_I2C_Init(&pn532);
+    // PN532_I2C_Init, or the simulated reader
+    if (!hal::initPn532(&pn532, bus))
+    {
+        std::cerr << "Could not open the PN532 on I2C bus " << bus << std::endl;
+        return false;
+    }
     // PN532_UART_Init(&pn532);
     if (PN532_GetFirmwareVersion(&pn532, buff_firmware) == PN532_STATUS_OK)
     {
@@ -21,6 +36,8 @@ bool PN532Reader::init_pn532()
         return false;
     }
     PN532_SamConfiguration(&pn532);
+    // A PN532 (IC 0x32) polls on its own with InAutoPoll, other chips of the family get InListPassiveTarget
+    auto_poll = buff_firmware[0] == 0x32;
     setup_complete = true; 
     return true; 
 }
@@ -37,8 +54,16 @@ bool PN532Reader::waitForScan(){
     }
     
     // Check if a card is available to read
-    uid_len = PN532_ReadPassiveTarget(&pn532, uid, PN532_MIFARE_ISO14443A, 1000);
-    if (uid_len == PN532_STATUS_ERROR)
+    const Poll result = poll();
+    if (result == Poll::Error)
+    {
+        // A disconnected or confused reader would otherwise be hammered with commands
+        backoff_ms = backoff_ms ? std::min(2 * backoff_ms, BACKOFF_MAX_MS) : BACKOFF_MIN_MS;
+        std::this_thread::sleep_for(std::chrono::milliseconds(backoff_ms));
+        return false;
+    }
+    backoff_ms = 0;
+    if (result == Poll::None)
     {
         return false; 
     }
@@ -57,3 +82,75 @@ std::string PN532Reader::getStringUID() const
     return uid_string; 
 }
 
+// One detection command: InAutoPoll for a MIFARE card polled without end, or InListPassiveTarget for one 106 kbps type A card.
+// Both keep the RF field searching inside the PN532 until a card answers, so the UID is read as soon as the host sees it ready.
+PN532Reader::Poll PN532Reader::poll()
+{
+    uint8_t frame[255]; // PN532_ReadFrame copies as much as the frame says, up to 255
+    uint16_t length;
+    frame[0] = PN532_HOSTTOPN532;
+    if (auto_poll)
+    {
+        // PollNr endless, Period 150 ms, type 0x10 MIFARE
+        const uint8_t command[] = {PN532_COMMAND_INAUTOPOLL, 0xFF, 0x01, 0x10};
+        std::copy(std::begin(command), std::end(command), frame + 1);
+        length = 1 + sizeof(command);
+    }
+    else
+    {
+        const uint8_t command[] = {PN532_COMMAND_INLISTPASSIVETARGET, 0x01, PN532_MIFARE_ISO14443A};
+        std::copy(std::begin(command), std::end(command), frame + 1);
+        length = 1 + sizeof(command);
+    }
+    const uint8_t command = frame[1];
+
+    if (PN532_WriteFrame(&pn532, frame, length) != PN532_STATUS_OK || !pn532.wait_ready(ACK_TIMEOUT_MS))
+    {
+        return Poll::Error;
+    }
+    uint8_t ack[sizeof(ACK_FRAME)];
+    pn532.read_data(ack, sizeof(ack));
+    if (!std::equal(std::begin(ack), std::end(ack), std::begin(ACK_FRAME)))
+    {
+        return Poll::Error;
+    }
+    if (!pn532.wait_ready(CARD_WAIT_MS))
+    {
+        abort();
+        return Poll::None;
+    }
+
+    // InListPassiveTarget: NbTg, then the target. InAutoPoll: NbTg, type, length, then the same target data.
+    const int frame_len = PN532_ReadFrame(&pn532, frame, 2 + 22);
+    if (frame_len == 1 && frame[0] == 0x7F && auto_poll)
+    {
+        // Syntax error frame, the firmware doesn't know InAutoPoll
+        pn532.log("InAutoPoll not supported, polling with InListPassiveTarget");
+        auto_poll = false;
+        return Poll::None;
+    }
+    if (frame_len < 3 || frame[0] != PN532_PN532TOHOST || frame[1] != command + 1)
+    {
+        return Poll::Error;
+    }
+    if (frame[2] == 0)
+    {
+        return Poll::None;
+    }
+    const uint8_t *target = frame + (auto_poll ? 5 : 3); // Tg, SENS_RES (2), SEL_RES, NFCID length, NFCID
+    if (frame[2] != 1 || target + 5 > frame + frame_len || target[4] > 7 || target + 5 + target[4] > frame + frame_len)
+    {
+        return Poll::Error;
+    }
+    uid_len = target[4];
+    std::copy(target + 5, target + 5 + uid_len, uid);
+    return Poll::Card;
+}
+
+// Stops the command still waiting for a card, the PN532 takes an ACK frame from the host as abort
+void PN532Reader::abort()
+{
+    uint8_t ack[sizeof(ACK_FRAME)];
+    std::copy(std::begin(ACK_FRAME), std::end(ACK_FRAME), ack); // write_data takes no const
+    pn532.write_data(ack, sizeof(ack));
+}
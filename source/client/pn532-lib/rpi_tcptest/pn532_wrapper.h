@@ -10,15 +10,38 @@ extern "C"
 
 class PN532Reader{
 public:
-    PN532Reader(); 
+    // The reader on I2C bus /dev/i2c-<bus>
+    explicit PN532Reader(int bus = 1); 
     bool init_pn532();
     bool isInitialized() const; 
+    // Waits up to CARD_WAIT_MS for a card. Returns at once when one is on the reader, never sleeps after an empty wait.
     bool waitForScan(); 
     std::string getStringUID() const;
 
 private: 
+    enum class Poll
+    {
+        Card,
+        None,
+        Error
+    };
+
+    // The reader ACKs a command within a few ms, so a reader that stopped answering is noticed quickly
+    static constexpr uint32_t ACK_TIMEOUT_MS = 20;
+    // How long one detection command waits for a card before it is aborted and sent again
+    static constexpr uint32_t CARD_WAIT_MS = 1000;
+    // Pause after a failed command, doubled on each further failure
+    static constexpr int BACKOFF_MIN_MS = 10;
+    static constexpr int BACKOFF_MAX_MS = 1000;
+
+    Poll poll();
+    void abort();
+
     PN532 pn532;
+    int bus;
     bool setup_complete = false;
+    bool auto_poll = false; // InAutoPoll instead of InListPassiveTarget, see init_pn532()
+    int backoff_ms = 0;
 
     uint8_t uid[MIFARE_UID_MAX_LENGTH];
     int32_t uid_len = 0;
@@ -1,64 +1,84 @@
 #include "rpi_client.h"
-#include "wiringPi.h"
+#include "Hal.h"
+#include "DoorSnapshot.h"
+#include <algorithm>
 #include <chrono>
+#include <set>
 #include <unistd.h>
 #include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
+#include <errno.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <thread>
+#include <sys/epoll.h>
 
-client::client(int portno, const char *server_ip, std::string doorname) : portno(portno), server_ip(server_ip), doorname(doorname)
+client::client(int portno, const char *server_ip, const std::vector<std::string> &doornames) : portno(portno), server_ip(server_ip)
 {
-	// First wiring pi setup for physical pins.
-	if (wiringPiSetupPhys() == -1)
+	if (doornames.empty() || doornames.size() > DOOR_PINS.size() || std::set(doornames.begin(), doornames.end()).size() != doornames.size())
 	{
-		std::cerr << "WiringPi setup failed" << std::endl;
+		std::cerr << "Give 1 to " << DOOR_PINS.size() << " different door names" << std::endl;
 		exit(1);
 	}
 
-	// initialized to correct physical pins.
-	buzzer = std::make_unique<Buzzer>(21);
-	Led_Green = std::make_unique<Led>(8);
-	Led_Yellow = std::make_unique<Led>(11);
-	Led_Red = std::make_unique<Led>(10);
-	RS = std::make_unique<ReedSwitch>(35);
-
-	// Second setup RFID reader.
-	rfid_reader = std::make_unique<PN532Reader>();
+	// First hardware setup, wiringPi for physical pins or the simulation.
+	if (!hal::init())
+	{
+		std::cerr << "Hardware setup failed" << std::endl;
+		exit(1);
+	}
 
-	if (!rfid_reader->init_pn532())
+	// Second the doors, each with its pins and RFID reader.
+	const std::string key = snapshot::readKey("door.key");
+	for (size_t i = 0; i < doornames.size(); i++)
 	{
-		std::cerr << "Failed to initialize PN532" << std::endl;
+		doors.push_back(std::make_unique<Door>(doornames[i], DOOR_PINS[i], loop, actuator, key));
 	}
 
 	// initLeds();
 
-	// Third connect to server (continuous calls, until connected)
-	while ((sockfd = connect_to_server()) < 0)
-	{
-		std::cerr << "trying to connect.. 2 seconds wait.." << std::endl;
-		std::this_thread::sleep_for(std::chrono::milliseconds(2000));
-	}
+	// Third connect to server, run() starts it and reconnect() keeps it up
 }
 
 client::~client()
 {
-	close(sockfd);
+	for (const int fd : {sockfd, spare_fd, connecting_fd})
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+	}
 }
 
+// Starts a non-blocking connect, on_connect() gets the result. Returns the socket, or -1 if it failed right away.
 int client::connect_to_server()
 {
 	struct sockaddr_in serv_addr;
 
-	sockfd = socket(AF_INET, SOCK_STREAM, 0);
-	if (sockfd < 0)
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
 	{
 		perror("ERROR opening socket");
 		return -1;
 	}
 
+	// A scan is one small message, send it at once instead of holding it back for Nagle
+	int on = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	// Probe idle connections, so a server that went away is noticed between scans and not by the next one
+	int idle = 10, interval = 2, probes = 3;
+	setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+	setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+	setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+	setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &probes, sizeof(probes));
+	// Give up on a scan the server doesn't acknowledge within 5 seconds, instead of retransmitting for minutes
+	unsigned int user_timeout = 5000;
+	setsockopt(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, &user_timeout, sizeof(user_timeout));
+
 	memset(&serv_addr, 0, sizeof(serv_addr));
 	serv_addr.sin_family = AF_INET;
 	serv_addr.sin_port = htons(portno);
@@ -66,287 +86,419 @@ int client::connect_to_server()
 	if (inet_pton(AF_INET, server_ip, &serv_addr.sin_addr) <= 0)
 	{
 		perror("Error converting server ip");
+		close(fd);
 		return -1;
 	}
 
-	if (connect(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0)
+	if (connect(fd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0 && errno != EINPROGRESS)
 	{
 		perror("ERROR connecting");
+		close(fd);
 		return -1;
 	}
 
-	std::cerr << "connection established" << std::endl;
-
-	return sockfd;
+	return fd;
 }
 
-void client::send_data(const std::string &uidstring)
+// Keeps a connection for the scans and a spare one open, connecting whichever is missing.
+// The spare means a dropped connection costs no connect on the way to the next decision.
+void client::reconnect()
 {
-	std::string totalstring(doorname);
-	totalstring += ':';
-	totalstring += uidstring;
-	totalstring += '\n';
-	std::cerr << "Sending: " << totalstring << std::endl;
+	if (connecting_fd >= 0 || retry_timer != 0 || (connected && spare_fd >= 0))
+	{
+		return;
+	}
 
-	ssize_t n = write(sockfd, totalstring.c_str(), strlen(totalstring.c_str()));
-	if (n < 0)
+	connecting_fd = connect_to_server();
+	if (connecting_fd < 0)
 	{
-		perror("ERROR writing to socket");
+		retry_later();
 		return;
 	}
-	std::cerr << "Sent " << n << " bytes" << std::endl;
+	loop.watch(connecting_fd, EPOLLOUT, [this](uint32_t) { on_connect(); });
 }
 
-bool client::recieve_data()
+void client::on_connect()
 {
-	size_t total = 0;
-	ssize_t n = 0;
+	const int fd = connecting_fd;
+	connecting_fd = -1;
+	loop.unwatch(fd);
+
+	int error = 0;
+	socklen_t length = sizeof(error);
+	getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+	if (error != 0)
+	{
+		std::cerr << "ERROR connecting: " << strerror(error) << std::endl;
+		close(fd);
+		retry_later();
+		return;
+	}
+	backoff = BACKOFF_MIN;
 
-	memset(buffer_receive, 0, sizeof(buffer_receive));
-	while (total < sizeof(buffer_receive) - 1)
+	if (!connected)
 	{
-		n = read(sockfd, buffer_receive + total, 1);
-		if (n < 0)
-		{
-			perror("ERROR reading from socket");
-			return false;
-		}
+		std::cerr << "connection established" << std::endl;
+		use_connection(fd);
+	}
+	else
+	{
+		// Nothing is sent on the spare, so it only becomes readable when the server closes it
+		std::cerr << "spare connection established" << std::endl;
+		spare_fd = fd;
+		loop.watch(spare_fd, EPOLLIN, [this](uint32_t) { on_spare_closed(); });
+	}
+	reconnect();
+}
+
+void client::use_connection(int fd)
+{
+	sockfd = fd;
+	connected = true;
+	reader.reset();
+	loop.watch(sockfd, EPOLLIN, [this](uint32_t events) { on_socket(events); });
+	request_sync();
+	upload_audits();
+	reported_counts = {}; // Possibly a restarted server
+	report_suppressed();
+}
+
+// Drops the connection for the scans, carries on with the spare if there is one and connects the rest again.
+// After a server restart the spare is closed as well, it then fails on its first read and ends up here too.
+void client::connection_lost()
+{
+	loop.unwatch(sockfd);
+	close(sockfd);
+	sockfd = -1;
+	connected = false;
+	drop_outgoing();
+	watching_out = false;
+	std::deque<std::pair<Door *, std::string>> unanswered;
+	unanswered.swap(in_flight);
+
+	if (spare_fd >= 0)
+	{
+		std::cerr << "Switching to the spare connection" << std::endl;
+		const int fd = spare_fd;
+		spare_fd = -1;
+		use_connection(fd);
+	}
 
-		if (n == 0) // end of file check.
+	// Scans the server won't answer any more go out again on the spare, or are decided offline
+	for (const auto &[door, uid] : unanswered)
+	{
+		if (connected)
 		{
-			std::cerr << "Server closed connection" << std::endl;
-			return false;
+			send_data(*door, uid);
 		}
-
-		// end of line characters check.
-		if (buffer_receive[total] == '\n' || buffer_receive[total] == '\r')
+		else
 		{
-			break;
+			decide_offline(*door, uid);
 		}
-
-		total += n;
 	}
+	reconnect();
+}
 
-	buffer_receive[total] = '\0';
+void client::on_spare_closed()
+{
+	loop.unwatch(spare_fd);
+	close(spare_fd);
+	spare_fd = -1;
+	reconnect();
+}
+
+// Exponential backoff with jitter: half the backoff plus a random share of the other half,
+// so doors don't all hit a restarted server at the same moment.
+void client::retry_later()
+{
+	std::uniform_int_distribution<long> jitter(0, backoff.count() / 2);
+	const auto delay = backoff / 2 + std::chrono::milliseconds(jitter(rng));
+	backoff = std::min(backoff * 2, BACKOFF_MAX);
 
-	// Find the "%%%" delimiter
-	char *delimiter = strstr(buffer_receive, "%%%");
-	if (delimiter != nullptr)
+	std::cerr << "trying to connect.. " << delay.count() << " ms wait.." << std::endl;
+	retry_timer = loop.after(delay, [this]
 	{
-		// Skip past "%%%" (3 characters)
-		char *payload = delimiter + 3;
+		retry_timer = 0;
+		reconnect();
+	});
+}
 
-		// Move payload to start of buffer
-		size_t payload_len = strlen(payload);
-		memmove(buffer_receive, payload, payload_len + 1); // +1 for null terminator
+// Queues a whole line for sockfd and sends what the socket takes now, the rest follows on EPOLLOUT.
+// Returns false without a connection. A queued line goes out whole, or the connection is dropped with it.
+bool client::send_line(std::string line, bool audit)
+{
+	if (!connected)
+	{
+		return false;
 	}
-	// If no delimiter found, keep the buffer as-is (might be error message)
-
+	outgoing.push_back({std::move(line), audit});
+	flush_outgoing();
 	return true;
 }
 
-void client::io_feedback()
+void client::flush_outgoing()
 {
-	// std::cerr << "Buffer contains: '" << buffer_receive << "'" << std::endl;
-
-	if (strcmp(buffer_receive, "approved") == 0)
+	while (!outgoing.empty())
 	{
-		std::cerr << "GODKENDT!! velkommen :))" << std::endl;
-
-		// Yellow LED off. Green LED on.
-		Led_Yellow->off();
-		Led_Green->on();
+		const std::string &line = outgoing.front().line;
+		// MSG_NOSIGNAL: a server that went away shows up as an error here and in on_server(), not as SIGPIPE
+		const ssize_t n = send(sockfd, line.data() + outgoing_sent, line.size() - outgoing_sent, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			break; // Send buffer full, EPOLLOUT resumes
+		}
+		if (n < 0)
+		{
+			// on_server() then reads the end of the connection and drops it with what is still queued,
+			// the scans in in_flight go out again or offline
+			perror("ERROR writing to socket");
+			shutdown(sockfd, SHUT_RDWR);
+			break;
+		}
+		outgoing_sent += n;
+		if (outgoing_sent == line.size())
+		{
+			outgoing.pop_front();
+			outgoing_sent = 0;
+		}
+	}
 
-		std::cout << "RS value before going into loops: " << RS->isDoorOpen() << std::endl;
+	if (watching_out != !outgoing.empty())
+	{
+		watching_out = !outgoing.empty();
+		loop.watch(sockfd, watching_out ? EPOLLIN | EPOLLOUT : EPOLLIN, [this](uint32_t events) { on_socket(events); });
+	}
+}
 
-		auto start_door_closed = std::chrono::high_resolution_clock::now();
-		// waiting here for the user to open the door
-		while (RS->isDoorOpen())
+// Forgets what sockfd didn't take. Audits not sent whole go back to the front of audit_queue for the next connection.
+void client::drop_outgoing()
+{
+	for (auto it = outgoing.rbegin(); it != outgoing.rend(); ++it)
+	{
+		if (it->audit)
 		{
-			auto now_door_closed = std::chrono::high_resolution_clock::now();
-			auto duration_door_closed = std::chrono::duration_cast<std::chrono::seconds>(now_door_closed - start_door_closed).count();
-			if (duration_door_closed > 10) // 10 seconds
-			{
-				Led_Green->off();
-				Led_Yellow->on();
-				std::cout << "Door not opened inside 10 seconds. locking again" << std::endl;
-				return; // if door not opened in 10 seconds, return.
-			}
-			std::this_thread::sleep_for(std::chrono::milliseconds(200)); // small sleep time.
+			audit_queue.push_front(std::move(it->line));
 		}
+	}
+	outgoing.clear();
+	outgoing_sent = 0;
+}
 
-		auto start_door_open = std::chrono::high_resolution_clock::now();
+// Sends a scan and expects its reply in on_server(), in the order the scans were queued
+void client::send_data(Door &door, const std::string &uidstring)
+{
+	std::string totalstring(door.name());
+	totalstring += ':';
+	totalstring += uidstring;
+	totalstring += '\n';
+	std::cerr << "Sending: " << totalstring << std::endl;
 
-		std::cout << "Door open" << std::endl;
+	if (send_line(std::move(totalstring)))
+	{
+		in_flight.emplace_back(&door, uidstring);
+	}
+}
 
-		// Waiting here for the user to close the door
-		while (RS->isDoorClosed())
+// Asks for each door's offline cache snapshot, or what changed since the version held. The answers arrive in on_server().
+void client::request_sync()
+{
+	for (const auto &door : doors)
+	{
+		if (!connected)
 		{
-			std::cerr << "RS->isDoorClosed() = " << RS->isDoorClosed() << std::endl;
-			auto now_door_open = std::chrono::high_resolution_clock::now();
-			auto duration_door_open = std::chrono::duration_cast<std::chrono::seconds>(now_door_open - start_door_open).count();
-			if (duration_door_open > 10) // 120 seconds / 2 min.
-			{
-				Led_Green->off();
-				Led_Red->on();
-				buzzer->beep(1000); // beeps one second and sleeps one second
-				std::cout << "Door not closed inside 2 min" << std::endl;
-			}
-			std::this_thread::sleep_for(std::chrono::milliseconds(200)); // small sleep time.
+			return;
 		}
-		// Door closed, turn off green. turn on yellow.
-		Led_Green->off();
-		Led_Red->off();
-		Led_Yellow->on();
+		if (!door->cache().enabled())
+		{
+			continue;
+		}
+		send_line(door->name() + ":@sync:" + door->cache().version() + '\n');
 	}
-	else if (strcmp(buffer_receive, "denied") == 0)
-	{
-		std::cerr << "AFVIST!! øv bøv, slem slem slem :((" << std::endl;
+}
 
-		Led_Green->off();
-		Led_Yellow->off();
-		Led_Red->on();
+// Sends the offline decisions to the server, which logs them. Nothing comes back for them.
+// Hands audits to the writer only while nothing else waits in it, so scans queue behind at most one of them.
+// Carries on once the writer drains (on_socket) and after each reply (on_server) until audit_queue is empty.
+void client::upload_audits()
+{
+	while (connected && outgoing.empty() && !audit_queue.empty())
+	{
+		std::string audit = std::move(audit_queue.front());
+		audit_queue.pop_front();
+		send_line(std::move(audit), true);
+	}
+}
 
-		int i = 0;
-		while (i < 6) // blink i 3 sekunder.
+// Tells the server how many scans each reader suppressed since the client started, "doorname:@scans:<duplicates>:<limited>".
+// Only sent when the counts changed. Nothing comes back for it.
+void client::report_suppressed()
+{
+	for (const auto &door : doors)
+	{
+		const ScanFilter::Counts &counts = door->suppressed();
+		if (!connected)
+		{
+			return;
+		}
+		if (counts == reported_counts[door.get()])
 		{
-			Led_Red->blink(250);
-			i++;
+			continue;
 		}
+		send_line(door->name() + ":@scans:" + std::to_string(counts.duplicates) + ':' + std::to_string(counts.limited) + '\n');
+		reported_counts[door.get()] = counts;
+	}
+}
 
-		Led_Red->off();
-		Led_Yellow->on();
+// Decides from the offline cache while the server is unreachable and keeps the decision for upload.
+// Without a door.key there is no cache, and the scan only shows an error.
+void client::decide_offline(Door &door, const std::string &uid)
+{
+	if (!door.cache().enabled())
+	{
+		std::cerr << "Not connected, showing error" << std::endl;
+		door.show_error();
+		return;
 	}
-	else
+
+	const auto now = std::chrono::system_clock::now();
+	const std::string reply = door.cache().allows(uid, std::chrono::system_clock::to_time_t(now)) ? "approved" : "denied";
+	std::cerr << "Offline decision at " << door.name() << ": " << reply << std::endl;
+	door.feedback(reply);
+
+	const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+	audit_queue.push_back(door.name() + ":@audit:" + uid + ':' + reply + ':' + std::to_string(ms) + '\n');
+	if (audit_queue.size() > AUDIT_MAX)
 	{
-		std::cerr << "Unknown response: '" << buffer_receive << "'" << std::endl;
+		audit_queue.pop_front();
+	}
+}
 
-		Led_Red->off();
-		Led_Green->off();
+// Door state change for the server, "doorname:@open:<ms>" or "doorname:@closed:<ms>".
+// The server doesn't answer these, so they never end up in in_flight.
+void client::send_door_event(const Door &door, bool open)
+{
+	const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	std::string event(door.name());
+	event += open ? ":@open:" : ":@closed:";
+	event += std::to_string(ms);
+	event += '\n';
 
-		for (int i = 0; i < 3; i++)
+	send_line(std::move(event));
+}
+
+// Sends every card the door's poller saw since the last call, except those its scan filter suppresses. Replies come back through on_server().
+void client::on_scans(Door &door)
+{
+	for (const std::string &uid : door.take())
+	{
+		// std::cerr << "Card detected: " << uid << std::endl;
+		if (!connected)
 		{
-			Led_Yellow->off();
-			std::this_thread::sleep_for(std::chrono::milliseconds(300));
-			Led_Yellow->on();
-			std::this_thread::sleep_for(std::chrono::milliseconds(300));
+			decide_offline(door, uid);
+			// Someone is waiting at the door, try now instead of when the backoff runs out
+			loop.cancel(retry_timer);
+			retry_timer = 0;
+			backoff = BACKOFF_MIN;
+			reconnect();
+			continue;
 		}
+		send_data(door, uid);
 	}
 }
 
-void client::run()
+void client::on_socket(uint32_t events)
 {
-	enum State
+	if (events & EPOLLOUT)
 	{
-		WAIT_INPUT,
-		SEND,
-		RESPONSE,
-		FEEDBACK,
-	};
-
-	State curr_state = State::WAIT_INPUT;
+		flush_outgoing();
+		upload_audits();
+	}
+	if (events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+	{
+		on_server();
+	}
+}
 
-	// Initial LED states.
-	Led_Green->off();
-	Led_Red->off();
-	Led_Yellow->on();
+// Takes every complete reply off the socket and shows it. Partial replies stay in reader until the rest arrives.
+void client::on_server()
+{
+	const uint64_t reads_before = reader.reads();
+	if (!reader.fill(sockfd)) // in case of socket error.
+	{
+		std::cerr << "Connection lost" << std::endl;
+		connection_lost();
+		return;
+	}
 
-	std::string uid;
-	while (rfid_reader->isInitialized())
+	std::string line;
+	while (reader.nextLine(line))
 	{
-		switch (curr_state)
+		// Skip past the "type:string%%%" header. Replies without one are kept as-is (might be error message)
+		const std::string reply(LineReader::payload(line));
+		// Answers a sync request, not a scan. "@sync:<door>:..." names the door it is for.
+		if (reply.rfind("@sync:", 0) == 0)
 		{
-		case State::WAIT_INPUT:
-			std::cerr << "State: WAIT_INPUT" << std::endl;
-			if (rfid_reader->waitForScan())
+			const std::string name = reply.substr(6, reply.find(':', 6) - 6);
+			const auto door = std::find_if(doors.begin(), doors.end(), [&](const auto &d) { return d->name() == name; });
+			if (door != doors.end())
 			{
-				uid = rfid_reader->getStringUID();
-				// std::cerr << "Card detected: " << uid << std::endl;
-				curr_state = State::SEND;
+				(*door)->cache().apply(reply);
 			}
-			else
-			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(200)); // poll every 200 for uid string ms
-			}
-			break;
-
-		case State::SEND:
-			std::cerr << "State: SEND" << std::endl;
-			send_data(uid);
-			curr_state = State::RESPONSE;
-			break;
-
-		case State::RESPONSE:
+			continue;
+		}
+		std::cerr << "Received '" << reply << "' in " << reader.reads() - reads_before << " read() calls" << std::endl;
+		if (in_flight.empty())
 		{
-			std::cerr << "State: RESPONSE" << std::endl;
-			if (recieve_data())
-			{
-				curr_state = State::FEEDBACK;
-				// std::cerr << "Received data: '" << buffer_receive << "'" << std::endl;
-			}
-			else // if recieve_data returns false -> in case of socket error.
-			{
-				std::cerr << "No data received, showing error and returning to wait" << std::endl;
-
-				for (int i = 0; i < 2; i++)
-				{
-					std::cerr << "Error blink " << (i + 1) << std::endl;
-					Led_Red->on();
-					std::this_thread::sleep_for(std::chrono::milliseconds(200));
-					Led_Red->off();
-					std::this_thread::sleep_for(std::chrono::milliseconds(200));
-				}
-
-				Led_Yellow->on();
-				curr_state = State::WAIT_INPUT;
-			}
-			break;
+			std::cerr << "Reply without a scan, ignoring it" << std::endl;
+			continue;
 		}
+		Door &door = *in_flight.front().first;
+		in_flight.pop_front();
+		door.feedback(reply);
+	}
+	upload_audits();
+}
 
-		case State::FEEDBACK:
-			std::cerr << "State: FEEDBACK" << std::endl;
-			io_feedback();
-			curr_state = State::WAIT_INPUT;
-			break;
+// Runs the doors whose reader came up, returns at once if none did
+void client::run()
+{
+	bool any = false;
+	for (const auto &door : doors)
+	{
+		if (!door->ready())
+		{
+			std::cerr << "Leaving " << door->name() << " out, its reader is not set up" << std::endl;
+			continue;
 		}
+		any = true;
+
+		// Cards from the door's poller thread and edges of its reed switch, the door state goes to the server on every change
+		Door *d = door.get();
+		d->start([this, d] { on_scans(*d); }, [this, d](bool open) { send_door_event(*d, open); });
 	}
+	if (!any)
+	{
+		return;
+	}
+
+	// Replies from the server, for all doors on one connection
+	reconnect();
+	loop.every(std::chrono::seconds(30), [this]
+	{
+		request_sync();
+		report_suppressed();
+	});
+	loop.run();
 }
 
 void client::initLeds()
 {
-	std::cerr << "=== INITLEDS() START ===" << std::endl;
-	for (int i = 0; i < 2; i++)
-	{
-		printf("Cycle %d/2\n", i + 1);
-
-		printf("GREEN ON\n");
-		Led_Green->on();
-		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-		printf("GREEN OFF\n");
-		Led_Green->off();
-		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-		;
-
-		printf("YELLOW ON\n");
-		Led_Yellow->on();
-		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-		printf("YELLOW OFF\n");
-		Led_Yellow->off();
-		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
-		printf("RED ON\n");
-		Led_Red->on();
-		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-		printf("RED OFF\n");
-		Led_Red->off();
-		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
-		printf("BUZZER ON\n");
-		buzzer->beep(1000);
-		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
-		printf("REED SWITCH OPEN: %d\n", RS->isDoorOpen());
-		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-	}
-	return;
-}
+	for (const auto &door : doors)
+	{
+		door->initLeds();
+	}
+}
\ No newline at end of file
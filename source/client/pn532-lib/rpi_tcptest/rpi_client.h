@@ -1,35 +1,88 @@
 #pragma once
-#include "pn532_wrapper.h"
-#include "Buzzer.h"
-#include "Led.h"
-#include "ReedSwitch.h"
+#include "Actuator.h"
+#include "Door.h"
+#include "LineReader.h"
+#include "EventLoop.h"
+#include "ScanFilter.h"
+#include <array>
+#include <chrono>
+#include <deque>
+#include <map>
 #include <memory>
+#include <random>
+#include <utility>
+#include <vector>
 
+// Talks to the server for one or more doors over one connection. Every line names its door, so the server needs nothing new.
 class client
 {
 public:
-    client(int portno, const char *server_ip, std::string doorname);
-    ~client();
+	client(int portno, const char *server_ip, const std::vector<std::string> &doornames);
+	~client();
 
-    void run();
-    void initLeds();
+	void run();
+	void initLeds();
+
+	// Pins of the doors in the order they are named on the command line. The reader of the first door is on /dev/i2c-1
+	// with the reset and wakeup pins, a second one on /dev/i2c-3 (dtoverlay=i2c3, physical pins 7 and 29) shares them.
+	static constexpr std::array<Door::Pins, 2> DOOR_PINS{{
+		{1, 21, 8, 11, 10, 35},
+		{3, 31, 13, 15, 16, 37},
+	}};
 
 private:
-    int sockfd;
-    int portno;
-    const char *server_ip;
-    std::string doorname;
-
-    std::unique_ptr<Buzzer> buzzer;
-    std::unique_ptr<Led> Led_Green;
-    std::unique_ptr<Led> Led_Yellow;
-    std::unique_ptr<Led> Led_Red;
-    std::unique_ptr<ReedSwitch> RS;
-    std::unique_ptr<PN532Reader> rfid_reader;
-    char buffer_receive[256];
-
-    int connect_to_server();
-    void send_data(const std::string &uidstring);
-    bool recieve_data();
-    void io_feedback();
+	// Reconnect delays, doubled after each failed attempt
+	static constexpr std::chrono::milliseconds BACKOFF_MIN{200};
+	static constexpr std::chrono::milliseconds BACKOFF_MAX{10000};
+	// Offline decisions kept for upload, the oldest are dropped beyond this
+	static constexpr size_t AUDIT_MAX = 10000;
+
+	int sockfd = -1; // Connection the scans go out on, -1 while there is none
+	int portno;
+	const char *server_ip;
+	bool connected = false;
+	int spare_fd = -1;      // Second connection kept open, takes over at once when sockfd drops
+	int connecting_fd = -1; // Connect in progress
+	EventLoop::TimerId retry_timer = 0;
+	std::chrono::milliseconds backoff = BACKOFF_MIN;
+	std::mt19937 rng{std::random_device{}()};
+
+	EventLoop loop;    // Before the doors, whose reed switches unwatch themselves on it
+	Actuator actuator; // Before the doors, whose LEDs and buzzers queue their writes on it
+	std::vector<std::unique_ptr<Door>> doors;
+	LineReader reader;
+	// A line for sockfd. Audits go back to audit_queue if the connection drops before they are sent whole.
+	struct Outgoing
+	{
+		std::string line;
+		bool audit = false;
+	};
+
+	std::deque<Outgoing> outgoing;    // Lines for sockfd the socket didn't take yet, sent on EPOLLOUT
+	size_t outgoing_sent = 0;         // Bytes of the first line already sent
+	bool watching_out = false;        // sockfd is watched for EPOLLOUT as well
+	std::deque<std::pair<Door *, std::string>> in_flight; // Scans queued whole and not answered yet, the server answers in order
+	std::deque<std::string> audit_queue;                  // Offline decisions of all doors, uploaded once connected
+	std::map<const Door *, ScanFilter::Counts> reported_counts; // Suppressed scans the server was last told about
+
+	int connect_to_server();
+	void reconnect();
+	void on_connect();
+	void use_connection(int fd);
+	void connection_lost();
+	void on_spare_closed();
+	void retry_later();
+	void request_sync();
+	void upload_audits();
+	void report_suppressed();
+	void decide_offline(Door &door, const std::string &uid);
+	bool send_line(std::string line, bool audit = false);
+	void flush_outgoing();
+	void drop_outgoing();
+	void send_data(Door &door, const std::string &uidstring);
+	void send_door_event(const Door &door, bool open);
+
+	void on_scans(Door &door);
+	void on_socket(uint32_t events);
+	void on_server();
 };
\ No newline at end of file
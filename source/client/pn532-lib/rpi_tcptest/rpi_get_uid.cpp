@@ -1,4 +1,5 @@
 #include "rpi_client.h"
+#include <sstream>
 
 int main(int argc, char *argv[])
 {
@@ -9,13 +10,19 @@ int main(int argc, char *argv[])
         std::cerr << argv[i] << std::endl;
     }
 
-    std::string doorname = (argc > 1) ? argv[1] : "maindoor";
+    // One door per reader, "in,out" for two
+    std::vector<std::string> doornames;
+    std::istringstream names((argc > 1) ? argv[1] : "maindoor");
+    for (std::string name; std::getline(names, name, ',');)
+    {
+        doornames.push_back(name);
+    }
     int portno = (argc > 2) ? atoi(argv[2]) : 9000;
     const char *server_ip = (argc > 3) ? argv[3] : "172.20.10.9";
 
     try
     {
-        client rpi_client(portno, server_ip, doorname);
+        client rpi_client(portno, server_ip, doornames);
         rpi_client.run();
     }
     catch (std::exception &e)
@@ -0,0 +1,115 @@
+import os
+import select
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+# Measures how fast the door client recovers from a server outage, with the real client code.
+# Plays the server itself: answers the client's scans, then closes every connection and stops listening for a while.
+# Needs a client built with -DSIMULATED=ON, it is started with a script that presents a card every 1.5 seconds.
+# Usage: python reconnectTester.py <client binary> [outage seconds] [rounds] [port]
+
+binary = sys.argv[1] if len(sys.argv) > 1 else input("Input client binary: ").strip()
+outage = float(sys.argv[2]) if len(sys.argv) > 2 else 2.0
+rounds = int(sys.argv[3]) if len(sys.argv) > 3 else 5
+port = int(sys.argv[4]) if len(sys.argv) > 4 else 9100
+
+workdir = tempfile.mkdtemp()
+script = os.path.join(workdir, "cards.sim")
+with open(script, "w") as f:
+    f.write("1000 card 6a13ba66\n1300 remove\n1500 repeat\n")
+
+
+def listen():
+    s = socket.socket()
+    s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    s.bind(("127.0.0.1", port))
+    s.listen()
+    return s
+
+
+def serve(listener, conns, until, stop):
+    """Accepts connections and answers scans until stop(event, conn) returns True or the time is up."""
+    buffers = {}
+    while time.monotonic() < until:
+        ready, _, _ = select.select([listener] + conns, [], [], 0.05)
+        for s in ready:
+            if s is listener:
+                c, _ = listener.accept()
+                conns.append(c)
+                if stop("accept", c):
+                    return True
+                continue
+            data = s.recv(4096)
+            if not data:
+                conns.remove(s)
+                s.close()
+                continue
+            buffers[s] = buffers.get(s, b"") + data
+            while b"\n" in buffers[s]:
+                line, buffers[s] = buffers[s].split(b"\n", 1)
+                if b":@" in line:
+                    continue  # Door event, not answered
+                s.sendall(b"type:string%%%approved\n")
+                if stop("scan", s):
+                    return True
+    return False
+
+
+def close_all(conns):
+    for c in conns:
+        c.close()
+    conns.clear()
+
+
+listener = listen()
+log = open(os.path.join(workdir, "client.log"), "w")
+client = subprocess.Popen([binary, "maindoor", str(port), "127.0.0.1"], env=dict(os.environ, SIM_SCRIPT=script), stdout=log, stderr=log)
+conns = []
+try:
+    if not serve(listener, conns, time.monotonic() + 10, lambda event, c: event == "scan"):
+        sys.exit("No scan from the client, see " + log.name)
+
+    # A dropped connection with the server still up: the spare should take over without a connect
+    time.sleep(0.5)
+    print(f"connections before the drop: {len(conns)} (scans + spare)")
+    primary = conns[0]
+    conns.remove(primary)
+    primary.close()
+    before = list(conns)
+    answered = []
+    serve(listener, conns, time.monotonic() + 5, lambda event, c: event == "scan" and answered.append(c) is None)
+    print("next scan went out on the spare:", bool(answered) and answered[0] in before)
+
+    connect_ms = []
+    decide_ms = []
+    for r in range(rounds):
+        time.sleep(0.5)
+        close_all(conns)
+        listener.close()
+        time.sleep(outage)
+
+        listener = listen()
+        start = time.monotonic()
+        first = {}
+
+        def stop(event, c):
+            first.setdefault(event, time.monotonic())
+            return event == "scan"
+
+        if not serve(listener, conns, start + 30, stop):
+            sys.exit(f"Client did not come back within 30 seconds, see {log.name}")
+        connect_ms.append((first["accept"] - start) * 1000)
+        decide_ms.append((first["scan"] - start) * 1000)
+        print(f"round {r + 1}: connected after {connect_ms[-1]:.0f} ms, first decision after {decide_ms[-1]:.0f} ms")
+
+    print(f"\n{outage} s outages, {rounds} rounds")
+    print(f"time to reconnect  min {min(connect_ms):.0f} ms, mean {sum(connect_ms) / rounds:.0f} ms, max {max(connect_ms):.0f} ms")
+    print(f"time to decision   min {min(decide_ms):.0f} ms, mean {sum(decide_ms) / rounds:.0f} ms, max {max(decide_ms):.0f} ms (cards come every 1.5 s)")
+finally:
+    client.terminate()
+    client.wait()
+    close_all(conns)
+    listener.close()
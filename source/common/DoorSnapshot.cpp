@@ -0,0 +1,66 @@
+#include "DoorSnapshot.h"
+#include "Hmac.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace snapshot {
+
+std::string version(const std::vector<std::string> &entries) {
+    std::string joined;
+    for (const std::string &entry : entries) {
+        if (!joined.empty())
+            joined += ',';
+        joined += entry;
+    }
+    const auto digest = hmac::sha256(joined);
+    return hmac::hex(digest.data(), 8);
+}
+
+std::string encode(const Message &message, std::string_view key) {
+    std::string out = "@sync:" + message.door + ':' + std::to_string(message.time) + ':' + message.base + ':' + message.version + ':' + message.entries;
+    out += ':' + hmac::sign(key, out);
+    return out;
+}
+
+bool decode(std::string_view payload, std::string_view key, Message &message) {
+    const size_t signature = payload.rfind(':');
+    if (payload.rfind("@sync:", 0) != 0 || signature == std::string_view::npos ||
+        !hmac::verify(key, payload.substr(0, signature), payload.substr(signature + 1)))
+        return false;
+
+    // Five fields between "@sync:" and the signature, only the last one may contain more than a word
+    std::string_view rest = payload.substr(6, signature - 6);
+    std::string_view fields[4];
+    for (std::string_view &field : fields) {
+        const size_t colon = rest.find(':');
+        if (colon == std::string_view::npos)
+            return false;
+        field = rest.substr(0, colon);
+        rest.remove_prefix(colon + 1);
+    }
+
+    message.door = fields[0];
+    try {
+        message.time = std::stoll(std::string(fields[1]));
+    } catch (const std::exception &) {
+        return false;
+    }
+    message.base = fields[2];
+    message.version = fields[3];
+    message.entries = rest;
+    return true;
+}
+
+std::string readKey(const std::string &path) {
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string key = contents.str();
+    const size_t first = key.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos)
+        return "";
+    return key.substr(first, key.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+} // namespace snapshot
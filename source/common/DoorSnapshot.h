@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Wire format of the per-door access snapshots the server sends to the door clients for their offline cache:
+//   @sync:<door>:<time>:<base>:<version>:<entries>:<hmac>
+// entries is a comma separated list of "uid" or "uid=expires" (Unix time of a visitor badge).
+// With base "0" it is the full sorted list, otherwise a delta against version base of "+entry" and "-uid" items.
+// version is the first 16 hex digits of the SHA-256 of the full sorted list joined by commas, so both sides agree on it without a counter.
+// time is the server clock in seconds and hmac the HMAC-SHA256 of everything before it, keyed with the shared door.key.
+namespace snapshot {
+
+struct Message {
+    std::string door;
+    int64_t time = 0;
+    std::string base;
+    std::string version;
+    std::string entries;
+};
+
+// entries sorted.
+std::string version(const std::vector<std::string> &entries);
+
+std::string encode(const Message &message, std::string_view key);
+
+// Returns false if the payload is malformed or not signed with key.
+bool decode(std::string_view payload, std::string_view key, Message &message);
+
+// The key file with surrounding whitespace removed, empty if there is none.
+std::string readKey(const std::string &path);
+
+} // namespace snapshot
@@ -0,0 +1,155 @@
+#include "Hmac.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace hmac {
+
+namespace {
+
+constexpr uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+class Sha256 {
+public:
+    void update(const uint8_t *data, size_t length) {
+        total += length;
+        while (length > 0) {
+            const size_t n = std::min(length, sizeof(block) - used);
+            memcpy(block + used, data, n);
+            used += n;
+            data += n;
+            length -= n;
+            if (used == sizeof(block)) {
+                compress();
+                used = 0;
+            }
+        }
+    }
+
+    void update(std::string_view data) { update(reinterpret_cast<const uint8_t *>(data.data()), data.size()); }
+
+    std::array<uint8_t, 32> finish() {
+        const uint64_t bits = total * 8;
+        const uint8_t one = 0x80;
+        update(&one, 1);
+        const uint8_t zero = 0;
+        while (used != 56)
+            update(&zero, 1);
+        uint8_t length[8];
+        for (int i = 0; i < 8; i++)
+            length[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+        update(length, 8);
+
+        std::array<uint8_t, 32> digest;
+        for (int i = 0; i < 32; i++)
+            digest[i] = static_cast<uint8_t>(state[i / 4] >> (24 - 8 * (i % 4)));
+        return digest;
+    }
+
+private:
+    void compress() {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++)
+            w[i] = uint32_t(block[4 * i]) << 24 | uint32_t(block[4 * i + 1]) << 16 | uint32_t(block[4 * i + 2]) << 8 | block[4 * i + 3];
+        for (int i = 16; i < 64; i++) {
+            const uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+    uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    uint8_t block[64];
+    size_t used = 0;
+    uint64_t total = 0;
+};
+
+} // namespace
+
+std::array<uint8_t, 32> sha256(std::string_view data) {
+    Sha256 sha;
+    sha.update(data);
+    return sha.finish();
+}
+
+std::string sign(std::string_view key, std::string_view message) {
+    // Keys longer than a block are hashed first, shorter ones padded with zeros
+    uint8_t block[64] = {};
+    if (key.size() > sizeof(block)) {
+        const auto digest = sha256(key);
+        memcpy(block, digest.data(), digest.size());
+    } else {
+        memcpy(block, key.data(), key.size());
+    }
+
+    uint8_t pad[64];
+    for (int i = 0; i < 64; i++)
+        pad[i] = block[i] ^ 0x36;
+    Sha256 inner;
+    inner.update(pad, sizeof(pad));
+    inner.update(message);
+    const auto innerDigest = inner.finish();
+
+    for (int i = 0; i < 64; i++)
+        pad[i] = block[i] ^ 0x5c;
+    Sha256 outer;
+    outer.update(pad, sizeof(pad));
+    outer.update(innerDigest.data(), innerDigest.size());
+    const auto digest = outer.finish();
+    return hex(digest.data(), digest.size());
+}
+
+bool verify(std::string_view key, std::string_view message, std::string_view signature) {
+    const std::string expected = sign(key, message);
+    if (signature.size() != expected.size())
+        return false;
+    uint8_t diff = 0;
+    for (size_t i = 0; i < expected.size(); i++)
+        diff |= static_cast<uint8_t>(expected[i] ^ signature[i]);
+    return diff == 0;
+}
+
+std::string hex(const uint8_t *data, size_t length) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out(length * 2, '0');
+    for (size_t i = 0; i < length; i++) {
+        out[2 * i] = digits[data[i] >> 4];
+        out[2 * i + 1] = digits[data[i] & 0xf];
+    }
+    return out;
+}
+
+} // namespace hmac
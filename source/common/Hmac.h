@@ -0,0 +1,20 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// SHA-256 (FIPS 180-4) and HMAC-SHA256 (RFC 2104), shared by the server that signs the door snapshots and the clients that check them.
+namespace hmac {
+
+std::array<uint8_t, 32> sha256(std::string_view data);
+
+// Lowercase hex of HMAC-SHA256(key, message).
+std::string sign(std::string_view key, std::string_view message);
+
+// Compares in constant time, so a forged signature can't be found byte by byte.
+bool verify(std::string_view key, std::string_view message, std::string_view signature);
+
+std::string hex(const uint8_t *data, size_t length);
+
+} // namespace hmac
@@ -0,0 +1,74 @@
+#include "LineReader.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+LineReader::LineReader(size_t chunk) : buffer(chunk) {}
+
+void LineReader::reset() {
+    begin = 0;
+    end = 0;
+}
+
+bool LineReader::readLine(int fd, std::string &line) {
+    while (!nextLine(line)) {
+        if (!fill(fd))
+            return false;
+    }
+    return true;
+}
+
+bool LineReader::fill(int fd) {
+    // Move a partial message to the front, and grow the buffer if it fills all of it
+    if (begin > 0) {
+        memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    if (end == buffer.size())
+        buffer.resize(buffer.size() * 2);
+
+    ssize_t n;
+    do {
+        n = read(fd, buffer.data() + end, buffer.size() - end);
+        ++readCalls;
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return true;
+        perror("ERROR reading from socket");
+        return false;
+    }
+    if (n == 0) {
+        std::cerr << "Server closed connection" << std::endl;
+        return false;
+    }
+    end += static_cast<size_t>(n);
+    return true;
+}
+
+bool LineReader::nextLine(std::string &line) {
+    const char *start = buffer.data() + begin;
+    const char *newline = static_cast<const char *>(memchr(start, '\n', end - begin));
+    if (!newline)
+        return false;
+
+    line.assign(start, newline);
+    begin += newline - start + 1;
+    if (begin == end) {
+        begin = 0;
+        end = 0;
+    }
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+    return true;
+}
+
+std::string_view LineReader::payload(std::string_view line) {
+    const size_t delimiter = line.find("%%%");
+    return delimiter == std::string_view::npos ? line : line.substr(delimiter + 3);
+}
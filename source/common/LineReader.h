@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Buffered reader for the newline terminated messages of the server, shared by the client and the CLI.
+// Reads the socket in chunks and keeps whatever follows a message for the next call,
+// so a reply costs one read() instead of one per byte. The buffer grows for messages longer than the chunk.
+class LineReader {
+public:
+    explicit LineReader(size_t chunk = 4096);
+
+    // Forgets buffered bytes, e.g. after reconnecting.
+    void reset();
+
+    // Reads up to the next '\n' into line, without it and without a trailing '\r'.
+    // Returns false if the socket failed or was closed first.
+    bool readLine(int fd, std::string &line);
+
+    // For event loops: fill() reads what the socket has with a single read(), nextLine() takes complete messages out of the buffer.
+    // fill() returns false if the socket failed or was closed, and true without reading anything on EAGAIN.
+    bool fill(int fd);
+    bool nextLine(std::string &line);
+
+    // True if bytes of a further message are already buffered, and readLine won't need the socket to start on it.
+    bool buffered() const { return begin < end; }
+
+    // Number of read() calls so far.
+    uint64_t reads() const { return readCalls; }
+
+    // The part after the first "%%%", i.e. without the "type:string" header. The whole line if there is none.
+    static std::string_view payload(std::string_view line);
+
+private:
+    std::vector<char> buffer;
+    size_t begin = 0;
+    size_t end = 0;
+    uint64_t readCalls = 0;
+};